@@ -86,6 +86,8 @@ typedef cl_uint             cl_kernel_work_group_info;
 typedef cl_uint             cl_event_info;
 typedef cl_uint             cl_command_type;
 typedef cl_uint             cl_profiling_info;
+typedef intptr_t            cl_device_partition_property;       /* OpenCL 1.2 */
+typedef cl_bitfield         cl_device_affinity_domain;          /* OpenCL 1.2 */
 
 typedef struct _cl_image_format {
     cl_channel_order        image_channel_order;
@@ -116,6 +118,7 @@ typedef struct _cl_buffer_region {
 #define CL_MAP_FAILURE                              -12
 #define CL_MISALIGNED_SUB_BUFFER_OFFSET             -13
 #define CL_EXEC_STATUS_ERROR_FOR_EVENTS_IN_WAIT_LIST -14
+#define CL_DEVICE_PARTITION_FAILED                  -18     /* OpenCL 1.2 */
 
 #define CL_INVALID_VALUE                            -30
 #define CL_INVALID_DEVICE_TYPE                      -31
@@ -152,6 +155,7 @@ typedef struct _cl_buffer_region {
 #define CL_INVALID_MIP_LEVEL                        -62
 #define CL_INVALID_GLOBAL_WORK_SIZE                 -63
 #define CL_INVALID_PROPERTY                         -64
+#define CL_INVALID_DEVICE_PARTITION_COUNT           -68     /* OpenCL 1.2 */
 
 /* OpenCL Version */
 #define CL_VERSION_1_0                              1
@@ -239,6 +243,27 @@ typedef struct _cl_buffer_region {
 #define CL_DEVICE_NATIVE_VECTOR_WIDTH_HALF          0x103C
 #define CL_DEVICE_OPENCL_C_VERSION                  0x103D
 
+/* cl_device_info - OpenCL 1.2 device partitioning */
+#define CL_DEVICE_PARENT_DEVICE                     0x1042
+#define CL_DEVICE_PARTITION_MAX_SUB_DEVICES         0x1043
+#define CL_DEVICE_PARTITION_PROPERTIES              0x1044
+#define CL_DEVICE_PARTITION_AFFINITY_DOMAIN         0x1045
+#define CL_DEVICE_PARTITION_TYPE                    0x1046
+
+/* cl_device_partition_property - OpenCL 1.2 */
+#define CL_DEVICE_PARTITION_EQUALLY                 0x1086
+#define CL_DEVICE_PARTITION_BY_COUNTS               0x1087
+#define CL_DEVICE_PARTITION_BY_COUNTS_LIST_END      0x0
+#define CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN      0x1088
+
+/* cl_device_affinity_domain - OpenCL 1.2 */
+#define CL_DEVICE_AFFINITY_DOMAIN_NUMA                      (1 << 0)
+#define CL_DEVICE_AFFINITY_DOMAIN_L4_CACHE                  (1 << 1)
+#define CL_DEVICE_AFFINITY_DOMAIN_L3_CACHE                  (1 << 2)
+#define CL_DEVICE_AFFINITY_DOMAIN_L2_CACHE                  (1 << 3)
+#define CL_DEVICE_AFFINITY_DOMAIN_L1_CACHE                  (1 << 4)
+#define CL_DEVICE_AFFINITY_DOMAIN_NEXT_PARTITIONABLE        (1 << 5)
+
 /* cl_device_fp_config - bitfield */
 #define CL_FP_DENORM                                (1 << 0)
 #define CL_FP_INF_NAN                               (1 << 1)
@@ -476,6 +501,20 @@ clGetDeviceInfo(cl_device_id    /* device */,
                 void *          /* param_value */,
                 size_t *        /* param_value_size_ret */) CL_API_SUFFIX__VERSION_1_0;
 
+/* OpenCL 1.2 - loaded by libclew only if the driver provides it, otherwise returns CL_INVALID_OPERATION */
+extern CL_API_ENTRY cl_int CL_API_CALL
+clCreateSubDevices(cl_device_id                         /* in_device */,
+                   const cl_device_partition_property * /* properties */,
+                   cl_uint                              /* num_devices */,
+                   cl_device_id *                       /* out_devices */,
+                   cl_uint *                            /* num_devices_ret */) CL_API_SUFFIX__VERSION_1_2;
+
+extern CL_API_ENTRY cl_int CL_API_CALL
+clRetainDevice(cl_device_id /* device */) CL_API_SUFFIX__VERSION_1_2;
+
+extern CL_API_ENTRY cl_int CL_API_CALL
+clReleaseDevice(cl_device_id /* device */) CL_API_SUFFIX__VERSION_1_2;
+
 /* Context APIs  */
 extern CL_API_ENTRY cl_context CL_API_CALL
 clCreateContext(const cl_context_properties * /* properties */,
@@ -53,6 +53,9 @@ typedef cl_int				(CL_API_ENTRY CL_API_CALL * p_pfn_clGetPlatformInfo)			(cl_pla
 
 typedef cl_int				(CL_API_ENTRY CL_API_CALL * p_pfn_clGetDeviceIDs)				(cl_platform_id, cl_device_type, cl_uint, cl_device_id *, cl_uint *);
 typedef cl_int				(CL_API_ENTRY CL_API_CALL * p_pfn_clGetDeviceInfo)				(cl_device_id, cl_device_info, size_t, void *, size_t *);
+typedef cl_int				(CL_API_ENTRY CL_API_CALL * p_pfn_clCreateSubDevices)			(cl_device_id, const cl_device_partition_property *, cl_uint, cl_device_id *, cl_uint *);
+typedef cl_int				(CL_API_ENTRY CL_API_CALL * p_pfn_clRetainDevice)				(cl_device_id);
+typedef cl_int				(CL_API_ENTRY CL_API_CALL * p_pfn_clReleaseDevice)				(cl_device_id);
 
 // Context APIs  
 
@@ -162,6 +165,9 @@ p_pfn_clGetPlatformIDs				pfn_clGetPlatformIDs				= 0;
 p_pfn_clGetPlatformInfo				pfn_clGetPlatformInfo				= 0;
 p_pfn_clGetDeviceIDs				pfn_clGetDeviceIDs					= 0;
 p_pfn_clGetDeviceInfo				pfn_clGetDeviceInfo					= 0;
+p_pfn_clCreateSubDevices			pfn_clCreateSubDevices				= 0;
+p_pfn_clRetainDevice				pfn_clRetainDevice					= 0;
+p_pfn_clReleaseDevice				pfn_clReleaseDevice					= 0;
 p_pfn_clCreateContext				pfn_clCreateContext					= 0;
 p_pfn_clCreateContextFromType		pfn_clCreateContextFromType			= 0;
 p_pfn_clRetainContext				pfn_clRetainContext					= 0;
@@ -238,6 +244,10 @@ int ocl_init(void)
 	pfn_clGetPlatformInfo				= (p_pfn_clGetPlatformInfo)				oclGetProcAddress(lib, "clGetPlatformInfo");
 	pfn_clGetDeviceIDs					= (p_pfn_clGetDeviceIDs)				oclGetProcAddress(lib, "clGetDeviceIDs");
 	pfn_clGetDeviceInfo					= (p_pfn_clGetDeviceInfo)				oclGetProcAddress(lib, "clGetDeviceInfo");
+	// OpenCL 1.2, null with OpenCL 1.1 ICD loaders
+	pfn_clCreateSubDevices				= (p_pfn_clCreateSubDevices)			oclGetProcAddress(lib, "clCreateSubDevices");
+	pfn_clRetainDevice					= (p_pfn_clRetainDevice)				oclGetProcAddress(lib, "clRetainDevice");
+	pfn_clReleaseDevice					= (p_pfn_clReleaseDevice)				oclGetProcAddress(lib, "clReleaseDevice");
 	pfn_clCreateContext					= (p_pfn_clCreateContext)				oclGetProcAddress(lib, "clCreateContext");
 	pfn_clCreateContextFromType			= (p_pfn_clCreateContextFromType)		oclGetProcAddress(lib, "clCreateContextFromType");
 	pfn_clRetainContext					= (p_pfn_clRetainContext)				oclGetProcAddress(lib, "clRetainContext");
@@ -354,6 +364,34 @@ clGetDeviceInfo(cl_device_id    device,
 	return pfn_clGetDeviceInfo(device, param_name, param_value_size, param_value, param_value_size_ret);
 }
 
+extern CL_API_ENTRY cl_int CL_API_CALL
+clCreateSubDevices(cl_device_id                         in_device,
+                   const cl_device_partition_property * properties,
+                   cl_uint                              num_devices,
+                   cl_device_id *                       out_devices,
+                   cl_uint *                            num_devices_ret) CL_API_SUFFIX__VERSION_1_2
+{
+	if (!pfn_clCreateSubDevices) return CL_INVALID_OPERATION;
+
+	return pfn_clCreateSubDevices(in_device, properties, num_devices, out_devices, num_devices_ret);
+}
+
+extern CL_API_ENTRY cl_int CL_API_CALL
+clRetainDevice(cl_device_id device) CL_API_SUFFIX__VERSION_1_2
+{
+	if (!pfn_clRetainDevice) return CL_INVALID_OPERATION;
+
+	return pfn_clRetainDevice(device);
+}
+
+extern CL_API_ENTRY cl_int CL_API_CALL
+clReleaseDevice(cl_device_id device) CL_API_SUFFIX__VERSION_1_2
+{
+	if (!pfn_clReleaseDevice) return CL_INVALID_OPERATION;
+
+	return pfn_clReleaseDevice(device);
+}
+
 // Context APIs  
 extern CL_API_ENTRY cl_context CL_API_CALL
 clCreateContext(const cl_context_properties * properties,
@@ -0,0 +1,113 @@
+#include "cg.h"
+#include "context.h"
+#include "work_size.h"
+
+#include <libgpu/opencl/program_cache.h>
+#include <libutils/string_utils.h>
+
+#include "opencl/cl/cg_cl.h"
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+namespace gpu {
+
+// At most 256 groups of 256 work items, so that every kernel can sum partial dot products of the previous one by itself
+static const unsigned int cg_workgroup_size	= 256;
+static const unsigned int cg_max_groups		= 256;
+
+static ocl::ProgramCache cg_programs(cg_kernel, cg_kernel_length, "cg");
+
+template <typename T>
+static double sumPartials(const shared_device_buffer_typed<T> &partials, unsigned int npartials)
+{
+	std::vector<T> values(npartials);
+	partials.readN(values.data(), npartials);
+	double sum = 0.0;
+	for (unsigned int i = 0; i < npartials; ++i)
+		sum += values[i];
+	return sum;
+}
+
+template <typename T>
+CgResult conjugateGradient(const CsrMatrix<T> &a, const shared_device_buffer_typed<T> &b, shared_device_buffer_typed<T> &x,
+						   double tolerance, unsigned int max_iterations)
+{
+	const unsigned int n = a.rows();
+	if (a.columns() != n)
+		throw gpu_exception("Conjugate gradient needs square matrix, but it is " + to_string(n) + "x" + to_string(a.columns()) + "!");
+	if (b.number() < n)
+		throw gpu_exception("Right hand side has " + to_string(b.number()) + " elements instead of " + to_string(n) + "!");
+
+	CgResult result;
+	result.iterations = 0;
+	result.relative_residual = 0.0;
+	result.converged = true;
+	if (n == 0)
+		return result;
+
+	if (x.number() < n) {
+		std::vector<T> zeros(n, 0);
+		x.resizeN(n);
+		x.writeN(zeros.data(), n);
+	}
+
+	std::string defines = ocl::typeDefines<T>() + " -D WORKGROUP_SIZE=" + to_string(cg_workgroup_size);
+	ocl::KernelSource &dot			= cg_programs.kernel("cg_dot", defines);
+	ocl::KernelSource &update		= cg_programs.kernel("cg_update", defines);
+	ocl::KernelSource &direction	= cg_programs.kernel("cg_direction", defines);
+
+	const unsigned int ngroups = std::min(divup(n, cg_workgroup_size), cg_max_groups);
+	const WorkSize ws(cg_workgroup_size, ngroups * cg_workgroup_size);
+
+	shared_device_buffer_typed<T> inverse_diagonal	= shared_device_buffer_typed<T>::createN(n);
+	shared_device_buffer_typed<T> r					= shared_device_buffer_typed<T>::createN(n);
+	shared_device_buffer_typed<T> z					= shared_device_buffer_typed<T>::createN(n);
+	shared_device_buffer_typed<T> p					= shared_device_buffer_typed<T>::createN(n);
+	shared_device_buffer_typed<T> q					= shared_device_buffer_typed<T>::createN(n);
+	// r * z of the previous and of the current iteration are swapped every iteration
+	shared_device_buffer_typed<T> rz_partials		= shared_device_buffer_typed<T>::createN(ngroups);
+	shared_device_buffer_typed<T> new_rz_partials	= shared_device_buffer_typed<T>::createN(ngroups);
+	shared_device_buffer_typed<T> pq_partials		= shared_device_buffer_typed<T>::createN(ngroups);
+	shared_device_buffer_typed<T> rr_partials		= shared_device_buffer_typed<T>::createN(ngroups);
+	shared_device_buffer_typed<T> rr				= shared_device_buffer_typed<T>::createN(1);
+
+	cg_programs.kernel("cg_inverse_diagonal", defines).exec(WorkSize(cg_workgroup_size, n),
+			a.rowOffsets(), a.columnIndices(), a.values(), n, inverse_diagonal);
+
+	dot.exec(ws, b, b, n, pq_partials);
+	double b_norm = std::sqrt(sumPartials(pq_partials, ngroups));
+	double threshold = tolerance * (b_norm > 0.0 ? b_norm : 1.0);
+
+	a.multiply(x, r);
+	cg_programs.kernel("cg_init", defines).exec(ws, b, inverse_diagonal, r, z, p, n, rz_partials, rr_partials);
+	double residual = std::sqrt(sumPartials(rr_partials, ngroups));
+
+	while (residual > threshold && result.iterations < max_iterations) {
+		a.multiply(p, q);
+		dot.exec(ws, p, q, n, pq_partials);
+		update.exec(ws, x, r, z, p, q, inverse_diagonal, n, ngroups, rz_partials, pq_partials, new_rz_partials, rr_partials);
+		direction.exec(ws, p, z, n, ngroups, rz_partials, new_rz_partials, rr_partials, rr);
+		rz_partials.swap(new_rz_partials);
+		++result.iterations;
+
+		T rr_value;
+		rr.readN(&rr_value, 1);
+		residual = std::sqrt((double) rr_value);
+		// breakdown (e.g. matrix is not positive definite)
+		if (!(residual == residual))
+			break;
+	}
+
+	result.relative_residual = residual / (b_norm > 0.0 ? b_norm : 1.0);
+	result.converged = residual <= threshold;
+	return result;
+}
+
+template CgResult conjugateGradient<float>(const CsrMatrix<float> &a, const shared_device_buffer_typed<float> &b, shared_device_buffer_typed<float> &x,
+										   double tolerance, unsigned int max_iterations);
+template CgResult conjugateGradient<double>(const CsrMatrix<double> &a, const shared_device_buffer_typed<double> &b, shared_device_buffer_typed<double> &x,
+											double tolerance, unsigned int max_iterations);
+
+}
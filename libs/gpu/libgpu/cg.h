@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <libgpu/csr_matrix.h>
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+struct CgResult {
+	unsigned int	iterations;
+	// ||b - A * x|| / ||b|| after the last iteration
+	double			relative_residual;
+	bool			converged;
+};
+
+// Solves A * x = b for symmetric positive definite A with Jacobi-preconditioned conjugate gradient with the active context,
+// T is float or double. x is the initial guess (x = 0 if it has less than A.rows() elements) and the result.
+// Iterations stop when ||b - A * x|| <= tolerance * ||b|| or after max_iterations. All vectors stay on device:
+// every iteration is SpMV and three kernels that fuse the vector updates with dot products, scalars of the method are
+// computed on device, and only the residual norm is read back to host once per iteration.
+template <typename T>
+CgResult conjugateGradient(const CsrMatrix<T> &a, const shared_device_buffer_typed<T> &b, shared_device_buffer_typed<T> &x,
+						   double tolerance = 1e-6, unsigned int max_iterations = 1000);
+
+}
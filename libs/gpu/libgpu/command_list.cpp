@@ -0,0 +1,233 @@
+#include "command_list.h"
+#include "context.h"
+
+#include <libutils/string_utils.h>
+
+namespace gpu {
+
+void CommandList::RecordedArg::assign(const Arg &arg)
+{
+	is_null		= arg.is_null;
+	is_local	= !arg.is_null && arg.value == NULL;
+	size		= arg.size;
+
+	if (!is_null && !is_local) {
+		const unsigned char *bytes = (const unsigned char *) arg.value;
+		value.assign(bytes, bytes + size);
+	} else {
+		value.clear();
+	}
+
+	if (arg.buffer) {
+		buffer = *arg.buffer;
+	} else {
+		buffer.reset();
+	}
+}
+
+CommandList::Command::Command()
+{
+	type		= CommandKernel;
+	kernel		= NULL;
+	host_src	= NULL;
+	host_dst	= NULL;
+	size		= 0;
+	for (int d = 0; d < 3; ++d) {
+		global_work_size[d]	= 1;
+		local_work_size[d]	= 1;
+	}
+}
+
+CommandList::CommandList()
+{
+}
+
+ocl::OpenCLEngine *CommandList::engine()
+{
+	Context context;
+	if (context.type() != Context::TypeOpenCL)
+		throw gpu_exception("Command lists are supported only for OpenCL context!");
+
+	ocl::sh_ptr_ocl_engine cl = context.cl();
+	if (!engine_) {
+		engine_ = cl;
+	} else if (engine_ != cl) {
+		throw gpu_exception("All commands of a command list should be recorded with the same GPU context!");
+	}
+
+	return engine_.get();
+}
+
+CommandList::Command &CommandList::command(size_t index, CommandType type)
+{
+	if (index >= commands_.size())
+		throw gpu_exception("No command #" + to_string(index) + " in command list of size " + to_string(commands_.size()) + "!");
+	if (commands_[index].type != type)
+		throw gpu_exception("Command #" + to_string(index) + " has unexpected type!");
+	return commands_[index];
+}
+
+void CommandList::checkWorkSize(Command &command)
+{
+	engine_->checkNDRange(*command.kernel->getKernel(engine_), 3, command.global_work_size, command.local_work_size);
+}
+
+size_t CommandList::exec(ocl::KernelSource &kernel, const WorkSize &ws, const Arg &arg0, const Arg &arg1, const Arg &arg2, const Arg &arg3, const Arg &arg4, const Arg &arg5, const Arg &arg6, const Arg &arg7, const Arg &arg8, const Arg &arg9, const Arg &arg10, const Arg &arg11, const Arg &arg12, const Arg &arg13, const Arg &arg14, const Arg &arg15, const Arg &arg16, const Arg &arg17, const Arg &arg18, const Arg &arg19, const Arg &arg20, const Arg &arg21, const Arg &arg22, const Arg &arg23, const Arg &arg24, const Arg &arg25, const Arg &arg26, const Arg &arg27, const Arg &arg28, const Arg &arg29, const Arg &arg30, const Arg &arg31, const Arg &arg32, const Arg &arg33, const Arg &arg34, const Arg &arg35, const Arg &arg36, const Arg &arg37, const Arg &arg38, const Arg &arg39, const Arg &arg40)
+{
+	const Arg *args[] = { &arg0, &arg1, &arg2, &arg3, &arg4, &arg5, &arg6, &arg7, &arg8, &arg9, &arg10, &arg11, &arg12, &arg13, &arg14, &arg15, &arg16, &arg17, &arg18, &arg19, &arg20, &arg21, &arg22, &arg23, &arg24, &arg25, &arg26, &arg27, &arg28, &arg29, &arg30, &arg31, &arg32, &arg33, &arg34, &arg35, &arg36, &arg37, &arg38, &arg39, &arg40 };
+	const size_t nargs_max = sizeof(args) / sizeof(args[0]);
+
+	engine();
+
+	Command command;
+	command.type	= CommandKernel;
+	command.kernel	= &kernel;
+	for (int d = 0; d < 3; ++d) {
+		command.global_work_size[d]	= ws.clGlobalSize()[d];
+		command.local_work_size[d]	= ws.clLocalSize()[d];
+	}
+	checkWorkSize(command);
+
+	size_t nargs = nargs_max;
+	while (nargs > 0 && args[nargs - 1]->is_null)
+		--nargs;
+
+	command.args.resize(nargs);
+	for (size_t i = 0; i < nargs; ++i)
+		command.args[i].assign(*args[i]);
+
+	commands_.push_back(command);
+	return commands_.size() - 1;
+}
+
+size_t CommandList::copyTo(const shared_device_buffer &src, shared_device_buffer &dst, size_t size)
+{
+	if (size > src.size())
+		throw gpu_exception("Not enough data in this device buffer: " + to_string(size) + " > " + to_string(src.size()));
+	if (size > dst.size())
+		throw gpu_exception("Too many data for this device buffer: " + to_string(size) + " > " + to_string(dst.size()));
+
+	engine();
+
+	Command command;
+	command.type	= CommandCopy;
+	command.src		= src;
+	command.dst		= dst;
+	command.size	= size;
+
+	commands_.push_back(command);
+	return commands_.size() - 1;
+}
+
+size_t CommandList::write(shared_device_buffer &dst, const void *data, size_t size)
+{
+	if (size > dst.size())
+		throw gpu_exception("Too many data for this device buffer: " + to_string(size) + " > " + to_string(dst.size()));
+
+	engine();
+
+	Command command;
+	command.type		= CommandWrite;
+	command.dst			= dst;
+	command.host_src	= data;
+	command.size		= size;
+
+	commands_.push_back(command);
+	return commands_.size() - 1;
+}
+
+size_t CommandList::read(const shared_device_buffer &src, void *data, size_t size)
+{
+	if (size > src.size())
+		throw gpu_exception("Not enough data in this device buffer: " + to_string(size) + " > " + to_string(src.size()));
+
+	engine();
+
+	Command command;
+	command.type		= CommandRead;
+	command.src			= src;
+	command.host_dst	= data;
+	command.size		= size;
+
+	commands_.push_back(command);
+	return commands_.size() - 1;
+}
+
+void CommandList::setArg(size_t index, unsigned int arg_index, const Arg &arg)
+{
+	Command &cmd = command(index, CommandKernel);
+
+	if (arg_index >= cmd.args.size())
+		cmd.args.resize(arg_index + 1);
+	cmd.args[arg_index].assign(arg);
+}
+
+void CommandList::setWorkSize(size_t index, const WorkSize &ws)
+{
+	Command &cmd = command(index, CommandKernel);
+
+	for (int d = 0; d < 3; ++d) {
+		cmd.global_work_size[d]	= ws.clGlobalSize()[d];
+		cmd.local_work_size[d]	= ws.clLocalSize()[d];
+	}
+	checkWorkSize(cmd);
+}
+
+void CommandList::replay()
+{
+	if (commands_.empty())
+		return;
+
+	cl_command_queue queue = engine_->queue();
+
+	for (size_t i = 0; i < commands_.size(); ++i) {
+		Command &cmd = commands_[i];
+		cl_int err = CL_SUCCESS;
+
+		switch (cmd.type) {
+		case CommandKernel:
+		{
+			// cl_kernel of the replaying thread, so that arguments are not set on a kernel that another thread is launching
+			cl_kernel kernel = cmd.kernel->getKernel(engine_)->kernel();
+			for (size_t k = 0; k < cmd.args.size() && err == CL_SUCCESS; ++k) {
+				const RecordedArg &arg = cmd.args[k];
+				if (!arg.is_null)
+					err = clSetKernelArg(kernel, (cl_uint) k, arg.size, arg.is_local ? NULL : arg.value.data());
+			}
+			if (err == CL_SUCCESS)
+				err = clEnqueueNDRangeKernel(queue, kernel, 3, NULL, cmd.global_work_size, cmd.local_work_size, 0, NULL, NULL);
+			break;
+		}
+		case CommandCopy:
+			if (cmd.size)
+				err = clEnqueueCopyBuffer(queue, cmd.src.clmem(), cmd.dst.clmem(), cmd.src.cloffset(), cmd.dst.cloffset(), cmd.size, 0, NULL, NULL);
+			break;
+		case CommandWrite:
+			if (cmd.size)
+				err = clEnqueueWriteBuffer(queue, cmd.dst.clmem(), CL_FALSE, cmd.dst.cloffset(), cmd.size, cmd.host_src, 0, NULL, NULL);
+			break;
+		case CommandRead:
+			if (cmd.size)
+				err = clEnqueueReadBuffer(queue, cmd.src.clmem(), CL_FALSE, cmd.src.cloffset(), cmd.size, cmd.host_dst, 0, NULL, NULL);
+			break;
+		}
+
+		if (err != CL_SUCCESS) {
+			std::string name = (cmd.type == CommandKernel) ? "kernel " + cmd.kernel->name_ : "transfer";
+			ocl::reportError(err, __LINE__, "Command list #" + to_string(i) + " (" + name + "): ");
+		}
+	}
+
+	// queue is in-order, so the marker completes only after all recorded commands
+	cl_event ev = NULL;
+	OCL_SAFE_CALL(clEnqueueMarker(queue, &ev));
+	engine_->trackEvent(ev, "Command list: ");
+}
+
+void CommandList::clear()
+{
+	commands_.clear();
+	engine_.reset();
+}
+
+}
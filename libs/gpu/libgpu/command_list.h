@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <libgpu/work_size.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/opencl/engine.h>
+
+namespace gpu {
+
+// Sequence of kernel launches and buffer transfers that is recorded once and then replayed many times.
+// Work sizes are validated and argument values are captured at record time, so replay() only enqueues
+// the commands in order and waits once at the end. Recorded device buffers are kept alive by the list.
+// Arguments and work sizes of recorded launches can be patched between replays with setArg/setWorkSize.
+// Kernels are resolved at replay time for the replaying thread (every thread has its own cl_kernel, see OpenCLEngine::findKernel),
+// so a list recorded in one thread can be replayed in another one with the same context activated - but a list itself
+// should be used by one thread at a time. Recorded kernel sources should outlive the list.
+class CommandList {
+public:
+	typedef ocl::OpenCLKernel::Arg Arg;
+
+	CommandList();
+
+	size_t	exec(ocl::KernelSource &kernel, const WorkSize &ws, const Arg &arg0 = Arg(), const Arg &arg1 = Arg(), const Arg &arg2 = Arg(), const Arg &arg3 = Arg(), const Arg &arg4 = Arg(), const Arg &arg5 = Arg(), const Arg &arg6 = Arg(), const Arg &arg7 = Arg(), const Arg &arg8 = Arg(), const Arg &arg9 = Arg(), const Arg &arg10 = Arg(), const Arg &arg11 = Arg(), const Arg &arg12 = Arg(), const Arg &arg13 = Arg(), const Arg &arg14 = Arg(), const Arg &arg15 = Arg(), const Arg &arg16 = Arg(), const Arg &arg17 = Arg(), const Arg &arg18 = Arg(), const Arg &arg19 = Arg(), const Arg &arg20 = Arg(), const Arg &arg21 = Arg(), const Arg &arg22 = Arg(), const Arg &arg23 = Arg(), const Arg &arg24 = Arg(), const Arg &arg25 = Arg(), const Arg &arg26 = Arg(), const Arg &arg27 = Arg(), const Arg &arg28 = Arg(), const Arg &arg29 = Arg(), const Arg &arg30 = Arg(), const Arg &arg31 = Arg(), const Arg &arg32 = Arg(), const Arg &arg33 = Arg(), const Arg &arg34 = Arg(), const Arg &arg35 = Arg(), const Arg &arg36 = Arg(), const Arg &arg37 = Arg(), const Arg &arg38 = Arg(), const Arg &arg39 = Arg(), const Arg &arg40 = Arg());
+
+	// Host pointers passed to write/read are used during every replay, so they should stay valid while the list is used
+	size_t	copyTo(const shared_device_buffer &src, shared_device_buffer &dst, size_t size);
+	size_t	write(shared_device_buffer &dst, const void *data, size_t size);
+	size_t	read(const shared_device_buffer &src, void *data, size_t size);
+
+	void	setArg(size_t command, unsigned int index, const Arg &arg);
+	void	setWorkSize(size_t command, const WorkSize &ws);
+
+	void	replay();
+	void	clear();
+
+	size_t	size() const	{ return commands_.size();	}
+	bool	empty() const	{ return commands_.empty();	}
+
+protected:
+	enum CommandType {
+		CommandKernel,
+		CommandCopy,
+		CommandWrite,
+		CommandRead
+	};
+
+	class RecordedArg {
+	public:
+		RecordedArg() : is_null(true), is_local(false), size(0) { }
+
+		void						assign(const Arg &arg);
+
+		bool						is_null;
+		bool						is_local;
+		size_t						size;
+		std::vector<unsigned char>	value;
+		shared_device_buffer		buffer;
+	};
+
+	class Command {
+	public:
+		Command();
+
+		CommandType					type;
+
+		ocl::KernelSource *			kernel;
+		size_t						global_work_size[3];
+		size_t						local_work_size[3];
+		std::vector<RecordedArg>	args;
+
+		shared_device_buffer		src;
+		shared_device_buffer		dst;
+		const void *				host_src;
+		void *						host_dst;
+		size_t						size;
+	};
+
+	ocl::OpenCLEngine *	engine();
+	Command &			command(size_t index, CommandType type);
+	void				checkWorkSize(Command &command);
+
+	ocl::sh_ptr_ocl_engine	engine_;
+	std::vector<Command>	commands_;
+};
+
+}
@@ -0,0 +1,183 @@
+#include "compact.h"
+#include "context.h"
+#include "scan.h"
+#include "work_size.h"
+
+#include <libgpu/opencl/program_cache.h>
+#include <libutils/string_utils.h>
+
+#include "opencl/cl/compact_cl.h"
+
+#include <limits>
+
+namespace gpu {
+
+// Same blocks as in scan: 256 work items per group, each selects from 4 elements
+static const unsigned int compact_workgroup_size	= 256;
+static const unsigned int compact_values_per_item	= 4;
+static const unsigned int compact_block_size		= compact_workgroup_size * compact_values_per_item;
+
+static ocl::ProgramCache compact_programs(compact_kernel, compact_kernel_length, "compact");
+
+// Ends of blocks in output are kept between calls of the calling thread, so that repeated compactions allocate nothing
+// (the buffer is recreated if the thread switches to another engine - buffers belong to the context they were created in)
+struct CompactScratch {
+	CompactScratch() : engine_id(-1) {}
+
+	int				engine_id;
+	gpu_mem_32u		block_ends;
+};
+
+static thread_local CompactScratch compact_scratch;
+
+static gpu_mem_32u &compactBlockEnds(unsigned int nblocks)
+{
+	Context context;
+	if (compact_scratch.engine_id != context.cl()->id()) {
+		compact_scratch.block_ends.reset();
+		compact_scratch.engine_id = context.cl()->id();
+	}
+	compact_scratch.block_ends.growN(nblocks);
+	return compact_scratch.block_ends;
+}
+
+// compact_select() of compact.cl for predicate of element x, with scan_local.cl used by compact_scatter
+static std::string predicateHeader(const std::string &predicate)
+{
+	return scanLocalHeader() + "\n"
+		   "#ifdef T_IS_DOUBLE\n#pragma OPENCL EXTENSION cl_khr_fp64 : enable\n#endif\n"
+		   "bool compact_select(__global const T *values, unsigned int i) { const T x = values[i]; return (" + predicate + "); }\n";
+}
+
+// compact_select() of compact.cl that selects first elements of runs of equal elements a and b, with scan_local.cl
+static std::string runHeader(const std::string &equal)
+{
+	return scanLocalHeader() + "\n"
+		   "#ifdef T_IS_DOUBLE\n#pragma OPENCL EXTENSION cl_khr_fp64 : enable\n#endif\n"
+		   "bool compact_select(__global const T *values, unsigned int i) { if (i == 0) return true; const T a = values[i - 1]; const T b = values[i]; return !(" + equal + "); }\n";
+}
+
+// Selects elements of values with compact_select() from header: counts selected elements of every block, scans counts
+// in place into ends of blocks in output and reads back the total - the end of the last block, enlarges result
+// and writes selected elements there
+template <typename T>
+static size_t compact(const shared_device_buffer_typed<T> &values, size_t n, const std::string &header, bool partition,
+					  shared_device_buffer_typed<T> &result, shared_device_buffer_typed<unsigned int> *indices)
+{
+	if (n > values.number())
+		throw gpu_exception("Not enough data in device buffer: " + to_string(n) + " > " + to_string(values.number()));
+	if (n > std::numeric_limits<unsigned int>::max() - compact_block_size)
+		throw gpu_exception("Stream compaction supports at most 2^32-" + to_string(compact_block_size + 1) + " elements, but " + to_string(n) + " requested!");
+	if (n == 0)
+		return 0;
+
+	std::string defines = ocl::typeDefines<T>() + " -D WORKGROUP_SIZE=" + to_string(compact_workgroup_size);
+	if (partition)
+		defines += " -D PARTITION";
+	if (indices)
+		defines += " -D WRITE_INDICES";
+
+	unsigned int nblocks = divup((unsigned int) n, compact_block_size);
+	WorkSize ws(compact_workgroup_size, nblocks * compact_workgroup_size);
+
+	gpu_mem_32u &block_ends = compactBlockEnds(nblocks);
+	compact_programs.kernel("compact_count", defines, header).exec(ws, values, (unsigned int) n, block_ends);
+	inclusiveScan(block_ends, block_ends, nblocks);
+
+	unsigned int total = 0;
+	block_ends.readN(&total, 1, nblocks - 1);
+
+	result.growN(partition ? n : total);
+	if (indices)
+		indices->growN(total);
+	if (total == 0 && !partition)
+		return 0;
+
+	// kernel is compiled without WRITE_INDICES if indices are not needed, then any buffer can be passed instead of them
+	compact_programs.kernel("compact_scatter", defines, header).exec(ws, values, (unsigned int) n, block_ends, total,
+																	 result, indices ? (gpu_mem_any &) *indices : (gpu_mem_any &) block_ends);
+	return total;
+}
+
+template <typename T>
+size_t copyIf(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, const std::string &predicate)
+{
+	return copyIf(values, result, values.number(), predicate);
+}
+
+template <typename T>
+size_t copyIf(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, size_t n, const std::string &predicate)
+{
+	return compact(values, n, predicateHeader(predicate), false, result, NULL);
+}
+
+template <typename T>
+size_t partition(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, const std::string &predicate)
+{
+	return partition(values, result, values.number(), predicate);
+}
+
+template <typename T>
+size_t partition(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, size_t n, const std::string &predicate)
+{
+	return compact(values, n, predicateHeader(predicate), true, result, NULL);
+}
+
+template <typename T>
+size_t unique(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, const std::string &equal)
+{
+	return unique(values, result, values.number(), equal);
+}
+
+template <typename T>
+size_t unique(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, size_t n, const std::string &equal)
+{
+	return compact(values, n, runHeader(equal), false, result, NULL);
+}
+
+template <typename T>
+size_t runLengthEncode(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &run_values,
+					   shared_device_buffer_typed<unsigned int> &run_lengths, const std::string &equal)
+{
+	return runLengthEncode(values, run_values, run_lengths, values.number(), equal);
+}
+
+template <typename T>
+size_t runLengthEncode(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &run_values,
+					   shared_device_buffer_typed<unsigned int> &run_lengths, size_t n, const std::string &equal)
+{
+	// starts of runs are selected with their values, lengths are differences of neighbouring starts
+	gpu_mem_32u run_starts;
+	size_t nruns = compact(values, n, runHeader(equal), false, run_values, &run_starts);
+	if (nruns == 0)
+		return 0;
+
+	run_lengths.growN(nruns);
+	std::string defines = ocl::typeDefines<T>() + " -D WORKGROUP_SIZE=" + to_string(compact_workgroup_size);
+	compact_programs.kernel("run_lengths", defines, runHeader(equal)).exec(WorkSize(compact_workgroup_size, nruns),
+																		   run_starts, (unsigned int) nruns, (unsigned int) n, run_lengths);
+	return nruns;
+}
+
+#define INSTANTIATE_COMPACT(T) \
+	template size_t copyIf<T>(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, const std::string &predicate); \
+	template size_t copyIf<T>(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, size_t n, const std::string &predicate); \
+	template size_t partition<T>(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, const std::string &predicate); \
+	template size_t partition<T>(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, size_t n, const std::string &predicate); \
+	template size_t unique<T>(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, const std::string &equal); \
+	template size_t unique<T>(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, size_t n, const std::string &equal); \
+	template size_t runLengthEncode<T>(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &run_values, \
+									   shared_device_buffer_typed<unsigned int> &run_lengths, const std::string &equal); \
+	template size_t runLengthEncode<T>(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &run_values, \
+									   shared_device_buffer_typed<unsigned int> &run_lengths, size_t n, const std::string &equal);
+
+INSTANTIATE_COMPACT(int8_t)
+INSTANTIATE_COMPACT(int16_t)
+INSTANTIATE_COMPACT(int32_t)
+INSTANTIATE_COMPACT(uint8_t)
+INSTANTIATE_COMPACT(uint16_t)
+INSTANTIATE_COMPACT(uint32_t)
+INSTANTIATE_COMPACT(float)
+INSTANTIATE_COMPACT(double)
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+// Stream compaction of first n elements (whole buffer if n is not specified) with the active context, without copying data to host.
+// Predicates are OpenCL expressions of element x of type T, e.g. "x > 0.5f" or "(x & 1) == 0", equalities are expressions
+// of neighbouring elements a and b, e.g. "fabs(a - b) < 1e-3f". Kernels are compiled for every predicate.
+// Results keep order of elements, outputs are enlarged with growN if they are too small, so they can be bigger than the result -
+// number of elements in the result is returned (it is the only value read back to host). Outputs must not be the same buffers as values.
+
+// Copies elements satisfying predicate to result, returns their number
+template <typename T>
+size_t copyIf(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, const std::string &predicate);
+
+template <typename T>
+size_t copyIf(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, size_t n, const std::string &predicate);
+
+// Copies elements satisfying predicate to result followed by all other elements (stable partition), returns number of the first ones
+template <typename T>
+size_t partition(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, const std::string &predicate);
+
+template <typename T>
+size_t partition(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, size_t n, const std::string &predicate);
+
+// Copies first element of every run of consecutive equal elements to result (as std::unique), returns number of runs
+template <typename T>
+size_t unique(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, const std::string &equal = "a == b");
+
+template <typename T>
+size_t unique(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, size_t n, const std::string &equal = "a == b");
+
+// Run-length encoding: first element and length of every run of consecutive equal elements, returns number of runs
+template <typename T>
+size_t runLengthEncode(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &run_values,
+					   shared_device_buffer_typed<unsigned int> &run_lengths, const std::string &equal = "a == b");
+
+template <typename T>
+size_t runLengthEncode(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &run_values,
+					   shared_device_buffer_typed<unsigned int> &run_lengths, size_t n, const std::string &equal = "a == b");
+
+}
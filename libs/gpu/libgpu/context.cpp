@@ -107,7 +107,8 @@ void Context::activate()
 	if (!data_ref_)
 		throw std::runtime_error("Unexpected GPU context activate call");
 
-	// create cuda stream on first activate call
+	// create cuda stream on first activate call, copies of the context can be activated by several threads at once
+	std::unique_lock<std::mutex> lock(data_ref_->activation_mutex);
 	if (!data_ref_->activated) {
 #ifdef CUDA_SUPPORT
 		if (data_ref_->type == TypeCUDA) {
@@ -136,6 +137,7 @@ void Context::activate()
 
 		data_ref_->activated = true;
 	}
+	lock.unlock();
 
 	if (data_current_ && data_current_ != data_ref_.get())
 		throw std::runtime_error("Another GPU context is already active");
@@ -297,7 +299,7 @@ Context::Type Context::type() const
 	return TypeUndefined;
 }
 
-ocl::sh_ptr_ocl_engine Context::cl() const
+const ocl::sh_ptr_ocl_engine &Context::cl() const
 {
 	return data()->ocl_engine;
 }
@@ -1,19 +1,18 @@
 #pragma once
 
+#include <mutex>
 #include <vector>
 #include <libgpu/opencl/engine.h>
 
 typedef struct CUctx_st *cudaContext_t;
 typedef struct CUstream_st *cudaStream_t;
 
-#ifdef _MSC_VER
-    #define THREAD_LOCAL __declspec(thread)
-#else
-    #define THREAD_LOCAL __thread
-#endif
-
 namespace gpu {
 
+// Context is activated per thread (see data_current_). Worker threads can share one context by copying
+// an initialized Context and calling activate() in each thread (copies can be made before the first activation - the engine
+// is created once, by the first thread that activates any of them): they then share the OpenCL context, compiled programs
+// and device buffers, while every thread enqueues its commands into its own command queue (see OpenCLEngine::queue).
 class Context {
 public:
 	Context();
@@ -43,7 +42,7 @@ public:
 
 	Type	type() const;
 
-	ocl::sh_ptr_ocl_engine	cl() const;
+	const ocl::sh_ptr_ocl_engine &	cl() const;	// returned by reference to keep launches and transfers free of refcounting
 	cudaStream_t			cudaStream() const;
 
 protected:
@@ -60,6 +59,7 @@ protected:
 		struct _cl_device_id *	ocl_device;
 		ocl::sh_ptr_ocl_engine	ocl_engine;
 		bool					activated;
+		std::mutex				activation_mutex;	// guards creation of the engine and cuda stream on first activate
 	};
 
 	Data *	data() const;
@@ -0,0 +1,210 @@
+#include "csr_matrix.h"
+#include "context.h"
+#include "work_size.h"
+
+#include <libgpu/opencl/program_cache.h>
+#include <libutils/string_utils.h>
+
+#include "opencl/cl/spmv_cl.h"
+
+#include <limits>
+#include <algorithm>
+
+namespace gpu {
+
+// Rows get one work item per 4 values (rounded up to a power of two, at most 32 - up to a warp), rows of up to 4 values
+// are multiplied by the scalar kernel. Rows longer than 2048 values (64 steps of 32 work items) and than 16 mean rows
+// make matrix irregular enough for merge-based SpMV, in which every work item takes 16 steps of the merge path.
+static const unsigned int spmv_workgroup_size		= 256;
+static const unsigned int spmv_values_per_item		= 4;
+static const unsigned int spmv_max_vector_size		= 32;
+static const unsigned int spmv_long_row				= 2048;
+static const unsigned int spmv_long_row_skew		= 16;
+static const unsigned int spmv_items_per_thread		= 16;
+
+static ocl::ProgramCache spmv_programs(spmv_kernel, spmv_kernel_length, "spmv");
+
+const char *spmvAlgorithmName(SpmvAlgorithm algorithm)
+{
+	switch (algorithm) {
+	case SpmvAlgorithm::Auto:	return "auto";
+	case SpmvAlgorithm::Scalar:	return "scalar";
+	case SpmvAlgorithm::Vector:	return "vector";
+	case SpmvAlgorithm::Binned:	return "binned";
+	case SpmvAlgorithm::Merge:	return "merge";
+	}
+	return "unknown";
+}
+
+static unsigned int spmvVectorSize(double row_length)
+{
+	unsigned int vector_size = 1;
+	while (vector_size < spmv_max_vector_size && vector_size * spmv_values_per_item < row_length)
+		vector_size *= 2;
+	return vector_size;
+}
+
+template <typename T>
+CsrMatrix<T>::CsrMatrix() : nrows_(0), ncolumns_(0), nnz_(0), auto_algorithm_(SpmvAlgorithm::Binned), mean_vector_size_(1)
+{
+}
+
+template <typename T>
+CsrMatrix<T>::CsrMatrix(unsigned int nrows, unsigned int ncolumns,
+						const gpu_mem_32u &row_offsets, const gpu_mem_32u &column_indices, const shared_device_buffer_typed<T> &values)
+	: nrows_(nrows), ncolumns_(ncolumns), nnz_(0), row_offsets_(row_offsets), column_indices_(column_indices), values_(values),
+	  auto_algorithm_(SpmvAlgorithm::Binned), mean_vector_size_(1)
+{
+	if (row_offsets.number() < (size_t) nrows + 1)
+		throw gpu_exception("CSR matrix with " + to_string(nrows) + " rows needs " + to_string((size_t) nrows + 1) + " row offsets, but only " + to_string(row_offsets.number()) + " given!");
+
+	std::vector<unsigned int> offsets(nrows + 1);
+	row_offsets.readN(offsets.data(), offsets.size());
+	if (offsets[0] != 0)
+		throw gpu_exception("CSR matrix row offsets should start with 0, but start with " + to_string(offsets[0]) + "!");
+
+	nnz_ = offsets[nrows];
+	if (column_indices.number() < nnz_ || values.number() < nnz_)
+		throw gpu_exception("CSR matrix has " + to_string(nnz_) + " values, but only " + to_string(column_indices.number()) + " column indices and " + to_string(values.number()) + " values given!");
+	if ((size_t) nrows + nnz_ > std::numeric_limits<unsigned int>::max())
+		throw gpu_exception("CSR matrix supports at most 2^32-1 rows plus values, but " + to_string((size_t) nrows + nnz_) + " given!");
+
+	// row lengths define the number of work items per row
+	std::vector<unsigned int> row_vector_sizes(nrows);
+	std::vector<unsigned int> bin_sizes(spmv_max_vector_size + 1, 0);
+	unsigned int max_length = 0;
+	for (unsigned int i = 0; i < nrows; ++i) {
+		if (offsets[i + 1] < offsets[i])
+			throw gpu_exception("CSR matrix row offsets decrease at row " + to_string(i) + "!");
+		unsigned int length = offsets[i + 1] - offsets[i];
+		max_length = std::max(max_length, length);
+		row_vector_sizes[i] = spmvVectorSize(length);
+		++bin_sizes[row_vector_sizes[i]];
+	}
+
+	double mean_length = nrows > 0 ? (double) nnz_ / nrows : 0.0;
+	mean_vector_size_ = spmvVectorSize(mean_length);
+	if (max_length > spmv_long_row && max_length > spmv_long_row_skew * mean_length)
+		auto_algorithm_ = SpmvAlgorithm::Merge;
+
+	unsigned int nbins = 0;
+	for (unsigned int vector_size = 1; vector_size <= spmv_max_vector_size; vector_size *= 2) {
+		if (bin_sizes[vector_size] > 0)
+			++nbins;
+	}
+	for (unsigned int vector_size = 1; vector_size <= spmv_max_vector_size; vector_size *= 2) {
+		if (bin_sizes[vector_size] == 0)
+			continue;
+
+		RowBin bin;
+		bin.vector_size = vector_size;
+		bin.nrows = bin_sizes[vector_size];
+		// all rows in one bin are multiplied without a list
+		if (nbins > 1) {
+			std::vector<unsigned int> rows;
+			rows.reserve(bin.nrows);
+			for (unsigned int i = 0; i < nrows; ++i) {
+				if (row_vector_sizes[i] == vector_size)
+					rows.push_back(i);
+			}
+			bin.row_list.resizeN(bin.nrows);
+			bin.row_list.writeN(rows.data(), bin.nrows);
+		}
+		bins_.push_back(bin);
+	}
+}
+
+template <typename T>
+void CsrMatrix<T>::multiply(const shared_device_buffer_typed<T> &x, shared_device_buffer_typed<T> &y, SpmvAlgorithm algorithm) const
+{
+	if (x.number() < ncolumns_)
+		throw gpu_exception("Vector of " + to_string(x.number()) + " elements is multiplied by matrix with " + to_string(ncolumns_) + " columns!");
+
+	y.growN(nrows_);
+	if (nrows_ == 0)
+		return;
+
+	if (algorithm == SpmvAlgorithm::Auto)
+		algorithm = auto_algorithm_;
+
+	if (algorithm == SpmvAlgorithm::Merge) {
+		multiplyMerge(x, y);
+	} else if (algorithm == SpmvAlgorithm::Binned) {
+		for (size_t b = 0; b < bins_.size(); ++b)
+			multiplyRows(bins_[b], x, y);
+	} else {
+		RowBin all_rows;
+		all_rows.vector_size = algorithm == SpmvAlgorithm::Scalar ? 1 : std::max(2u, mean_vector_size_);
+		all_rows.nrows = nrows_;
+		multiplyRows(all_rows, x, y);
+	}
+}
+
+template <typename T>
+void CsrMatrix<T>::multiplyRows(const RowBin &bin, const shared_device_buffer_typed<T> &x, shared_device_buffer_typed<T> &y) const
+{
+	bool row_list = !bin.row_list.isNull();
+	std::string defines = ocl::typeDefines<T>() + " -D WORKGROUP_SIZE=" + to_string(spmv_workgroup_size)
+						+ " -D VECTOR_SIZE=" + to_string(bin.vector_size) + (row_list ? " -D ROW_LIST" : "");
+
+	ocl::KernelSource &kernel = spmv_programs.kernel(bin.vector_size == 1 ? "spmv_scalar" : "spmv_vector", defines);
+	WorkSize ws(spmv_workgroup_size, bin.nrows * bin.vector_size);
+	if (row_list) {
+		kernel.exec(ws, row_offsets_, column_indices_, values_, x, y, bin.nrows, bin.row_list);
+	} else {
+		kernel.exec(ws, row_offsets_, column_indices_, values_, x, y, bin.nrows);
+	}
+}
+
+// Carries of merge-based multiplication are kept between calls of the calling thread, so that multiply() stays const
+// and can be called for the same matrix from several threads (recreated if the thread switches to another engine, as in compact.cpp)
+template <typename T>
+struct SpmvMergeScratch {
+	SpmvMergeScratch() : engine_id(-1) {}
+
+	int								engine_id;
+	gpu_mem_32u						carry_rows;
+	shared_device_buffer_typed<T>	carry_values;
+};
+
+template <typename T>
+static SpmvMergeScratch<T> &spmvMergeScratch(unsigned int nthreads)
+{
+	static thread_local SpmvMergeScratch<T> scratch;
+
+	Context context;
+	if (scratch.engine_id != context.cl()->id()) {
+		scratch.carry_rows.reset();
+		scratch.carry_values.reset();
+		scratch.engine_id = context.cl()->id();
+	}
+	scratch.carry_rows.growN(nthreads);
+	scratch.carry_values.growN(nthreads);
+	return scratch;
+}
+
+template <typename T>
+void CsrMatrix<T>::multiplyMerge(const shared_device_buffer_typed<T> &x, shared_device_buffer_typed<T> &y) const
+{
+	std::string defines = ocl::typeDefines<T>() + " -D ITEMS_PER_THREAD=" + to_string(spmv_items_per_thread);
+
+	unsigned int nthreads = divup(nrows_ + nnz_, spmv_items_per_thread);
+	SpmvMergeScratch<T> &scratch = spmvMergeScratch<T>(nthreads);
+
+	WorkSize ws(spmv_workgroup_size, nthreads);
+	spmv_programs.kernel("spmv_merge", defines).exec(ws, row_offsets_, column_indices_, values_, x, y,
+													 nrows_, nnz_, nthreads, scratch.carry_rows, scratch.carry_values);
+	spmv_programs.kernel("spmv_merge_fixup", defines).exec(ws, y, nrows_, nthreads, scratch.carry_rows, scratch.carry_values);
+}
+
+template <typename T>
+size_t CsrMatrix<T>::effectiveBytes() const
+{
+	return ((size_t) nrows_ + 1) * sizeof(unsigned int) + (size_t) nnz_ * (sizeof(unsigned int) + sizeof(T))
+		   + (size_t) ncolumns_ * sizeof(T) + (size_t) nrows_ * sizeof(T);
+}
+
+template class CsrMatrix<float>;
+template class CsrMatrix<double>;
+
+}
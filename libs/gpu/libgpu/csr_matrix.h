@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+// Kernels of CsrMatrix::multiply:
+// Scalar - work item per row, Vector - up to 32 work items per row (chosen by mean row length),
+// Binned - rows are binned by length, every bin is multiplied by scalar or vector kernel with its own number of work items per row,
+// Merge - merge-based SpMV, work is split evenly by number of rows plus number of values regardless of row lengths.
+// Auto - Binned, or Merge if there are rows much longer than the mean (e.g. power-law graphs).
+enum class SpmvAlgorithm {
+	Auto,
+	Scalar,
+	Vector,
+	Binned,
+	Merge
+};
+
+const char *spmvAlgorithmName(SpmvAlgorithm algorithm);
+
+// Sparse matrix in CSR format on device, T is float or double: values and column indices of row i are
+// [row_offsets[i], row_offsets[i + 1]), row_offsets has nrows + 1 elements. Buffers are shared, not copied.
+// Row offsets are read back once in constructor to bin rows by length for the active context.
+template <typename T>
+class CsrMatrix {
+public:
+	CsrMatrix();
+	CsrMatrix(unsigned int nrows, unsigned int ncolumns,
+			  const gpu_mem_32u &row_offsets, const gpu_mem_32u &column_indices, const shared_device_buffer_typed<T> &values);
+
+	// y = A * x, y is resized to nrows if it is too small
+	void			multiply(const shared_device_buffer_typed<T> &x, shared_device_buffer_typed<T> &y,
+							 SpmvAlgorithm algorithm = SpmvAlgorithm::Auto) const;
+
+	// Algorithm used by SpmvAlgorithm::Auto
+	SpmvAlgorithm	autoAlgorithm() const	{ return auto_algorithm_; }
+
+	// Bytes that multiply has to move at least: matrix, x and y once, effective bandwidth is effectiveBytes() / time
+	size_t			effectiveBytes() const;
+
+	unsigned int	rows() const			{ return nrows_; }
+	unsigned int	columns() const			{ return ncolumns_; }
+	unsigned int	nnz() const				{ return nnz_; }
+
+	const gpu_mem_32u &						rowOffsets() const		{ return row_offsets_; }
+	const gpu_mem_32u &						columnIndices() const	{ return column_indices_; }
+	const shared_device_buffer_typed<T> &	values() const			{ return values_; }
+
+protected:
+	// Rows multiplied with vector_size work items per row (1 - scalar kernel), row list is empty if these are all rows
+	struct RowBin {
+		unsigned int	vector_size;
+		unsigned int	nrows;
+		gpu_mem_32u		row_list;
+	};
+
+	void	multiplyRows(const RowBin &bin, const shared_device_buffer_typed<T> &x, shared_device_buffer_typed<T> &y) const;
+	void	multiplyMerge(const shared_device_buffer_typed<T> &x, shared_device_buffer_typed<T> &y) const;
+
+	unsigned int					nrows_;
+	unsigned int					ncolumns_;
+	unsigned int					nnz_;
+	gpu_mem_32u						row_offsets_;
+	gpu_mem_32u						column_indices_;
+	shared_device_buffer_typed<T>	values_;
+
+	SpmvAlgorithm					auto_algorithm_;
+	unsigned int					mean_vector_size_;
+	std::vector<RowBin>				bins_;
+};
+
+}
@@ -0,0 +1,246 @@
+#include "expression.h"
+#include "context.h"
+#include "work_size.h"
+
+#include <libgpu/opencl/program_cache.h>
+#include <libutils/string_utils.h>
+
+#include "opencl/cl/expression_cl.h"
+
+#include <algorithm>
+#include <type_traits>
+
+namespace gpu {
+
+static const unsigned int expression_workgroup_size	= 256;
+// Kernel arguments besides result and number of elements
+static const size_t expression_max_operands			= 39;
+
+static ocl::ProgramCache expression_programs(expression_kernel, expression_kernel_length, "expression");
+
+namespace expression {
+
+	static std::shared_ptr<Node> node(Node::Kind kind, const char *name = "")
+	{
+		std::shared_ptr<Node> result = std::make_shared<Node>();
+		result->kind = kind;
+		result->name = name;
+		result->scalar = 0.0;
+		return result;
+	}
+
+	std::shared_ptr<const Node> bufferNode(const shared_device_buffer &buffer)
+	{
+		std::shared_ptr<Node> result = node(Node::Buffer);
+		result->buffer = buffer;
+		return result;
+	}
+
+	std::shared_ptr<const Node> scalarNode(double value)
+	{
+		std::shared_ptr<Node> result = node(Node::Scalar);
+		result->scalar = value;
+		return result;
+	}
+
+	std::shared_ptr<const Node> operatorNode(const char *name, const std::shared_ptr<const Node> &a)
+	{
+		std::shared_ptr<Node> result = node(Node::Operator, name);
+		result->arguments.push_back(a);
+		return result;
+	}
+
+	std::shared_ptr<const Node> operatorNode(const char *name, const std::shared_ptr<const Node> &a, const std::shared_ptr<const Node> &b)
+	{
+		std::shared_ptr<Node> result = node(Node::Operator, name);
+		result->arguments.push_back(a);
+		result->arguments.push_back(b);
+		return result;
+	}
+
+	std::shared_ptr<const Node> functionNode(const char *name, const std::shared_ptr<const Node> &a)
+	{
+		std::shared_ptr<Node> result = node(Node::Function, name);
+		result->arguments.push_back(a);
+		return result;
+	}
+
+	std::shared_ptr<const Node> functionNode(const char *name, const std::shared_ptr<const Node> &a, const std::shared_ptr<const Node> &b)
+	{
+		std::shared_ptr<Node> result = node(Node::Function, name);
+		result->arguments.push_back(a);
+		result->arguments.push_back(b);
+		return result;
+	}
+
+	// Code of the expression with its operands in the order of kernel arguments: distinct buffers (the same memory is read once) and scalars
+	class Codegen {
+	public:
+		explicit Codegen(const Node &root)
+		{
+			code_ = generate(root);
+		}
+
+		// Header for expression.cl, it depends only on the structure of the expression, so it is the key of the compiled program
+		std::string header() const
+		{
+			std::string parameters = "#define EXPRESSION_PARAMETERS";
+			std::string loads = "#define EXPRESSION_LOAD(TYPE, LOAD)";
+			for (size_t k = 0; k < buffers_.size(); ++k) {
+				parameters += " , __global const T *in" + to_string(k);
+				loads += " const TYPE x" + to_string(k) + " = LOAD(in" + to_string(k) + ");";
+			}
+			for (size_t k = 0; k < scalars_.size(); ++k) {
+				parameters += " , T s" + to_string(k);
+				loads += " const TYPE c" + to_string(k) + " = (TYPE) s" + to_string(k) + ";";
+			}
+			return parameters + "\n" + loads + "\n" + "#define EXPRESSION " + code_ + "\n";
+		}
+
+		const std::vector<const Node *> &	buffers() const		{ return buffers_;	}
+		const std::vector<double> &			scalars() const		{ return scalars_;	}
+
+	protected:
+		std::string generate(const Node &node)
+		{
+			switch (node.kind) {
+			case Node::Buffer:
+				for (size_t k = 0; k < buffers_.size(); ++k) {
+					if (buffers_[k]->buffer.clmem() == node.buffer.clmem() && buffers_[k]->buffer.cloffset() == node.buffer.cloffset())
+						return "x" + to_string(k);
+				}
+				buffers_.push_back(&node);
+				return "x" + to_string(buffers_.size() - 1);
+			case Node::Scalar:
+				scalars_.push_back(node.scalar);
+				return "c" + to_string(scalars_.size() - 1);
+			case Node::Operator:
+			{
+				// operands are numbered from left to right, so subexpressions are generated one after another
+				std::string a = generate(*node.arguments[0]);
+				if (node.arguments.size() == 1)
+					return "(" + node.name + a + ")";
+				std::string b = generate(*node.arguments[1]);
+				return "(" + a + " " + node.name + " " + b + ")";
+			}
+			case Node::Function:
+			{
+				std::string code = node.name + "(";
+				for (size_t k = 0; k < node.arguments.size(); ++k)
+					code += (k > 0 ? ", " : "") + generate(*node.arguments[k]);
+				return code + ")";
+			}
+			}
+			throw gpu_exception("Unknown kind of expression node!");
+		}
+
+		std::string					code_;
+		std::vector<const Node *>	buffers_;
+		std::vector<double>			scalars_;
+	};
+
+}
+
+// Elements per work item - native vector width of the device for T, at most 16 (the widest OpenCL vector): CPU devices report
+// widths of their SIMD registers, so explicit vectors map onto all lanes, GPUs usually report 1 and get the scalar kernel
+template <typename T>
+static unsigned int expressionVectorWidth()
+{
+	Context context;
+	unsigned int native_width = std::min(context.cl()->deviceInfo().nativeVectorWidth(ocl::OpenCLType<T>::name()), 16u);
+	unsigned int width = 1;
+	while (width * 2 <= native_width)
+		width *= 2;
+	return width;
+}
+
+template <typename T>
+static void evalExpression(shared_device_buffer_typed<T> &result, const Expression<T> &e, size_t n, bool whole_buffers)
+{
+	expression::Codegen codegen(*e.node());
+	const std::vector<const expression::Node *> &buffers = codegen.buffers();
+	const std::vector<double> &scalars = codegen.scalars();
+
+	if (buffers.size() + scalars.size() > expression_max_operands)
+		throw gpu_exception("Expression has " + to_string(buffers.size() + scalars.size()) + " buffers and scalars, but at most "
+							+ to_string(expression_max_operands) + " are supported!");
+
+	for (size_t k = 0; k < buffers.size(); ++k) {
+		size_t number = buffers[k]->buffer.size() / sizeof(T);
+		if (whole_buffers) {
+			n = (k == 0) ? number : std::min(n, number);
+		} else if (number < n) {
+			throw gpu_exception("Buffer of expression has " + to_string(number) + " elements instead of " + to_string(n) + "!");
+		}
+	}
+	if (n == 0)
+		return;
+	if (n > 0xffffffffu)
+		throw gpu_exception("Expressions of more than 2^32 - 1 elements are not supported!");
+	result.growN(n);
+
+	const unsigned int vector_width = expressionVectorWidth<T>();
+	std::string defines = ocl::typeDefines<T>() + " -D VECTOR_WIDTH=" + to_string(vector_width);
+	if (std::is_integral<T>::value && sizeof(T) < sizeof(int))
+		defines += " -D PROMOTE_TO_INT";
+	ocl::KernelSource &kernel = expression_programs.kernel("expression_eval", defines, codegen.header());
+
+	// arguments keep pointers to values (buffer arguments - to their own copy of cl_mem), so they are constructed in place and not copied,
+	// and scalars converted to T live until the launch
+	typedef ocl::KernelSource::Arg Arg;
+	const unsigned int number = (unsigned int) n;
+	std::vector<T> scalar_values(scalars.size());
+	std::vector<Arg> operands;
+	operands.reserve(buffers.size() + scalars.size());
+	for (size_t k = 0; k < buffers.size(); ++k)
+		operands.emplace_back(buffers[k]->buffer);
+	for (size_t k = 0; k < scalars.size(); ++k) {
+		scalar_values[k] = (T) scalars[k];
+		operands.emplace_back(scalar_values[k]);
+	}
+	const Arg none;
+	const Arg *args[expression_max_operands];
+	for (size_t k = 0; k < expression_max_operands; ++k)
+		args[k] = (k < operands.size()) ? &operands[k] : &none;
+
+	kernel.exec(WorkSize(expression_workgroup_size, divup(number, vector_width)), result, number,
+				*args[0], *args[1], *args[2], *args[3], *args[4], *args[5], *args[6], *args[7], *args[8], *args[9],
+				*args[10], *args[11], *args[12], *args[13], *args[14], *args[15], *args[16], *args[17], *args[18], *args[19],
+				*args[20], *args[21], *args[22], *args[23], *args[24], *args[25], *args[26], *args[27], *args[28], *args[29],
+				*args[30], *args[31], *args[32], *args[33], *args[34], *args[35], *args[36], *args[37], *args[38]);
+}
+
+template <typename T>
+void eval(shared_device_buffer_typed<T> &result, const Expression<T> &e)
+{
+	evalExpression(result, e, 0, true);
+}
+
+template <typename T>
+void eval(shared_device_buffer_typed<T> &result, const Expression<T> &e, size_t n)
+{
+	evalExpression(result, e, n, false);
+}
+
+template <typename T>
+std::string expressionSource(const Expression<T> &e)
+{
+	expression::Codegen codegen(*e.node());
+	return codegen.header() + "\n" + std::string(expression_kernel, expression_kernel_length);
+}
+
+#define INSTANTIATE_EXPRESSION(T)																	\
+	template void eval<T>(shared_device_buffer_typed<T> &result, const Expression<T> &e);				\
+	template void eval<T>(shared_device_buffer_typed<T> &result, const Expression<T> &e, size_t n);	\
+	template std::string expressionSource<T>(const Expression<T> &e);
+
+INSTANTIATE_EXPRESSION(int8_t)
+INSTANTIATE_EXPRESSION(int16_t)
+INSTANTIATE_EXPRESSION(int32_t)
+INSTANTIATE_EXPRESSION(uint8_t)
+INSTANTIATE_EXPRESSION(uint16_t)
+INSTANTIATE_EXPRESSION(uint32_t)
+INSTANTIATE_EXPRESSION(float)
+INSTANTIATE_EXPRESSION(double)
+
+}
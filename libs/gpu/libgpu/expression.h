@@ -0,0 +1,165 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <type_traits>
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+// Element-wise expressions over device buffers, evaluated in a single pass over memory by one kernel generated for the whole expression:
+//
+//     gpu::eval(c, a * 2.0f + sqrt(b));
+//
+// Operators and functions of buffers and scalars only build the expression tree on host, nothing is computed until gpu::eval.
+// The kernel is compiled once per expression signature - its structure and element type, so evaluating the same expression again
+// (even with other buffers and other values of scalars) reuses it: scalars are passed as kernel arguments, not as literals.
+// Every buffer is read once per element even if it occurs in the expression several times. Work items compute vectors
+// of native vector width of the device for T (vloadN/vstoreN, e.g. 8 floats on AVX CPUs), on most GPUs it is 1 element.
+// Arithmetic of 8 and 16-bit integers is done in int as in C, so (a + b) / 2 of uint8_t does not wrap in the intermediate sum.
+// All operands of an expression must have the same element type T, scalars are converted to it.
+// Math functions (sqrt, exp, ...) are OpenCL built-ins, so they are available for float and double, min and max - for all types.
+template <typename T>
+class Expression;
+
+namespace expression {
+
+	// Node of an expression tree, trees are immutable so that subexpressions can be shared between expressions
+	struct Node {
+		enum Kind { Buffer, Scalar, Operator, Function };
+
+		Kind											kind;
+		std::string										name;		// operator ("+", "-", ...) or function ("sqrt", "max", ...)
+		std::vector<std::shared_ptr<const Node>>		arguments;
+		shared_device_buffer							buffer;
+		double											scalar;		// any value of supported element types is representable exactly
+	};
+
+	std::shared_ptr<const Node> bufferNode(const shared_device_buffer &buffer);
+	std::shared_ptr<const Node> scalarNode(double value);
+	std::shared_ptr<const Node> operatorNode(const char *name, const std::shared_ptr<const Node> &a);
+	std::shared_ptr<const Node> operatorNode(const char *name, const std::shared_ptr<const Node> &a, const std::shared_ptr<const Node> &b);
+	std::shared_ptr<const Node> functionNode(const char *name, const std::shared_ptr<const Node> &a);
+	std::shared_ptr<const Node> functionNode(const char *name, const std::shared_ptr<const Node> &a, const std::shared_ptr<const Node> &b);
+
+	// Operands of expressions: expressions and buffers with element type T, and scalars that take the type of the other operand (type is void)
+	template <typename X, typename Enable = void>
+	struct Operand {};
+
+	template <typename T>
+	struct Operand<Expression<T>> {
+		typedef T type;
+		static std::shared_ptr<const Node> node(const Expression<T> &e)				{ return e.node();			}
+	};
+
+	template <typename T>
+	struct Operand<shared_device_buffer_typed<T>> {
+		typedef T type;
+		static std::shared_ptr<const Node> node(const shared_device_buffer_typed<T> &buffer)	{ return bufferNode(buffer);	}
+	};
+
+	template <typename X>
+	struct Operand<X, typename std::enable_if<std::is_arithmetic<X>::value>::type> {
+		typedef void type;
+		static std::shared_ptr<const Node> node(const X &value)						{ return scalarNode((double) value);	}
+	};
+
+	// Result of unary operators and functions - not defined for scalars, so that they don't hide functions of numbers
+	template <typename A, typename TA = typename Operand<A>::type>
+	struct Unary : std::enable_if<!std::is_void<TA>::value, Expression<TA>> {};
+
+	// Result of binary operators and functions - defined if at least one operand is not a scalar and element types are the same
+	template <typename A, typename B, typename TA = typename Operand<A>::type, typename TB = typename Operand<B>::type>
+	struct Binary : std::enable_if<std::is_same<TA, TB>::value, Expression<TA>> {};
+
+	template <typename A, typename B, typename TA>
+	struct Binary<A, B, TA, void> { typedef Expression<TA> type; };
+
+	template <typename A, typename B, typename TB>
+	struct Binary<A, B, void, TB> { typedef Expression<TB> type; };
+
+	template <typename A, typename B>
+	struct Binary<A, B, void, void> {};
+
+}
+
+template <typename T>
+class Expression {
+public:
+	Expression(const shared_device_buffer_typed<T> &buffer) : node_(expression::bufferNode(buffer)) {}
+	explicit Expression(const std::shared_ptr<const expression::Node> &node) : node_(node) {}
+
+	const std::shared_ptr<const expression::Node> &node() const	{ return node_;	}
+
+protected:
+	std::shared_ptr<const expression::Node> node_;
+};
+
+// Evaluates result[i] = e[i] for first n elements (for the smallest number of elements of buffers of the expression if n is not specified)
+// with the active context. Result is enlarged with growN if it is too small, it can be one of the buffers of the expression.
+// Element type T is one of int8..uint32, float or double, expression can have at most 39 different buffers and scalars.
+template <typename T>
+void eval(shared_device_buffer_typed<T> &result, const Expression<T> &e);
+
+template <typename T>
+void eval(shared_device_buffer_typed<T> &result, const Expression<T> &e, size_t n);
+
+// OpenCL source of the kernel for expression e, e.g. to look at what is generated (it is compiled with T and VECTOR_WIDTH defined)
+template <typename T>
+std::string expressionSource(const Expression<T> &e);
+
+#define GPU_EXPRESSION_OPERATOR(op)																				\
+	template <typename A, typename B>																			\
+	typename expression::Binary<A, B>::type operator op(const A &a, const B &b)									\
+	{																											\
+		typedef typename expression::Binary<A, B>::type Result;													\
+		return Result(expression::operatorNode(#op, expression::Operand<A>::node(a), expression::Operand<B>::node(b)));	\
+	}
+
+#define GPU_EXPRESSION_FUNCTION1(name)																			\
+	template <typename A>																						\
+	typename expression::Unary<A>::type name(const A &a)														\
+	{																											\
+		typedef typename expression::Unary<A>::type Result;														\
+		return Result(expression::functionNode(#name, expression::Operand<A>::node(a)));						\
+	}
+
+#define GPU_EXPRESSION_FUNCTION2(name)																			\
+	template <typename A, typename B>																			\
+	typename expression::Binary<A, B>::type name(const A &a, const B &b)										\
+	{																											\
+		typedef typename expression::Binary<A, B>::type Result;													\
+		return Result(expression::functionNode(#name, expression::Operand<A>::node(a), expression::Operand<B>::node(b)));	\
+	}
+
+GPU_EXPRESSION_OPERATOR(+)
+GPU_EXPRESSION_OPERATOR(-)
+GPU_EXPRESSION_OPERATOR(*)
+GPU_EXPRESSION_OPERATOR(/)
+
+template <typename A>
+typename expression::Unary<A>::type operator-(const A &a)
+{
+	typedef typename expression::Unary<A>::type Result;
+	return Result(expression::operatorNode("-", expression::Operand<A>::node(a)));
+}
+
+GPU_EXPRESSION_FUNCTION1(sqrt)
+GPU_EXPRESSION_FUNCTION1(rsqrt)
+GPU_EXPRESSION_FUNCTION1(exp)
+GPU_EXPRESSION_FUNCTION1(log)
+GPU_EXPRESSION_FUNCTION1(sin)
+GPU_EXPRESSION_FUNCTION1(cos)
+GPU_EXPRESSION_FUNCTION1(fabs)
+
+GPU_EXPRESSION_FUNCTION2(min)
+GPU_EXPRESSION_FUNCTION2(max)
+GPU_EXPRESSION_FUNCTION2(pow)
+
+#undef GPU_EXPRESSION_OPERATOR
+#undef GPU_EXPRESSION_FUNCTION1
+#undef GPU_EXPRESSION_FUNCTION2
+
+}
@@ -0,0 +1,118 @@
+#include "gemm.h"
+#include "context.h"
+#include "work_size.h"
+
+#include <libgpu/opencl/engine.h>
+#include <libgpu/opencl/program_cache.h>
+#include <libutils/string_utils.h>
+
+#include "opencl/cl/gemm_cl.h"
+
+#include <limits>
+
+namespace gpu {
+
+static ocl::ProgramCache gemm_programs(gemm_kernel, gemm_kernel_length, "gemm");
+
+GemmTiles::GemmTiles(unsigned int tile_m, unsigned int tile_n, unsigned int tile_k, unsigned int item_m, unsigned int item_n)
+	: tile_m(tile_m), tile_n(tile_n), tile_k(tile_k), item_m(item_m), item_n(item_n)
+{
+	if (tile_m == 0 || tile_n == 0 || tile_k == 0 || item_m == 0 || item_n == 0)
+		throw gpu_exception("Gemm tile sizes can't be zero!");
+	if (tile_m % item_m != 0 || tile_n % item_n != 0)
+		throw gpu_exception("Gemm tile " + to_string(tile_m) + "x" + to_string(tile_n) + " is not a multiple of work item block "
+							+ to_string(item_m) + "x" + to_string(item_n) + "!");
+}
+
+template <typename T>
+GemmTiles gemmDefaultTiles()
+{
+	Context context;
+	const ocl::DeviceInfo &info = context.cl()->deviceInfo();
+
+	if ((info.device_type & CL_DEVICE_TYPE_CPU) || info.max_workgroup_size < 256)
+		return GemmTiles(32, 32, 16, 4, 4);
+	return GemmTiles(64, 64, sizeof(T) == 8 ? 8 : 16, 4, 4);
+}
+
+template <typename T>
+void gemm(bool transpose_a, bool transpose_b, size_t m, size_t n, size_t k,
+		  T alpha, const shared_device_buffer_typed<T> &a, size_t lda, const shared_device_buffer_typed<T> &b, size_t ldb,
+		  T beta, shared_device_buffer_typed<T> &c, size_t ldc)
+{
+	gemm(transpose_a, transpose_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, gemmDefaultTiles<T>());
+}
+
+// Number of elements that matrix of rows x columns with distance ld between rows spans
+static size_t matrixSpan(size_t rows, size_t columns, size_t ld)
+{
+	return (rows == 0 || columns == 0) ? 0 : (rows - 1) * ld + columns;
+}
+
+template <typename T>
+void gemm(bool transpose_a, bool transpose_b, size_t m, size_t n, size_t k,
+		  T alpha, const shared_device_buffer_typed<T> &a, size_t lda, const shared_device_buffer_typed<T> &b, size_t ldb,
+		  T beta, shared_device_buffer_typed<T> &c, size_t ldc, const GemmTiles &tiles)
+{
+	size_t a_rows = transpose_a ? k : m;
+	size_t a_columns = transpose_a ? m : k;
+	size_t b_rows = transpose_b ? n : k;
+	size_t b_columns = transpose_b ? k : n;
+	if (lda < a_columns || ldb < b_columns || ldc < n)
+		throw gpu_exception("Leading dimension is less than number of columns!");
+	if (matrixSpan(a_rows, a_columns, lda) > a.number() || matrixSpan(b_rows, b_columns, ldb) > b.number() || matrixSpan(m, n, ldc) > c.number())
+		throw gpu_exception("Not enough data in device buffer for " + to_string(m) + "x" + to_string(n) + "x" + to_string(k) + " matrix multiplication!");
+	if (matrixSpan(a_rows, a_columns, lda) > std::numeric_limits<unsigned int>::max() || matrixSpan(b_rows, b_columns, ldb) > std::numeric_limits<unsigned int>::max()
+		|| matrixSpan(m, n, ldc) > std::numeric_limits<unsigned int>::max())
+		throw gpu_exception("Matrix multiplication supports matrices of at most 2^32-1 elements!");
+	if (m == 0 || n == 0)
+		return;
+
+	unsigned int group_m = tiles.tile_m / tiles.item_m;
+	unsigned int group_n = tiles.tile_n / tiles.item_n;
+	Context context;
+	if (group_m * group_n > context.cl()->deviceInfo().max_workgroup_size)
+		throw gpu_exception("Gemm work group of " + to_string(group_m * group_n) + " work items is too big for the device!");
+
+	std::string defines = ocl::typeDefines<T>()
+						+ " -D TILE_M=" + to_string(tiles.tile_m) + " -D TILE_N=" + to_string(tiles.tile_n) + " -D TILE_K=" + to_string(tiles.tile_k)
+						+ " -D ITEM_M=" + to_string(tiles.item_m) + " -D ITEM_N=" + to_string(tiles.item_n);
+	if (transpose_a)
+		defines += " -D TRANSPOSE_A";
+	if (transpose_b)
+		defines += " -D TRANSPOSE_B";
+
+	bool whole_tiles = m % tiles.tile_m == 0 && n % tiles.tile_n == 0 && k % tiles.tile_k == 0;
+	bool vector_tiles = tiles.tile_m % 4 == 0 && tiles.tile_n % 4 == 0 && tiles.tile_k % 4 == 0;
+	if (whole_tiles && vector_tiles && lda % 4 == 0 && ldb % 4 == 0)
+		defines += " -D VECTOR_LOADS";
+
+	WorkSize ws(group_n, group_m, divup((unsigned int) n, tiles.tile_n) * group_n, divup((unsigned int) m, tiles.tile_m) * group_m);
+	// buffers are passed untyped, so that any element type can be used as kernel argument
+	gemm_programs.kernel("gemm", defines).exec(ws, (unsigned int) m, (unsigned int) n, (unsigned int) k,
+											   alpha, (const gpu_mem_any &) a, (unsigned int) lda, (const gpu_mem_any &) b, (unsigned int) ldb,
+											   beta, (gpu_mem_any &) c, (unsigned int) ldc);
+}
+
+template <typename T>
+void gemm(size_t m, size_t n, size_t k, const shared_device_buffer_typed<T> &a, const shared_device_buffer_typed<T> &b, shared_device_buffer_typed<T> &c)
+{
+	if (c.number() < m * n)
+		c.resizeN(m * n);
+	gemm(false, false, m, n, k, (T) 1, a, k, b, n, (T) 0, c, n);
+}
+
+#define INSTANTIATE_GEMM(T) \
+	template GemmTiles gemmDefaultTiles<T>(); \
+	template void gemm<T>(bool transpose_a, bool transpose_b, size_t m, size_t n, size_t k, \
+						  T alpha, const shared_device_buffer_typed<T> &a, size_t lda, const shared_device_buffer_typed<T> &b, size_t ldb, \
+						  T beta, shared_device_buffer_typed<T> &c, size_t ldc); \
+	template void gemm<T>(bool transpose_a, bool transpose_b, size_t m, size_t n, size_t k, \
+						  T alpha, const shared_device_buffer_typed<T> &a, size_t lda, const shared_device_buffer_typed<T> &b, size_t ldb, \
+						  T beta, shared_device_buffer_typed<T> &c, size_t ldc, const GemmTiles &tiles); \
+	template void gemm<T>(size_t m, size_t n, size_t k, const shared_device_buffer_typed<T> &a, const shared_device_buffer_typed<T> &b, shared_device_buffer_typed<T> &c);
+
+INSTANTIATE_GEMM(float)
+INSTANTIATE_GEMM(double)
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+// Blocking of gpu::gemm, compiled into the kernel as defines: work group computes tile_m x tile_n block of C
+// going through k by tile_k, every work item accumulates item_m x item_n elements of the block in registers.
+// Tiles of A and B take tile_k * (tile_m + tile_n) elements of local memory, work group has (tile_m / item_m) * (tile_n / item_n) work items.
+struct GemmTiles {
+	GemmTiles(unsigned int tile_m, unsigned int tile_n, unsigned int tile_k, unsigned int item_m, unsigned int item_n);
+
+	unsigned int	tile_m;
+	unsigned int	tile_n;
+	unsigned int	tile_k;
+	unsigned int	item_m;
+	unsigned int	item_n;
+};
+
+// Tiles for the device of the active context: 64x64 blocks of 4x4 per work item on GPUs (tile_k is 16 for float and 8 for double),
+// 32x32 blocks on CPUs and on devices with work groups smaller than 256
+template <typename T>
+GemmTiles gemmDefaultTiles();
+
+// C = alpha * op(A) * op(B) + beta * C with the active context, T is float or double. Matrices are row-major, op(A) is m x k,
+// op(B) is k x n, C is m x n; op(X) is X transposed if transpose flag is set (A is stored as k x m, B as n x k).
+// lda, ldb and ldc are distances between rows in elements. As in BLAS, C is not read if beta is zero.
+// Sizes that are multiples of tiles and leading dimensions that are multiples of 4 are the fast path: tiles are loaded with vector loads.
+template <typename T>
+void gemm(bool transpose_a, bool transpose_b, size_t m, size_t n, size_t k,
+		  T alpha, const shared_device_buffer_typed<T> &a, size_t lda, const shared_device_buffer_typed<T> &b, size_t ldb,
+		  T beta, shared_device_buffer_typed<T> &c, size_t ldc);
+
+template <typename T>
+void gemm(bool transpose_a, bool transpose_b, size_t m, size_t n, size_t k,
+		  T alpha, const shared_device_buffer_typed<T> &a, size_t lda, const shared_device_buffer_typed<T> &b, size_t ldb,
+		  T beta, shared_device_buffer_typed<T> &c, size_t ldc, const GemmTiles &tiles);
+
+// C = A * B for densely packed matrices, C is resized if it is too small
+template <typename T>
+void gemm(size_t m, size_t n, size_t k, const shared_device_buffer_typed<T> &a, const shared_device_buffer_typed<T> &b, shared_device_buffer_typed<T> &c);
+
+}
@@ -0,0 +1,105 @@
+#include "histogram.h"
+#include "context.h"
+#include "work_size.h"
+
+#include <libgpu/opencl/program_cache.h>
+#include <libutils/string_utils.h>
+
+#include "opencl/cl/histogram_cl.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace gpu {
+
+// Private histograms of a work group take at most 16 KB of local memory, small histograms are replicated
+// up to 8 times (but not above 8 KB), so that work items counting equal values use different counters.
+// At most 512 groups, so that merging of private histograms into the result is cheap compared to counting.
+static const unsigned int histogram_workgroup_size	= 256;
+static const unsigned int histogram_max_groups		= 512;
+static const unsigned int histogram_local_memory		= 16 * 1024;
+static const unsigned int histogram_copies_memory	= 8 * 1024;
+static const unsigned int histogram_max_copies		= 8;
+
+static ocl::ProgramCache histogram_programs(histogram_kernel, histogram_kernel_length, "histogram");
+
+template <typename T>
+void histogram(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<unsigned int> &bins,
+			   unsigned int nbins, double range_min, double range_max, unsigned int channels)
+{
+	histogram(values, values.number(), bins, nbins, range_min, range_max, channels);
+}
+
+template <typename T>
+void histogram(const shared_device_buffer_typed<T> &values, size_t n, shared_device_buffer_typed<unsigned int> &bins,
+			   unsigned int nbins, double range_min, double range_max, unsigned int channels)
+{
+	if (n > values.number())
+		throw gpu_exception("Not enough data in device buffer: " + to_string(n) + " > " + to_string(values.number()));
+	if (n > std::numeric_limits<unsigned int>::max())
+		throw gpu_exception("Histogram supports at most 2^32-1 elements, but " + to_string(n) + " requested!");
+	if (nbins == 0 || channels == 0)
+		throw gpu_exception("Histogram needs at least one bin and one channel!");
+	if (!(range_min < range_max))
+		throw gpu_exception("Empty histogram range [" + to_string(range_min) + ", " + to_string(range_max) + ")!");
+
+	unsigned int total_bins = nbins * channels;
+	if (bins.number() != total_bins)
+		bins.resizeN(total_bins);
+
+	std::string defines = ocl::typeDefines<T>() + " -D WORKGROUP_SIZE=" + to_string(histogram_workgroup_size)
+						+ " -D NBINS=" + to_string(nbins) + " -D CHANNELS=" + to_string(channels);
+
+	bool integer_values = std::numeric_limits<T>::is_integer;
+	int64_t integer_min = 0;
+	uint64_t integer_width = 0;
+	if (integer_values) {
+		// integer x >= range_min <=> x >= ceil(range_min), the same for range_max
+		integer_min = (int64_t) std::ceil(range_min);
+		integer_width = (uint64_t) ((int64_t) std::ceil(range_max) - integer_min);
+		if (integer_width == 0)
+			throw gpu_exception("No integers in histogram range [" + to_string(range_min) + ", " + to_string(range_max) + ")!");
+		defines += " -D INTEGER_VALUES";
+		if (integer_width == nbins)
+			defines += " -D ONE_VALUE_PER_BIN";
+	}
+
+	unsigned int bytes = total_bins * sizeof(unsigned int);
+	bool local = bytes <= histogram_local_memory;
+	if (local)
+		defines += " -D LOCAL_COPIES=" + to_string(std::max(1u, std::min(histogram_max_copies, histogram_copies_memory / bytes)));
+
+	histogram_programs.kernel("histogram_clear", defines).exec(WorkSize(histogram_workgroup_size, total_bins), bins, total_bins);
+	if (n == 0)
+		return;
+
+	unsigned int ngroups = std::min(divup(divup((unsigned int) n, 4u), histogram_workgroup_size), histogram_max_groups);
+	WorkSize ws(histogram_workgroup_size, ngroups * histogram_workgroup_size);
+	ocl::KernelSource &kernel = histogram_programs.kernel(local ? "histogram_local" : "histogram_global", defines);
+
+	// buffers are passed untyped, so that any element type can be used as kernel argument
+	if (integer_values) {
+		kernel.exec(ws, (const gpu_mem_any &) values, (unsigned int) n, integer_min, integer_width, bins);
+	} else {
+		T scale = (T) (nbins / (range_max - range_min));
+		kernel.exec(ws, (const gpu_mem_any &) values, (unsigned int) n, (T) range_min, scale, bins);
+	}
+}
+
+#define INSTANTIATE_HISTOGRAM(T) \
+	template void histogram<T>(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<unsigned int> &bins, \
+							   unsigned int nbins, double range_min, double range_max, unsigned int channels); \
+	template void histogram<T>(const shared_device_buffer_typed<T> &values, size_t n, shared_device_buffer_typed<unsigned int> &bins, \
+							   unsigned int nbins, double range_min, double range_max, unsigned int channels);
+
+INSTANTIATE_HISTOGRAM(int8_t)
+INSTANTIATE_HISTOGRAM(int16_t)
+INSTANTIATE_HISTOGRAM(int32_t)
+INSTANTIATE_HISTOGRAM(uint8_t)
+INSTANTIATE_HISTOGRAM(uint16_t)
+INSTANTIATE_HISTOGRAM(uint32_t)
+INSTANTIATE_HISTOGRAM(float)
+INSTANTIATE_HISTOGRAM(double)
+
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+// Histogram of first n values (whole buffer if n is not specified) with the active context: values in [range_min, range_max)
+// are split evenly into nbins bins, values out of range (and NaNs) are not counted. Bins are resized to channels * nbins and
+// overwritten. Values can be interleaved channels (e.g. pixels of images::Image<unsigned char> with cn channels): value i
+// belongs to channel i % channels and is counted in bins[channel * nbins, (channel + 1) * nbins).
+// For integer values the range is the range of integers >= range_min and < range_max, e.g. nbins = 256, [0, 256) for 8-bit images.
+// Every work group counts values in its private histograms in local memory and adds them to the result in the end,
+// histograms bigger than local memory are counted with global atomics.
+template <typename T>
+void histogram(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<unsigned int> &bins,
+			   unsigned int nbins, double range_min, double range_max, unsigned int channels = 1);
+
+template <typename T>
+void histogram(const shared_device_buffer_typed<T> &values, size_t n, shared_device_buffer_typed<unsigned int> &bins,
+			   unsigned int nbins, double range_min, double range_max, unsigned int channels = 1);
+
+}
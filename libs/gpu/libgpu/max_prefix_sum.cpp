@@ -0,0 +1,78 @@
+#include "max_prefix_sum.h"
+#include "context.h"
+#include "work_size.h"
+
+#include <libgpu/opencl/program_cache.h>
+#include <libutils/string_utils.h>
+
+#include "opencl/cl/max_prefix_sum_cl.h"
+
+#include <limits>
+
+namespace gpu {
+
+// Every work group reduces a block of 256 * 16 values, values of the block are staged in 16 KB of local memory
+static const unsigned int max_prefix_sum_workgroup_size		= 256;
+static const unsigned int max_prefix_sum_values_per_item	= 16;
+static const unsigned int max_prefix_sum_block_size			= max_prefix_sum_workgroup_size * max_prefix_sum_values_per_item;
+
+static ocl::ProgramCache max_prefix_sum_programs(max_prefix_sum_kernel, max_prefix_sum_kernel_length, "max_prefix_sum");
+
+int maxPrefixSum(const gpu_mem_32i &values, unsigned int *length, MaxPrefixSumAlgorithm algorithm)
+{
+	return maxPrefixSum(values, values.number(), length, algorithm);
+}
+
+int maxPrefixSum(const gpu_mem_32i &values, size_t n, unsigned int *length, MaxPrefixSumAlgorithm algorithm)
+{
+	if (n > values.number())
+		throw gpu_exception("Not enough data in device buffer: " + to_string(n) + " > " + to_string(values.number()));
+	if (n > std::numeric_limits<unsigned int>::max() - max_prefix_sum_block_size)
+		throw gpu_exception("Max prefix sum supports at most 2^32-" + to_string(max_prefix_sum_block_size + 1) + " elements, but " + to_string(n) + " requested!");
+	if (n == 0) {
+		if (length)
+			*length = 0;
+		return 0;
+	}
+
+	std::string defines = "-D WORKGROUP_SIZE=" + to_string(max_prefix_sum_workgroup_size);
+
+	unsigned int nblocks = divup((unsigned int) n, max_prefix_sum_block_size);
+	WorkSize ws(max_prefix_sum_workgroup_size, nblocks * max_prefix_sum_workgroup_size);
+
+	gpu_mem_32i aggregate_sums		= gpu_mem_32i::createN(nblocks);
+	gpu_mem_32i aggregate_bests		= gpu_mem_32i::createN(nblocks);
+	gpu_mem_32u aggregate_ends		= gpu_mem_32u::createN(nblocks);
+	gpu_mem_32i result				= gpu_mem_32i::createN(2);
+
+	if (algorithm == MaxPrefixSumSinglePass) {
+		gpu_mem_32u counter			= gpu_mem_32u::createN(1);
+		gpu_mem_32u flags			= gpu_mem_32u::createN(nblocks);
+		gpu_mem_32i prefix_sums		= gpu_mem_32i::createN(nblocks);
+		gpu_mem_32i prefix_bests	= gpu_mem_32i::createN(nblocks);
+		gpu_mem_32u prefix_ends		= gpu_mem_32u::createN(nblocks);
+
+		max_prefix_sum_programs.kernel("max_prefix_sum_reset", defines).exec(
+				WorkSize(max_prefix_sum_workgroup_size, nblocks), counter, flags, nblocks);
+		max_prefix_sum_programs.kernel("max_prefix_sum_single_pass", defines).exec(ws,
+				values, (unsigned int) n, counter, flags,
+				aggregate_sums, aggregate_bests, aggregate_ends,
+				prefix_sums, prefix_bests, prefix_ends, result);
+	} else if (algorithm == MaxPrefixSumTwoPass) {
+		max_prefix_sum_programs.kernel("max_prefix_sum_blocks", defines).exec(ws,
+				values, (unsigned int) n, aggregate_sums, aggregate_bests, aggregate_ends);
+		max_prefix_sum_programs.kernel("max_prefix_sum_combine", defines).exec(
+				WorkSize(max_prefix_sum_workgroup_size, max_prefix_sum_workgroup_size),
+				aggregate_sums, aggregate_bests, aggregate_ends, nblocks, result);
+	} else {
+		throw gpu_exception("Unknown max prefix sum algorithm " + to_string((int) algorithm) + "!");
+	}
+
+	int sum_and_length[2];
+	result.readN(sum_and_length, 2);
+	if (length)
+		*length = (unsigned int) sum_and_length[1];
+	return sum_and_length[0];
+}
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+enum MaxPrefixSumAlgorithm {
+	MaxPrefixSumSinglePass,	// one kernel, work groups chain their prefixes with decoupled lookback
+	MaxPrefixSumTwoPass		// aggregates of blocks, then one work group combines them
+};
+
+// Maximal sum over prefixes values[0], ..., values[len - 1] of first n values (whole buffer if n is not specified)
+// with the active context, empty prefix is included and gives 0. Length of the shortest prefix with that sum is stored into *length.
+// Both algorithms read every value exactly once, sums are accumulated in int, so they should fit into 32 bits.
+int maxPrefixSum(const gpu_mem_32i &values, unsigned int *length = NULL, MaxPrefixSumAlgorithm algorithm = MaxPrefixSumSinglePass);
+
+int maxPrefixSum(const gpu_mem_32i &values, size_t n, unsigned int *length = NULL, MaxPrefixSumAlgorithm algorithm = MaxPrefixSumSinglePass);
+
+}
@@ -0,0 +1,256 @@
+#include "multi_device_executor.h"
+#include "context.h"
+
+#include <libgpu/opencl/utils.h>
+#include <libutils/timer.h>
+
+#include <thread>
+#include <algorithm>
+#include <mutex>
+#include <exception>
+#include <condition_variable>
+
+namespace gpu {
+
+// Throughput measured on the latest run is mixed with the previous estimate to damp noise of short runs
+static const double throughput_smoothing = 0.5;
+
+class MultiDeviceExecutor::Worker {
+public:
+	Worker(const Device &device) : device_(device), has_job_(false), stop_(false), elapsed_(0.0)
+	{
+		thread_ = std::thread(&Worker::loop, this);
+	}
+
+	~Worker()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		cv_.notify_all();
+		thread_.join();
+	}
+
+	void submit(const std::function<void()> &job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			job_		= job;
+			has_job_	= true;
+			error_		= std::exception_ptr();
+		}
+		cv_.notify_all();
+	}
+
+	// Returns time spent on the job in seconds, rethrows its error
+	double wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		cv_.wait(lock, [this] { return !has_job_; });
+		if (error_)
+			std::rethrow_exception(error_);
+		return elapsed_;
+	}
+
+protected:
+	void loop()
+	{
+		// context lives in the worker thread, so that it is activated and destroyed there
+		Context context;
+
+		std::unique_lock<std::mutex> lock(mutex_);
+		while (true) {
+			cv_.wait(lock, [this] { return has_job_ || stop_; });
+			if (stop_)
+				break;
+
+			std::function<void()> job = job_;
+			lock.unlock();
+
+			std::exception_ptr error;
+			double elapsed = 0.0;
+			try {
+				if (!context.isInitialized()) {
+					context.init(device_.device_id_opencl);
+					context.activate();
+				}
+
+				timer t;
+				job();
+				// kernel launches are asynchronous, so device time includes everything left in the queue
+				OCL_SAFE_CALL(clFinish(context.cl()->queue()));
+				elapsed = t.elapsed();
+			} catch (...) {
+				error = std::current_exception();
+			}
+
+			lock.lock();
+			job_		= std::function<void()>();
+			has_job_	= false;
+			error_		= error;
+			elapsed_	= elapsed;
+			cv_.notify_all();
+		}
+	}
+
+	Device					device_;
+
+	std::thread				thread_;
+	std::mutex				mutex_;
+	std::condition_variable	cv_;
+	std::function<void()>	job_;
+	bool					has_job_;
+	bool					stop_;
+	std::exception_ptr		error_;
+	double					elapsed_;
+};
+
+MultiDeviceExecutor::MultiDeviceExecutor()
+{
+	std::vector<Device> devices = enumDevices();
+
+	std::vector<Device> opencl_devices;
+	for (size_t k = 0; k < devices.size(); ++k) {
+		if (devices[k].supports_opencl)
+			opencl_devices.push_back(devices[k]);
+	}
+
+	init(opencl_devices);
+}
+
+MultiDeviceExecutor::MultiDeviceExecutor(const std::vector<Device> &devices)
+{
+	init(devices);
+}
+
+MultiDeviceExecutor::~MultiDeviceExecutor()
+{
+	for (size_t k = 0; k < workers_.size(); ++k)
+		delete workers_[k];
+}
+
+void MultiDeviceExecutor::init(const std::vector<Device> &devices)
+{
+	if (devices.empty())
+		throw gpu_exception("No OpenCL devices found!");
+
+	for (size_t k = 0; k < devices.size(); ++k) {
+		if (!devices[k].supports_opencl)
+			throw gpu_exception("Device " + devices[k].name + " does not support OpenCL!");
+	}
+
+	devices_		= devices;
+	shares_			= std::vector<double>(devices.size(), 1.0 / devices.size());
+	throughputs_	= std::vector<double>(devices.size(), 0.0);
+
+	for (size_t k = 0; k < devices.size(); ++k)
+		workers_.push_back(new Worker(devices[k]));
+}
+
+void MultiDeviceExecutor::waitAll()
+{
+	std::exception_ptr error;
+	for (size_t k = 0; k < workers_.size(); ++k) {
+		try {
+			workers_[k]->wait();
+		} catch (...) {
+			if (!error)
+				error = std::current_exception();
+		}
+	}
+	if (error)
+		std::rethrow_exception(error);
+}
+
+void MultiDeviceExecutor::runOnEach(const DeviceTask &task)
+{
+	for (size_t k = 0; k < workers_.size(); ++k)
+		workers_[k]->submit(std::bind(task, k));
+	waitAll();
+}
+
+void MultiDeviceExecutor::run(size_t n, size_t granularity, const Task &task)
+{
+	if (granularity == 0)
+		throw gpu_exception("Granularity should be positive!");
+
+	size_t ndevices	= workers_.size();
+	size_t nchunks	= divup(n, granularity);
+
+	// split chunks proportionally to shares, leftovers go to devices with the largest fractional parts
+	std::vector<size_t> chunks(ndevices);
+	std::vector<double> remainders(ndevices);
+	size_t assigned = 0;
+	for (size_t k = 0; k < ndevices; ++k) {
+		double exact	= shares_[k] * nchunks;
+		chunks[k]		= std::min((size_t) exact, nchunks - assigned);
+		remainders[k]	= exact - chunks[k];
+		assigned		+= chunks[k];
+	}
+	while (assigned < nchunks) {
+		size_t best = 0;
+		for (size_t k = 1; k < ndevices; ++k) {
+			if (remainders[k] > remainders[best])
+				best = k;
+		}
+		++chunks[best];
+		remainders[best] -= 1.0;
+		++assigned;
+	}
+
+	std::vector<size_t> counts(ndevices, 0);
+	size_t offset = 0;
+	for (size_t k = 0; k < ndevices; ++k) {
+		size_t count = std::min(chunks[k] * granularity, n - offset);
+		counts[k] = count;
+		if (count > 0)
+			workers_[k]->submit(std::bind(task, k, offset, count));
+		offset += count;
+	}
+
+	std::exception_ptr error;
+	for (size_t k = 0; k < ndevices; ++k) {
+		if (counts[k] == 0)
+			continue;
+
+		try {
+			double elapsed = workers_[k]->wait();
+			if (elapsed > 0.0) {
+				double throughput = counts[k] / elapsed;
+				if (throughputs_[k] > 0.0)
+					throughput = throughput_smoothing * throughput + (1.0 - throughput_smoothing) * throughputs_[k];
+				throughputs_[k] = throughput;
+			}
+		} catch (...) {
+			if (!error)
+				error = std::current_exception();
+		}
+	}
+	if (error)
+		std::rethrow_exception(error);
+
+	updateShares();
+}
+
+void MultiDeviceExecutor::updateShares()
+{
+	double known_sum = 0.0;
+	size_t known = 0;
+	for (size_t k = 0; k < throughputs_.size(); ++k) {
+		if (throughputs_[k] > 0.0) {
+			known_sum += throughputs_[k];
+			++known;
+		}
+	}
+	if (known == 0)
+		return;
+
+	// devices that were not measured yet are assumed to be as fast as an average measured device
+	double unknown = known_sum / known;
+	double total = known_sum + unknown * (throughputs_.size() - known);
+	for (size_t k = 0; k < throughputs_.size(); ++k)
+		shares_[k] = (throughputs_[k] > 0.0 ? throughputs_[k] : unknown) / total;
+}
+
+}
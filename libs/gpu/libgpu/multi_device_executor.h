@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <libgpu/device.h>
+
+namespace gpu {
+
+// Executes one range of work on several OpenCL devices at once (e.g. CPU OpenCL runtime and a GPU).
+// Every device is served by its own worker thread with its own activated Context, so the task can use
+// ocl::Kernel and gpu buffers as usual. Range is split between devices proportionally to the throughput
+// measured on previous calls of run(), so repeated calls (iterations, frames) converge to a split
+// with which all devices finish at the same time.
+class MultiDeviceExecutor {
+public:
+	// Called in the worker thread of device #device_index, should process items [offset, offset + count)
+	// and read results back into the host memory of the caller - that is how results of all devices are merged
+	typedef std::function<void(size_t device_index, size_t offset, size_t count)>	Task;
+	typedef std::function<void(size_t device_index)>								DeviceTask;
+
+	MultiDeviceExecutor();	// uses all OpenCL devices from enumDevices()
+	explicit MultiDeviceExecutor(const std::vector<Device> &devices);
+	~MultiDeviceExecutor();
+
+	size_t			devicesCount() const	{ return devices_.size();	}
+	const Device &	device(size_t index) const	{ return devices_[index];	}
+
+	// Splits [0, n) into parts with sizes multiple of granularity and processes them on all devices in parallel.
+	// For 1D NDRange granularity is usually the work group size, for 2D NDRange the range is split by rows
+	// and granularity is the work group height. Returns after all devices finished, rethrows the first error.
+	void			run(size_t n, size_t granularity, const Task &task);
+
+	// Calls task once in the worker thread of every device, e.g. to compile kernels or allocate per-device buffers
+	void			runOnEach(const DeviceTask &task);
+
+	// Fraction of the range that device will get in the next run() and its last measured throughput (items per second)
+	double			share(size_t index) const		{ return shares_[index];		}
+	double			throughput(size_t index) const	{ return throughputs_[index];	}
+
+protected:
+	class Worker;
+
+	void			init(const std::vector<Device> &devices);
+	void			waitAll();
+	void			updateShares();
+
+	std::vector<Device>		devices_;
+	std::vector<Worker *>	workers_;
+	std::vector<double>		shares_;
+	std::vector<double>		throughputs_;	// 0 if device has not processed anything yet
+
+private:
+	MultiDeviceExecutor(const MultiDeviceExecutor &);
+	MultiDeviceExecutor &operator= (const MultiDeviceExecutor &);
+};
+
+}
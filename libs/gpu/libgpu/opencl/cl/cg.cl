@@ -0,0 +1,177 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define T float
+#define WORKGROUP_SIZE 256
+#endif
+
+#line 8
+
+// Compiled by gpu::conjugateGradient for each value type T, see libgpu/cg.cpp.
+// Jacobi-preconditioned conjugate gradient: all vectors stay on device, scalars of the iteration (alpha, beta) are never read
+// back to host - every kernel sums partial dot products of work groups of the previous kernel itself.
+// Dot products are reduced into per-group partials: every work group walks vectors with stride of the whole NDRange.
+
+#ifdef T_IS_DOUBLE
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+
+// Tree reduction of one value per work item, result is returned to all work items of the group
+T reduce_group(T value, __local T *scratch)
+{
+	const unsigned int local_id = get_local_id(0);
+	scratch[local_id] = value;
+	barrier(CLK_LOCAL_MEM_FENCE);
+	for (unsigned int offset = WORKGROUP_SIZE / 2; offset > 0; offset /= 2) {
+		if (local_id < offset)
+			scratch[local_id] += scratch[local_id + offset];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+	T result = scratch[0];
+	// scratch can be reused right after return
+	barrier(CLK_LOCAL_MEM_FENCE);
+	return result;
+}
+
+// Sum of partials of the previous kernel (there are at most a few hundred of them), returned to all work items
+T sum_partials(__global const T *partials, unsigned int npartials, __local T *scratch)
+{
+	T sum = 0;
+	for (unsigned int i = get_local_id(0); i < npartials; i += WORKGROUP_SIZE)
+		sum += partials[i];
+	return reduce_group(sum, scratch);
+}
+
+// Diagonal preconditioner M^-1 = 1 / diag(A), rows without diagonal element (or with zero on diagonal) are not preconditioned
+__kernel void cg_inverse_diagonal(__global const unsigned int *row_offsets,
+								  __global const unsigned int *column_indices,
+								  __global const T *values,
+								  unsigned int n,
+								  __global T *inverse_diagonal)
+{
+	const unsigned int row = get_global_id(0);
+	if (row >= n)
+		return;
+
+	T diagonal = 0;
+	for (unsigned int j = row_offsets[row]; j < row_offsets[row + 1]; ++j) {
+		if (column_indices[j] == row)
+			diagonal += values[j];
+	}
+	inverse_diagonal[row] = diagonal != 0 ? 1 / diagonal : 1;
+}
+
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void cg_dot(__global const T *a,
+			__global const T *b,
+			unsigned int n,
+			__global T *partials)
+{
+	__local T scratch[WORKGROUP_SIZE];
+
+	T sum = 0;
+	for (unsigned int i = get_global_id(0); i < n; i += get_global_size(0))
+		sum += a[i] * b[i];
+	sum = reduce_group(sum, scratch);
+	if (get_local_id(0) == 0)
+		partials[get_group_id(0)] = sum;
+}
+
+// r = b - A * x (A * x is already in r), z = M^-1 * r, p = z, partials of r * z and r * r
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void cg_init(__global const T *b,
+			 __global const T *inverse_diagonal,
+			 __global T *r,
+			 __global T *z,
+			 __global T *p,
+			 unsigned int n,
+			 __global T *rz_partials,
+			 __global T *rr_partials)
+{
+	__local T scratch[WORKGROUP_SIZE];
+
+	T rz = 0;
+	T rr = 0;
+	for (unsigned int i = get_global_id(0); i < n; i += get_global_size(0)) {
+		T ri = b[i] - r[i];
+		T zi = inverse_diagonal[i] * ri;
+		r[i] = ri;
+		z[i] = zi;
+		p[i] = zi;
+		rz += ri * zi;
+		rr += ri * ri;
+	}
+	rz = reduce_group(rz, scratch);
+	rr = reduce_group(rr, scratch);
+	if (get_local_id(0) == 0) {
+		rz_partials[get_group_id(0)] = rz;
+		rr_partials[get_group_id(0)] = rr;
+	}
+}
+
+// alpha = (r * z) / (p * q), x += alpha * p, r -= alpha * q, z = M^-1 * r, partials of new r * z and r * r
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void cg_update(__global T *x,
+			   __global T *r,
+			   __global T *z,
+			   __global const T *p,
+			   __global const T *q,
+			   __global const T *inverse_diagonal,
+			   unsigned int n,
+			   unsigned int npartials,
+			   __global const T *rz_partials,
+			   __global const T *pq_partials,
+			   __global T *new_rz_partials,
+			   __global T *rr_partials)
+{
+	__local T scratch[WORKGROUP_SIZE];
+
+	const T rz_old = sum_partials(rz_partials, npartials, scratch);
+	const T pq = sum_partials(pq_partials, npartials, scratch);
+	const T alpha = rz_old / pq;
+
+	T rz = 0;
+	T rr = 0;
+	for (unsigned int i = get_global_id(0); i < n; i += get_global_size(0)) {
+		x[i] += alpha * p[i];
+		T ri = r[i] - alpha * q[i];
+		T zi = inverse_diagonal[i] * ri;
+		r[i] = ri;
+		z[i] = zi;
+		rz += ri * zi;
+		rr += ri * ri;
+	}
+	rz = reduce_group(rz, scratch);
+	rr = reduce_group(rr, scratch);
+	if (get_local_id(0) == 0) {
+		new_rz_partials[get_group_id(0)] = rz;
+		rr_partials[get_group_id(0)] = rr;
+	}
+}
+
+// beta = (new r * z) / (old r * z), p = z + beta * p. The first work group also sums partials of r * r - the only value
+// host reads back every iteration to check convergence
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void cg_direction(__global T *p,
+				  __global const T *z,
+				  unsigned int n,
+				  unsigned int npartials,
+				  __global const T *rz_partials,
+				  __global const T *new_rz_partials,
+				  __global const T *rr_partials,
+				  __global T *rr)
+{
+	__local T scratch[WORKGROUP_SIZE];
+
+	const T rz_old = sum_partials(rz_partials, npartials, scratch);
+	const T rz_new = sum_partials(new_rz_partials, npartials, scratch);
+	const T beta = rz_new / rz_old;
+
+	for (unsigned int i = get_global_id(0); i < n; i += get_global_size(0))
+		p[i] = z[i] + beta * p[i];
+
+	if (get_group_id(0) == 0) {
+		T sum = sum_partials(rr_partials, npartials, scratch);
+		if (get_local_id(0) == 0)
+			rr[0] = sum;
+	}
+}
@@ -7,8 +7,15 @@
 #include <libclew/CL/cl_platform.h>
 #include <libutils/types.h>
 #else
+// common.cl can be prepended to kernel sources at runtime (see common_kernel in libs/gpu/CMakeLists.txt),
+// clion_defines.cl is needed only for IDE
+#ifdef __CLION_IDE__
 #include "clion_defines.cl"
 #endif
+#ifndef STATIC_KEYWORD
+#define STATIC_KEYWORD
+#endif
+#endif
 
 //#define DEBUG
 
@@ -422,6 +429,93 @@ typedef struct {
 		return x * x * x * (x * (x * 6.0f - 15.0f) + 10.0f);
 	}
 
+	// Double-float arithmetic: value is x + y of float2, where |y| <= ulp(x) / 2, it gives ~48 bits of mantissa
+	// on devices without cl_khr_fp64 (but keeps float exponent range). Error-free transformations below are correct
+	// only if a * b + c is not contracted into FMA, so contraction is disabled in every function.
+	// Products use Dekker's splitting instead of fma(), which is emulated in software on some devices.
+
+	STATIC_KEYWORD float2 df_from_float(float a)
+	{
+		return make_float2(a, 0.0f);
+	}
+
+	STATIC_KEYWORD float df_to_float(float2 a)
+	{
+		return a.x + a.y;
+	}
+
+	STATIC_KEYWORD float2 df_quick_two_sum(float a, float b)
+	{
+		#pragma OPENCL FP_CONTRACT OFF
+		float s = a + b;
+		float e = b - (s - a);
+		return make_float2(s, e);
+	}
+
+	STATIC_KEYWORD float2 df_two_sum(float a, float b)
+	{
+		#pragma OPENCL FP_CONTRACT OFF
+		float s = a + b;
+		float bb = s - a;
+		float e = (a - (s - bb)) + (b - bb);
+		return make_float2(s, e);
+	}
+
+	STATIC_KEYWORD float2 df_split(float a)
+	{
+		#pragma OPENCL FP_CONTRACT OFF
+		float t = 4097.0f * a;
+		float hi = t - (t - a);
+		return make_float2(hi, a - hi);
+	}
+
+	STATIC_KEYWORD float2 df_two_prod(float a, float b)
+	{
+		#pragma OPENCL FP_CONTRACT OFF
+		float p = a * b;
+		float2 as = df_split(a);
+		float2 bs = df_split(b);
+		float e = ((as.x * bs.x - p) + as.x * bs.y + as.y * bs.x) + as.y * bs.y;
+		return make_float2(p, e);
+	}
+
+	STATIC_KEYWORD float2 df_add(float2 a, float2 b)
+	{
+		#pragma OPENCL FP_CONTRACT OFF
+		float2 s = df_two_sum(a.x, b.x);
+		float2 t = df_two_sum(a.y, b.y);
+		s.y += t.x;
+		s = df_quick_two_sum(s.x, s.y);
+		s.y += t.y;
+		return df_quick_two_sum(s.x, s.y);
+	}
+
+	STATIC_KEYWORD float2 df_neg(float2 a)
+	{
+		return make_float2(-a.x, -a.y);
+	}
+
+	STATIC_KEYWORD float2 df_sub(float2 a, float2 b)
+	{
+		return df_add(a, df_neg(b));
+	}
+
+	STATIC_KEYWORD float2 df_mul(float2 a, float2 b)
+	{
+		#pragma OPENCL FP_CONTRACT OFF
+		float2 p = df_two_prod(a.x, b.x);
+		p.y += a.x * b.y + a.y * b.x;
+		return df_quick_two_sum(p.x, p.y);
+	}
+
+	STATIC_KEYWORD float2 df_mul_float(float2 a, float b)
+	{
+		#pragma OPENCL FP_CONTRACT OFF
+		float2 p = df_two_prod(a.x, b);
+		p.y += a.y * b;
+		return df_quick_two_sum(p.x, p.y);
+	}
+
 #endif
 
 #endif // pragma once
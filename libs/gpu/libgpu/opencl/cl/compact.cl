@@ -0,0 +1,112 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define T float
+#define WORKGROUP_SIZE 256
+bool compact_select(__global const T *values, unsigned int i) { const T x = values[i]; return x > 0.0f; }
+#include "scan_local.cl"
+#endif
+
+#line 10
+
+// Compiled by gpu::copyIf, gpu::partition, gpu::unique and gpu::runLengthEncode for each element type T and predicate,
+// see libgpu/compact.cpp. Function bool compact_select(__global const T *values, unsigned int i) comes from the header
+// made of the predicate: whether element i is selected (for unique and run-length encoding - whether it starts a run),
+// the header also includes scan_local.cl.
+// PARTITION puts not selected elements after the selected ones instead of dropping them,
+// WRITE_INDICES also stores indices of selected elements.
+
+#ifdef T_IS_DOUBLE
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+
+#define VALUES_PER_ITEM	4
+#define BLOCK_SIZE		(WORKGROUP_SIZE * VALUES_PER_ITEM)
+
+// Number of selected elements in every block of BLOCK_SIZE elements
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void compact_count(__global const T *values,
+				   unsigned int n,
+				   __global unsigned int *block_counts)
+{
+	__local unsigned int counts[WORKGROUP_SIZE];
+
+	const unsigned int local_id = get_local_id(0);
+	const unsigned int block_start = get_group_id(0) * BLOCK_SIZE;
+
+	unsigned int count = 0;
+	for (unsigned int k = 0; k < VALUES_PER_ITEM; ++k) {
+		unsigned int i = block_start + k * WORKGROUP_SIZE + local_id;
+		if (i < n && compact_select(values, i))
+			++count;
+	}
+	counts[local_id] = count;
+
+	for (unsigned int d = WORKGROUP_SIZE / 2; d > 0; d /= 2) {
+		barrier(CLK_LOCAL_MEM_FENCE);
+		if (local_id < d)
+			counts[local_id] += counts[local_id + d];
+	}
+
+	if (local_id == 0)
+		block_counts[get_group_id(0)] = counts[0];
+}
+
+// Writes selected elements of every block after selected elements of previous blocks, keeping their order. Block ends are
+// inclusive scan of block counts, so the block starts from block_ends[block - 1].
+// Work item handles VALUES_PER_ITEM consecutive elements, so its rank is the scan of counts of preceding work items in the block.
+// With PARTITION not selected element i goes to total_selected + (i - selected elements before i).
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void compact_scatter(__global const T *values,
+					 unsigned int n,
+					 __global const unsigned int *block_ends,
+					 unsigned int total_selected,
+					 __global T *result,
+					 __global unsigned int *indices)
+{
+	__local unsigned int ranks[WORKGROUP_SIZE];
+
+	const unsigned int local_id = get_local_id(0);
+	const unsigned int first = get_group_id(0) * BLOCK_SIZE + local_id * VALUES_PER_ITEM;
+
+	bool selected[VALUES_PER_ITEM];
+	unsigned int count = 0;
+	for (unsigned int k = 0; k < VALUES_PER_ITEM; ++k) {
+		selected[k] = (first + k < n) && compact_select(values, first + k);
+		count += selected[k];
+	}
+	ranks[local_id] = count;
+
+	scan_local(ranks);
+
+	const unsigned int block = get_group_id(0);
+	unsigned int rank = (block > 0 ? block_ends[block - 1] : 0) + ranks[local_id];
+	for (unsigned int k = 0; k < VALUES_PER_ITEM; ++k) {
+		unsigned int i = first + k;
+		if (selected[k]) {
+			result[rank] = values[i];
+#ifdef WRITE_INDICES
+			indices[rank] = i;
+#endif
+			++rank;
+		}
+#ifdef PARTITION
+		else if (i < n) {
+			result[total_selected + i - rank] = values[i];
+		}
+#endif
+	}
+}
+
+// Lengths of runs from their starts: the run ends where the next one starts or at the end of data
+__kernel void run_lengths(__global const unsigned int *starts,
+						  unsigned int nruns,
+						  unsigned int n,
+						  __global unsigned int *lengths)
+{
+	const unsigned int k = get_global_id(0);
+	if (k >= nruns)
+		return;
+
+	unsigned int end = (k + 1 < nruns) ? starts[k + 1] : n;
+	lengths[k] = end - starts[k];
+}
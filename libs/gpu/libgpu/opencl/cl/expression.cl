@@ -0,0 +1,80 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define T float
+#define VECTOR_WIDTH 4
+#define EXPRESSION_PARAMETERS , __global const T *in0, __global const T *in1, T s0
+#define EXPRESSION_LOAD(TYPE, LOAD) const TYPE x0 = LOAD(in0); const TYPE x1 = LOAD(in1); const TYPE c0 = (TYPE) s0;
+#define EXPRESSION ((x0 * c0) + sqrt(x1))
+#endif
+
+#line 11
+
+// Compiled by gpu::eval for each element type T, expression and VECTOR_WIDTH, see libgpu/expression.cpp. The header generated for
+// the expression defines EXPRESSION_PARAMETERS - buffers in0, in1, ... and scalars s0, s1, ... of the expression,
+// EXPRESSION_LOAD(TYPE, LOAD) - loads of elements of the buffers into x0, x1, ... and scalars converted to TYPE c0, c1, ...,
+// and EXPRESSION - value of the expression of these variables. So the same expression is computed both for scalars T
+// and for vectors of VECTOR_WIDTH elements (scalars are broadcast, so that built-in functions get arguments of the same type).
+// PROMOTE_TO_INT is defined for 8 and 16-bit integer T.
+
+#ifdef T_IS_DOUBLE
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+
+#define CONCAT_(a, b)	a ## b
+#define CONCAT(a, b)	CONCAT_(a, b)
+
+#define LOAD_SCALAR(p)	p[i]
+
+#if VECTOR_WIDTH > 1
+
+#define TV				CONCAT(T, VECTOR_WIDTH)
+#define VLOAD			CONCAT(vload, VECTOR_WIDTH)
+#define VSTORE			CONCAT(vstore, VECTOR_WIDTH)
+
+// In scalar code 8 and 16-bit integers are promoted to int, while vector arithmetic wraps at the width of elements,
+// so such vectors are converted to int vectors for computation and back for the store - as the scalar tail does implicitly
+#ifdef PROMOTE_TO_INT
+#define TC				CONCAT(int, VECTOR_WIDTH)
+#define LOAD_VECTOR(p)	CONCAT(convert_, TC)(VLOAD(v, p))
+#define STORE_VECTOR(x)	VSTORE(CONCAT(convert_, TV)(x), v, result)
+#else
+#define TC				TV
+#define LOAD_VECTOR(p)	VLOAD(v, p)
+#define STORE_VECTOR(x)	VSTORE(x, v, result)
+#endif
+
+// Every work item computes VECTOR_WIDTH consecutive elements with vector loads and stores (vloadN/vstoreN need only alignment
+// of elements, so buffers and n can be arbitrary), the work item after the last whole vector computes the remaining elements one by one.
+// Vector types map onto SIMD lanes of CPU devices, and on GPUs wider loads need fewer memory transactions.
+__kernel void expression_eval(__global T *result,
+							  unsigned int n
+							  EXPRESSION_PARAMETERS)
+{
+	const unsigned int v = get_global_id(0);
+	const unsigned int nvectors = n / VECTOR_WIDTH;
+	if (v < nvectors) {
+		EXPRESSION_LOAD(TC, LOAD_VECTOR)
+		STORE_VECTOR(EXPRESSION);
+	} else if (v == nvectors) {
+		for (unsigned int i = nvectors * VECTOR_WIDTH; i < n; ++i) {
+			EXPRESSION_LOAD(T, LOAD_SCALAR)
+			result[i] = EXPRESSION;
+		}
+	}
+}
+
+#else
+
+__kernel void expression_eval(__global T *result,
+							  unsigned int n
+							  EXPRESSION_PARAMETERS)
+{
+	const unsigned int i = get_global_id(0);
+	if (i >= n)
+		return;
+
+	EXPRESSION_LOAD(T, LOAD_SCALAR)
+	result[i] = EXPRESSION;
+}
+
+#endif
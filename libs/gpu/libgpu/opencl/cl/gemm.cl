@@ -0,0 +1,155 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define T float
+#define T4 float4
+#define TILE_M 64
+#define TILE_N 64
+#define TILE_K 16
+#define ITEM_M 4
+#define ITEM_N 4
+#endif
+
+#line 13
+
+// Compiled by gpu::gemm for each element type T, tile sizes and transpose flags, see libgpu/gemm.cpp.
+// C = alpha * op(A) * op(B) + beta * C for row-major matrices, op(A) is m x k, op(B) is k x n.
+// TRANSPOSE_A/TRANSPOSE_B - A is stored as k x m / B is stored as n x k.
+// VECTOR_LOADS - sizes are multiples of tiles and leading dimensions are multiples of 4,
+// then tiles are loaded with vload4 without bound checks.
+
+#ifdef T_IS_DOUBLE
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+
+// Work group computes TILE_M x TILE_N block of C, work item computes ITEM_M x ITEM_N elements of it in registers:
+// rows ty + i * GROUP_M and columns tx + j * GROUP_N, so that neighbouring work items read neighbouring elements of tiles
+// and write neighbouring elements of C
+#define GROUP_M		(TILE_M / ITEM_M)
+#define GROUP_N		(TILE_N / ITEM_N)
+#define GROUP_SIZE	(GROUP_M * GROUP_N)
+
+// Tiles are stored as [TILE_K][TILE_X + TILE_PAD]: row of the tile is what all work items need at one step of k
+#define TILE_PAD	1
+
+// Loads TILE_K x X tile starting from (x0, k0) of matrix, in which element (x, k) is src[x * ld + k], into tile[k][x].
+// Elements out of x_size x k_size are zeros
+void load_tile_k_contiguous(__global const T *src, unsigned int ld,
+							unsigned int x0, unsigned int k0, unsigned int x_size, unsigned int k_size,
+							__local T *tile, const unsigned int X)
+{
+	const unsigned int local_id = get_local_id(1) * GROUP_N + get_local_id(0);
+#ifdef VECTOR_LOADS
+	for (unsigned int q = local_id; q < X * TILE_K / 4; q += GROUP_SIZE) {
+		unsigned int x = q / (TILE_K / 4);
+		unsigned int k = (q % (TILE_K / 4)) * 4;
+		T4 v = vload4(0, src + (x0 + x) * ld + k0 + k);
+		tile[(k + 0) * (X + TILE_PAD) + x] = v.x;
+		tile[(k + 1) * (X + TILE_PAD) + x] = v.y;
+		tile[(k + 2) * (X + TILE_PAD) + x] = v.z;
+		tile[(k + 3) * (X + TILE_PAD) + x] = v.w;
+	}
+#else
+	for (unsigned int e = local_id; e < X * TILE_K; e += GROUP_SIZE) {
+		unsigned int x = e / TILE_K;
+		unsigned int k = e % TILE_K;
+		tile[k * (X + TILE_PAD) + x] = (x0 + x < x_size && k0 + k < k_size) ? src[(x0 + x) * ld + k0 + k] : 0;
+	}
+#endif
+}
+
+// The same for matrix, in which element (x, k) is src[k * ld + x]
+void load_tile_x_contiguous(__global const T *src, unsigned int ld,
+							unsigned int x0, unsigned int k0, unsigned int x_size, unsigned int k_size,
+							__local T *tile, const unsigned int X)
+{
+	const unsigned int local_id = get_local_id(1) * GROUP_N + get_local_id(0);
+#ifdef VECTOR_LOADS
+	for (unsigned int q = local_id; q < X * TILE_K / 4; q += GROUP_SIZE) {
+		unsigned int k = q / (X / 4);
+		unsigned int x = (q % (X / 4)) * 4;
+		T4 v = vload4(0, src + (k0 + k) * ld + x0 + x);
+		tile[k * (X + TILE_PAD) + x + 0] = v.x;
+		tile[k * (X + TILE_PAD) + x + 1] = v.y;
+		tile[k * (X + TILE_PAD) + x + 2] = v.z;
+		tile[k * (X + TILE_PAD) + x + 3] = v.w;
+	}
+#else
+	for (unsigned int e = local_id; e < X * TILE_K; e += GROUP_SIZE) {
+		unsigned int k = e / X;
+		unsigned int x = e % X;
+		tile[k * (X + TILE_PAD) + x] = (x0 + x < x_size && k0 + k < k_size) ? src[(k0 + k) * ld + x0 + x] : 0;
+	}
+#endif
+}
+
+__kernel __attribute__((reqd_work_group_size(GROUP_N, GROUP_M, 1)))
+void gemm(unsigned int m,
+		  unsigned int n,
+		  unsigned int k,
+		  T alpha,
+		  __global const T *a,
+		  unsigned int lda,
+		  __global const T *b,
+		  unsigned int ldb,
+		  T beta,
+		  __global T *c,
+		  unsigned int ldc)
+{
+	__local T a_tile[TILE_K * (TILE_M + TILE_PAD)];
+	__local T b_tile[TILE_K * (TILE_N + TILE_PAD)];
+
+	const unsigned int tx = get_local_id(0);
+	const unsigned int ty = get_local_id(1);
+	const unsigned int m0 = get_group_id(1) * TILE_M;
+	const unsigned int n0 = get_group_id(0) * TILE_N;
+
+	T acc[ITEM_M][ITEM_N];
+	for (unsigned int i = 0; i < ITEM_M; ++i)
+		for (unsigned int j = 0; j < ITEM_N; ++j)
+			acc[i][j] = 0;
+
+	for (unsigned int k0 = 0; k0 < k; k0 += TILE_K) {
+		// previous tiles are still read by other work items
+		barrier(CLK_LOCAL_MEM_FENCE);
+#ifdef TRANSPOSE_A
+		load_tile_x_contiguous(a, lda, m0, k0, m, k, a_tile, TILE_M);
+#else
+		load_tile_k_contiguous(a, lda, m0, k0, m, k, a_tile, TILE_M);
+#endif
+#ifdef TRANSPOSE_B
+		load_tile_k_contiguous(b, ldb, n0, k0, n, k, b_tile, TILE_N);
+#else
+		load_tile_x_contiguous(b, ldb, n0, k0, n, k, b_tile, TILE_N);
+#endif
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		#pragma unroll
+		for (unsigned int kk = 0; kk < TILE_K; ++kk) {
+			T a_regs[ITEM_M];
+			T b_regs[ITEM_N];
+			for (unsigned int i = 0; i < ITEM_M; ++i)
+				a_regs[i] = a_tile[kk * (TILE_M + TILE_PAD) + ty + i * GROUP_M];
+			for (unsigned int j = 0; j < ITEM_N; ++j)
+				b_regs[j] = b_tile[kk * (TILE_N + TILE_PAD) + tx + j * GROUP_N];
+			// not mad(): its precision is implementation-defined, while a * b + c is exact up to rounding and
+			// can be contracted into fma by the compiler (FP_CONTRACT is on by default)
+			for (unsigned int i = 0; i < ITEM_M; ++i)
+				for (unsigned int j = 0; j < ITEM_N; ++j)
+					acc[i][j] = a_regs[i] * b_regs[j] + acc[i][j];
+		}
+	}
+
+	for (unsigned int i = 0; i < ITEM_M; ++i) {
+		unsigned int row = m0 + ty + i * GROUP_M;
+		for (unsigned int j = 0; j < ITEM_N; ++j) {
+			unsigned int column = n0 + tx + j * GROUP_N;
+			if (row < m && column < n) {
+				// as in BLAS, C is not read if beta is zero, so it can be uninitialized
+				T value = alpha * acc[i][j];
+				if (beta != 0)
+					value += beta * c[row * ldc + column];
+				c[row * ldc + column] = value;
+			}
+		}
+	}
+}
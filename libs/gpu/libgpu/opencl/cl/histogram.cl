@@ -0,0 +1,139 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define T float
+#define T4 float4
+#define WORKGROUP_SIZE 256
+#define NBINS 256
+#define CHANNELS 1
+#define LOCAL_COPIES 8
+#endif
+
+#line 12
+
+// Compiled by gpu::histogram for each element type T, number of bins NBINS and of interleaved channels CHANNELS,
+// see libgpu/histogram.cpp. Bins of channel c are bins[c * NBINS, (c + 1) * NBINS), element i belongs to channel i % CHANNELS.
+// Values in [range_min, range_min + range_width) are split evenly into bins, other values are not counted.
+// INTEGER_VALUES - T is an integer type, then bin is computed in integers, ONE_VALUE_PER_BIN - range_width == NBINS,
+// then bin is just value - range_min (e.g. 8-bit images). Otherwise bin is (value - range_min) * range_scale.
+
+#ifdef T_IS_DOUBLE
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+
+#ifdef INTEGER_VALUES
+#define RANGE_ARGS	long range_min, ulong range_width
+#define RANGE		range_min, range_width
+#else
+#define RANGE_ARGS	T range_min, T range_scale
+#define RANGE		range_min, range_scale
+#endif
+
+// Bin of the value or NBINS if it is out of range
+unsigned int bin_of(T value, RANGE_ARGS)
+{
+#ifdef INTEGER_VALUES
+	long offset = (long) value - range_min;
+	if (offset < 0 || (ulong) offset >= range_width)
+		return NBINS;
+#ifdef ONE_VALUE_PER_BIN
+	return (unsigned int) offset;
+#else
+	return (unsigned int) (((ulong) offset * NBINS) / range_width);
+#endif
+#else
+	T position = (value - range_min) * range_scale;
+	// NaN fails both comparisons
+	if (!(position >= 0 && position < NBINS))
+		return NBINS;
+	return min((unsigned int) position, (unsigned int) (NBINS - 1));
+#endif
+}
+
+unsigned int channel_of(unsigned int i)
+{
+	return CHANNELS == 1 ? 0 : i % CHANNELS;
+}
+
+__kernel void histogram_clear(__global unsigned int *bins,
+							  unsigned int n)
+{
+	const unsigned int i = get_global_id(0);
+	if (i < n)
+		bins[i] = 0;
+}
+
+// Work groups go through the data with stride of the whole NDRange, every work item loads 4 values at once.
+// Every work group counts values in LOCAL_COPIES private histograms in local memory with local atomics - neighbouring
+// work items use different copies, so that runs of equal values (flat areas of images) don't serialize on one counter.
+// In the end copies are summed and added to the global histogram with one global atomic per non-empty bin.
+// LOCAL_COPIES is defined only if the copies fit into local memory.
+#ifdef LOCAL_COPIES
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void histogram_local(__global const T *values,
+					 unsigned int n,
+					 RANGE_ARGS,
+					 __global unsigned int *bins)
+{
+	__local unsigned int local_bins[LOCAL_COPIES * CHANNELS * NBINS];
+
+	const unsigned int local_id = get_local_id(0);
+	const unsigned int global_id = get_global_id(0);
+	const unsigned int global_size = get_global_size(0);
+
+	for (unsigned int b = local_id; b < LOCAL_COPIES * CHANNELS * NBINS; b += WORKGROUP_SIZE)
+		local_bins[b] = 0;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	__local unsigned int *copy = local_bins + (local_id % LOCAL_COPIES) * CHANNELS * NBINS;
+
+	for (unsigned int q = global_id; q < n / 4; q += global_size) {
+		T4 quad = vload4(q, values);
+		unsigned int bin;
+		bin = bin_of(quad.x, RANGE);	if (bin < NBINS) atomic_inc(&copy[channel_of(4 * q + 0) * NBINS + bin]);
+		bin = bin_of(quad.y, RANGE);	if (bin < NBINS) atomic_inc(&copy[channel_of(4 * q + 1) * NBINS + bin]);
+		bin = bin_of(quad.z, RANGE);	if (bin < NBINS) atomic_inc(&copy[channel_of(4 * q + 2) * NBINS + bin]);
+		bin = bin_of(quad.w, RANGE);	if (bin < NBINS) atomic_inc(&copy[channel_of(4 * q + 3) * NBINS + bin]);
+	}
+	if (global_id < n % 4) {
+		unsigned int i = n / 4 * 4 + global_id;
+		unsigned int bin = bin_of(values[i], RANGE);
+		if (bin < NBINS)
+			atomic_inc(&copy[channel_of(i) * NBINS + bin]);
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (unsigned int b = local_id; b < CHANNELS * NBINS; b += WORKGROUP_SIZE) {
+		unsigned int count = 0;
+		for (unsigned int c = 0; c < LOCAL_COPIES; ++c)
+			count += local_bins[c * CHANNELS * NBINS + b];
+		if (count > 0)
+			atomic_add(&bins[b], count);
+	}
+}
+#endif
+
+// Fallback for histograms that don't fit into local memory: global atomics right away
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void histogram_global(__global const T *values,
+					  unsigned int n,
+					  RANGE_ARGS,
+					  __global unsigned int *bins)
+{
+	const unsigned int global_id = get_global_id(0);
+	const unsigned int global_size = get_global_size(0);
+
+	for (unsigned int q = global_id; q < n / 4; q += global_size) {
+		T4 quad = vload4(q, values);
+		unsigned int bin;
+		bin = bin_of(quad.x, RANGE);	if (bin < NBINS) atomic_inc(&bins[channel_of(4 * q + 0) * NBINS + bin]);
+		bin = bin_of(quad.y, RANGE);	if (bin < NBINS) atomic_inc(&bins[channel_of(4 * q + 1) * NBINS + bin]);
+		bin = bin_of(quad.z, RANGE);	if (bin < NBINS) atomic_inc(&bins[channel_of(4 * q + 2) * NBINS + bin]);
+		bin = bin_of(quad.w, RANGE);	if (bin < NBINS) atomic_inc(&bins[channel_of(4 * q + 3) * NBINS + bin]);
+	}
+	if (global_id < n % 4) {
+		unsigned int i = n / 4 * 4 + global_id;
+		unsigned int bin = bin_of(values[i], RANGE);
+		if (bin < NBINS)
+			atomic_inc(&bins[channel_of(i) * NBINS + bin]);
+	}
+}
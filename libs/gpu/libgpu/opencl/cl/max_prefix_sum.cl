@@ -0,0 +1,256 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define WORKGROUP_SIZE 256
+#endif
+
+#line 7
+
+// Maximal prefix sum as reduction with monoid (sum, best, end) over a segment of values:
+// sum - sum of the whole segment, best - maximal sum over prefixes of the segment (empty prefix gives 0),
+// end - absolute index after the shortest prefix with that sum. Monoid is not commutative, so segments are always combined in order.
+
+#define VALUES_PER_ITEM	16
+#define BLOCK_SIZE		(WORKGROUP_SIZE * VALUES_PER_ITEM)
+
+#define FLAG_NOT_READY	0
+#define FLAG_AGGREGATE	1
+#define FLAG_PREFIX		2
+
+// Combines segment a with the following segment b, result is stored into a
+#define COMBINE(a_sum, a_best, a_end, b_sum, b_best, b_end) \
+	if (a_sum + b_best > a_best) { a_best = a_sum + b_best; a_end = b_end; } \
+	a_sum += b_sum;
+
+// Aggregate of block of values: items load the block into local memory with coalesced reads,
+// then each item reduces VALUES_PER_ITEM consecutive values and items are combined with an ordered tree.
+// Result is valid in the first work item only.
+void reduce_block(__global const int *values, unsigned int n, unsigned int block_id,
+				  __local int *block_values, __local int *sums, __local int *bests, __local unsigned int *ends,
+				  int *block_sum, int *block_best, unsigned int *block_end)
+{
+	const unsigned int local_id = get_local_id(0);
+	const unsigned int block_start = block_id * BLOCK_SIZE;
+
+	for (unsigned int k = 0; k < VALUES_PER_ITEM; ++k) {
+		unsigned int index = block_start + k * WORKGROUP_SIZE + local_id;
+		block_values[k * WORKGROUP_SIZE + local_id] = (index < n) ? values[index] : 0;
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// values after n are zeros, they never make prefix strictly better
+	int sum = 0;
+	int best = 0;
+	unsigned int end = block_start + local_id * VALUES_PER_ITEM;
+	for (unsigned int k = 0; k < VALUES_PER_ITEM; ++k) {
+		sum += block_values[local_id * VALUES_PER_ITEM + k];
+		if (sum > best) {
+			best = sum;
+			end = block_start + local_id * VALUES_PER_ITEM + k + 1;
+		}
+	}
+	sums[local_id]	= sum;
+	bests[local_id]	= best;
+	ends[local_id]	= end;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (unsigned int offset = 1; offset < WORKGROUP_SIZE; offset *= 2) {
+		unsigned int a = 2 * offset * local_id;
+		unsigned int b = a + offset;
+		if (b < WORKGROUP_SIZE) {
+			int a_sum = sums[a];
+			int a_best = bests[a];
+			unsigned int a_end = ends[a];
+			COMBINE(a_sum, a_best, a_end, sums[b], bests[b], ends[b]);
+			sums[a]		= a_sum;
+			bests[a]	= a_best;
+			ends[a]		= a_end;
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	*block_sum	= sums[0];
+	*block_best	= bests[0];
+	*block_end	= ends[0];
+}
+
+__kernel void max_prefix_sum_reset(__global unsigned int *counter,
+								   __global unsigned int *flags,
+								   unsigned int nblocks)
+{
+	const unsigned int index = get_global_id(0);
+	if (index == 0)
+		*counter = 0;
+	if (index < nblocks)
+		flags[index] = FLAG_NOT_READY;
+}
+
+// Single pass: every block publishes its aggregate, then looks back at the preceding blocks until it finds
+// a block with already known inclusive prefix (decoupled lookback), and publishes its own inclusive prefix.
+// Blocks take ids from atomic counter in order of their start, so that all preceding blocks are guaranteed to make progress.
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void max_prefix_sum_single_pass(__global const int *values,
+								unsigned int n,
+								__global volatile unsigned int *counter,
+								__global volatile unsigned int *flags,
+								__global volatile int *aggregate_sums,
+								__global volatile int *aggregate_bests,
+								__global volatile unsigned int *aggregate_ends,
+								__global volatile int *prefix_sums,
+								__global volatile int *prefix_bests,
+								__global volatile unsigned int *prefix_ends,
+								__global int *result)
+{
+	__local unsigned int block_id_shared;
+	__local int block_values[BLOCK_SIZE];
+	__local int sums[WORKGROUP_SIZE];
+	__local int bests[WORKGROUP_SIZE];
+	__local unsigned int ends[WORKGROUP_SIZE];
+
+	const unsigned int local_id = get_local_id(0);
+
+	if (local_id == 0)
+		block_id_shared = atomic_inc(counter);
+	barrier(CLK_LOCAL_MEM_FENCE);
+	const unsigned int block_id = block_id_shared;
+
+	int sum;
+	int best;
+	unsigned int end;
+	reduce_block(values, n, block_id, block_values, sums, bests, ends, &sum, &best, &end);
+
+	if (local_id != 0)
+		return;
+
+	if (block_id > 0) {
+		aggregate_sums[block_id]	= sum;
+		aggregate_bests[block_id]	= best;
+		aggregate_ends[block_id]	= end;
+		mem_fence(CLK_GLOBAL_MEM_FENCE);
+		atomic_xchg(&flags[block_id], FLAG_AGGREGATE);
+
+		// exclusive prefix of this block, accumulated from right to left
+		int excl_sum = 0;
+		int excl_best = 0;
+		unsigned int excl_end = 0;
+		for (unsigned int j = block_id - 1; ; --j) {
+			unsigned int flag;
+			while ((flag = atomic_or(&flags[j], 0)) == FLAG_NOT_READY) {
+			}
+			mem_fence(CLK_GLOBAL_MEM_FENCE);
+
+			int j_sum;
+			int j_best;
+			unsigned int j_end;
+			if (flag == FLAG_PREFIX) {
+				j_sum	= prefix_sums[j];
+				j_best	= prefix_bests[j];
+				j_end	= prefix_ends[j];
+			} else {
+				j_sum	= aggregate_sums[j];
+				j_best	= aggregate_bests[j];
+				j_end	= aggregate_ends[j];
+			}
+			COMBINE(j_sum, j_best, j_end, excl_sum, excl_best, excl_end);
+			excl_sum	= j_sum;
+			excl_best	= j_best;
+			excl_end	= j_end;
+
+			if (flag == FLAG_PREFIX)
+				break;
+		}
+
+		COMBINE(excl_sum, excl_best, excl_end, sum, best, end);
+		sum		= excl_sum;
+		best	= excl_best;
+		end		= excl_end;
+	}
+
+	prefix_sums[block_id]	= sum;
+	prefix_bests[block_id]	= best;
+	prefix_ends[block_id]	= end;
+	mem_fence(CLK_GLOBAL_MEM_FENCE);
+	atomic_xchg(&flags[block_id], FLAG_PREFIX);
+
+	if (block_id == get_num_groups(0) - 1) {
+		result[0] = best;
+		result[1] = (int) end;
+	}
+}
+
+// Two passes, first pass: aggregates of all blocks
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void max_prefix_sum_blocks(__global const int *values,
+						   unsigned int n,
+						   __global int *aggregate_sums,
+						   __global int *aggregate_bests,
+						   __global unsigned int *aggregate_ends)
+{
+	__local int block_values[BLOCK_SIZE];
+	__local int sums[WORKGROUP_SIZE];
+	__local int bests[WORKGROUP_SIZE];
+	__local unsigned int ends[WORKGROUP_SIZE];
+
+	const unsigned int block_id = get_group_id(0);
+
+	int sum;
+	int best;
+	unsigned int end;
+	reduce_block(values, n, block_id, block_values, sums, bests, ends, &sum, &best, &end);
+
+	if (get_local_id(0) == 0) {
+		aggregate_sums[block_id]	= sum;
+		aggregate_bests[block_id]	= best;
+		aggregate_ends[block_id]	= end;
+	}
+}
+
+// Two passes, second pass: single work group combines aggregates of all blocks in order
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void max_prefix_sum_combine(__global const int *aggregate_sums,
+							__global const int *aggregate_bests,
+							__global const unsigned int *aggregate_ends,
+							unsigned int nblocks,
+							__global int *result)
+{
+	__local int sums[WORKGROUP_SIZE];
+	__local int bests[WORKGROUP_SIZE];
+	__local unsigned int ends[WORKGROUP_SIZE];
+
+	const unsigned int local_id = get_local_id(0);
+
+	// each item combines consecutive range of blocks, so that the ranges are in order of items
+	const unsigned int per_item = (nblocks + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+	const unsigned int from = min(local_id * per_item, nblocks);
+	const unsigned int to = min(from + per_item, nblocks);
+
+	int sum = 0;
+	int best = 0;
+	unsigned int end = 0;
+	for (unsigned int j = from; j < to; ++j) {
+		COMBINE(sum, best, end, aggregate_sums[j], aggregate_bests[j], aggregate_ends[j]);
+	}
+	sums[local_id]	= sum;
+	bests[local_id]	= best;
+	ends[local_id]	= end;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (unsigned int offset = 1; offset < WORKGROUP_SIZE; offset *= 2) {
+		unsigned int a = 2 * offset * local_id;
+		unsigned int b = a + offset;
+		if (b < WORKGROUP_SIZE) {
+			int a_sum = sums[a];
+			int a_best = bests[a];
+			unsigned int a_end = ends[a];
+			COMBINE(a_sum, a_best, a_end, sums[b], bests[b], ends[b]);
+			sums[a]		= a_sum;
+			bests[a]	= a_best;
+			ends[a]		= a_end;
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (local_id == 0) {
+		result[0] = bests[0];
+		result[1] = (int) ends[0];
+	}
+}
@@ -0,0 +1,190 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define KEY_BITS uint
+#define KEY_ORDER 0
+#define RADIX_BITS 4
+#define WORKGROUP_SIZE 256
+#define HAS_VALUES
+#include "scan_local.cl"
+#endif
+
+#line 12
+
+// Compiled by gpu::radixSort for each key type, number of bits per pass and with or without values, see libgpu/radix_sort.cpp.
+// Keys are sorted as unsigned integers KEY_BITS (uint or ulong) after order-preserving transformation of their bits,
+// values are moved as uint bits. scan_local.cl is passed as a header.
+
+#define KEY_ORDER_UNSIGNED	0
+#define KEY_ORDER_SIGNED	1	// sign bit is flipped
+#define KEY_ORDER_FLOAT		2	// sign bit is flipped for positive numbers, all bits are flipped for negative ones
+
+#define VALUES_PER_ITEM	4
+#define BLOCK_SIZE		(WORKGROUP_SIZE * VALUES_PER_ITEM)
+#define BUCKETS			(1 << RADIX_BITS)
+
+#define KEY_WIDTH		(sizeof(KEY_BITS) * 8)
+#define SIGN_BIT		((KEY_BITS) 1 << (KEY_WIDTH - 1))
+
+KEY_BITS key_to_bits(KEY_BITS key)
+{
+#if KEY_ORDER == KEY_ORDER_SIGNED
+	return key ^ SIGN_BIT;
+#elif KEY_ORDER == KEY_ORDER_FLOAT
+	return (key & SIGN_BIT) ? ~key : (key ^ SIGN_BIT);
+#else
+	return key;
+#endif
+}
+
+KEY_BITS bits_to_key(KEY_BITS bits)
+{
+#if KEY_ORDER == KEY_ORDER_SIGNED
+	return bits ^ SIGN_BIT;
+#elif KEY_ORDER == KEY_ORDER_FLOAT
+	return (bits & SIGN_BIT) ? (bits ^ SIGN_BIT) : ~bits;
+#else
+	return bits;
+#endif
+}
+
+unsigned int digit_of(KEY_BITS bits, unsigned int shift)
+{
+	return (unsigned int) (bits >> shift) & (BUCKETS - 1);
+}
+
+// Histogram of digits of every block of BLOCK_SIZE keys, counted with local atomics. Counts are stored bucket-major:
+// counts[bucket * nblocks + block], so that their exclusive scan gives position in the output of the first key
+// of every (bucket, block) pair - keys of smaller buckets go first, keys of one bucket keep order of blocks.
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void radix_sort_count(__global const KEY_BITS *keys,
+					  unsigned int n,
+					  unsigned int shift,
+					  __global unsigned int *counts,
+					  unsigned int nblocks)
+{
+	__local unsigned int histogram[BUCKETS];
+
+	const unsigned int local_id = get_local_id(0);
+	const unsigned int block_id = get_group_id(0);
+
+	for (unsigned int b = local_id; b < BUCKETS; b += WORKGROUP_SIZE)
+		histogram[b] = 0;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (unsigned int k = 0; k < VALUES_PER_ITEM; ++k) {
+		unsigned int index = block_id * BLOCK_SIZE + k * WORKGROUP_SIZE + local_id;
+		if (index < n)
+			atomic_inc(&histogram[digit_of(key_to_bits(keys[index]), shift)]);
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (unsigned int b = local_id; b < BUCKETS; b += WORKGROUP_SIZE)
+		counts[b * nblocks + block_id] = histogram[b];
+}
+
+// Every work group sorts its block by the digit in local memory - RADIX_BITS stable splits by one bit, then keys
+// of every bucket are consecutive and are written to offsets[bucket * nblocks + block] + rank in the bucket.
+// Local sorting keeps the sort stable and makes writes of a bucket go to consecutive addresses.
+// Keys after n are replaced with all ones, so that they go to the end of the block and are not written.
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void radix_sort_scatter(__global const KEY_BITS *keys,
+						__global const unsigned int *values,
+						unsigned int n,
+						unsigned int shift,
+						__global const unsigned int *offsets,
+						unsigned int nblocks,
+						__global KEY_BITS *sorted_keys,
+						__global unsigned int *sorted_values)
+{
+	__local KEY_BITS bits_a[BLOCK_SIZE];
+	__local KEY_BITS bits_b[BLOCK_SIZE];
+#ifdef HAS_VALUES
+	__local unsigned int values_a[BLOCK_SIZE];
+	__local unsigned int values_b[BLOCK_SIZE];
+#endif
+	__local unsigned int zeros[WORKGROUP_SIZE];
+	__local unsigned int bucket_offsets[BUCKETS];
+	__local unsigned int bucket_starts[BUCKETS];
+
+	const unsigned int local_id = get_local_id(0);
+	const unsigned int block_id = get_group_id(0);
+	const unsigned int block_start = block_id * BLOCK_SIZE;
+	const unsigned int valid = min((unsigned int) BLOCK_SIZE, n - block_start);
+
+	for (unsigned int k = 0; k < VALUES_PER_ITEM; ++k) {
+		unsigned int i = k * WORKGROUP_SIZE + local_id;
+		bits_a[i] = (i < valid) ? key_to_bits(keys[block_start + i]) : ~((KEY_BITS) 0);
+#ifdef HAS_VALUES
+		values_a[i] = (i < valid) ? values[block_start + i] : 0;
+#endif
+	}
+	for (unsigned int b = local_id; b < BUCKETS; b += WORKGROUP_SIZE)
+		bucket_offsets[b] = offsets[b * nblocks + block_id];
+
+	__local KEY_BITS *src = bits_a;
+	__local KEY_BITS *dst = bits_b;
+#ifdef HAS_VALUES
+	__local unsigned int *src_values = values_a;
+	__local unsigned int *dst_values = values_b;
+#endif
+
+	// the last pass can reach beyond the key width, those bits are zeros anyway
+	for (unsigned int bit = shift; bit < shift + RADIX_BITS && bit < KEY_WIDTH; ++bit) {
+		// work item splits its VALUES_PER_ITEM consecutive keys, keys with zero bit go first
+		barrier(CLK_LOCAL_MEM_FENCE);
+		unsigned int item_zeros = 0;
+		for (unsigned int k = 0; k < VALUES_PER_ITEM; ++k)
+			item_zeros += ((src[local_id * VALUES_PER_ITEM + k] >> bit) & 1) == 0;
+		zeros[local_id] = item_zeros;
+
+		const unsigned int total_zeros = scan_local(zeros);
+
+		unsigned int zeros_before = zeros[local_id];
+		for (unsigned int k = 0; k < VALUES_PER_ITEM; ++k) {
+			unsigned int i = local_id * VALUES_PER_ITEM + k;
+			KEY_BITS bits = src[i];
+			unsigned int destination;
+			if (((bits >> bit) & 1) == 0) {
+				destination = zeros_before;
+				++zeros_before;
+			} else {
+				destination = total_zeros + i - zeros_before;
+			}
+			dst[destination] = bits;
+#ifdef HAS_VALUES
+			dst_values[destination] = src_values[i];
+#endif
+		}
+
+		__local KEY_BITS *t = src;
+		src = dst;
+		dst = t;
+#ifdef HAS_VALUES
+		__local unsigned int *t_values = src_values;
+		src_values = dst_values;
+		dst_values = t_values;
+#endif
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// keys of a bucket are consecutive now, rank of the key in its bucket is its distance to the first one
+	for (unsigned int k = 0; k < VALUES_PER_ITEM; ++k) {
+		unsigned int i = k * WORKGROUP_SIZE + local_id;
+		unsigned int digit = digit_of(src[i], shift);
+		if (i == 0 || digit_of(src[i - 1], shift) != digit)
+			bucket_starts[digit] = i;
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (unsigned int k = 0; k < VALUES_PER_ITEM; ++k) {
+		unsigned int i = k * WORKGROUP_SIZE + local_id;
+		if (i < valid) {
+			unsigned int digit = digit_of(src[i], shift);
+			unsigned int destination = bucket_offsets[digit] + i - bucket_starts[digit];
+			sorted_keys[destination] = bits_to_key(src[i]);
+#ifdef HAS_VALUES
+			sorted_values[destination] = src_values[i];
+#endif
+		}
+	}
+}
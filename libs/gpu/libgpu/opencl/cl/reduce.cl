@@ -0,0 +1,145 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define T float
+#define T4 float4
+#define T_LOWEST (-FLT_MAX)
+#define T_HIGHEST FLT_MAX
+#define REDUCE_SUM
+#define WORKGROUP_SIZE 256
+#endif
+
+#line 11
+
+// Compiled by gpu::reduce for each pair of element type T and operation REDUCE_*,
+// see libgpu/reduce.cpp for the defines
+
+#ifdef T_IS_DOUBLE
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+
+#define VALUES_PER_ITEM	4
+#define NO_INDEX		0xFFFFFFFFu
+
+#if defined(REDUCE_SUM)
+	#define IDENTITY		((T) 0)
+	#define COMBINE(a, a_index, b, b_index)	a = a + b
+#elif defined(REDUCE_MIN)
+	#define IDENTITY		T_HIGHEST
+	#define COMBINE(a, a_index, b, b_index)	a = (b < a) ? b : a
+#elif defined(REDUCE_MAX)
+	#define IDENTITY		T_LOWEST
+	#define COMBINE(a, a_index, b, b_index)	a = (b > a) ? b : a
+#elif defined(REDUCE_ARGMIN)
+	#define HAS_INDEX
+	#define IDENTITY		T_HIGHEST
+	// ties are resolved in favor of the first occurrence, so that result does not depend on work distribution
+	#define COMBINE(a, a_index, b, b_index)	if (b < a || (b == a && b_index < a_index)) { a = b; a_index = b_index; }
+#elif defined(REDUCE_ARGMAX)
+	#define HAS_INDEX
+	#define IDENTITY		T_LOWEST
+	#define COMBINE(a, a_index, b, b_index)	if (b > a || (b == a && b_index < a_index)) { a = b; a_index = b_index; }
+#else
+	#error Unknown reduce operation
+#endif
+
+// Tree reduction of per-item values in local memory, first work item writes result of the work group
+void reduce_group(T value, unsigned int index,
+				  __local T *local_values, __local unsigned int *local_indices,
+				  __global T *out_values, __global unsigned int *out_indices)
+{
+	const unsigned int local_id = get_local_id(0);
+
+	local_values[local_id] = value;
+#ifdef HAS_INDEX
+	local_indices[local_id] = index;
+#endif
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (unsigned int offset = WORKGROUP_SIZE / 2; offset > 0; offset /= 2) {
+		if (local_id < offset) {
+			T a = local_values[local_id];
+			T b = local_values[local_id + offset];
+			unsigned int a_index = 0;
+			unsigned int b_index = 0;
+#ifdef HAS_INDEX
+			a_index = local_indices[local_id];
+			b_index = local_indices[local_id + offset];
+#endif
+			COMBINE(a, a_index, b, b_index);
+			local_values[local_id] = a;
+#ifdef HAS_INDEX
+			local_indices[local_id] = a_index;
+#endif
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (local_id == 0) {
+		out_values[get_group_id(0)] = local_values[0];
+#ifdef HAS_INDEX
+		out_indices[get_group_id(0)] = local_indices[0];
+#endif
+	}
+}
+
+// First pass: every work group walks the input with stride of the whole NDRange,
+// each work item loads VALUES_PER_ITEM consecutive values with one vector load
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void reduce_values(__global const T *values,
+				   unsigned int n,
+				   __global T *out_values,
+				   __global unsigned int *out_indices)
+{
+	__local T local_values[WORKGROUP_SIZE];
+	__local unsigned int local_indices[WORKGROUP_SIZE];
+
+	const unsigned int stride = get_global_size(0) * VALUES_PER_ITEM;
+
+	T acc = IDENTITY;
+	unsigned int acc_index = NO_INDEX;
+	for (unsigned int base = get_global_id(0) * VALUES_PER_ITEM; base < n; base += stride) {
+		if (base + VALUES_PER_ITEM <= n) {
+			T4 v = vload4(0, values + base);
+			T x;
+			x = v.s0; COMBINE(acc, acc_index, x, base + 0);
+			x = v.s1; COMBINE(acc, acc_index, x, base + 1);
+			x = v.s2; COMBINE(acc, acc_index, x, base + 2);
+			x = v.s3; COMBINE(acc, acc_index, x, base + 3);
+		} else {
+			for (unsigned int i = base; i < n; ++i) {
+				T x = values[i];
+				COMBINE(acc, acc_index, x, i);
+			}
+		}
+		// base + stride can overflow 32 bits on the last iteration
+		if (n - base <= stride)
+			break;
+	}
+
+	reduce_group(acc, acc_index, local_values, local_indices, out_values, out_indices);
+}
+
+// Final pass: single work group combines partial results of the first pass
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void reduce_partials(__global const T *values,
+					 __global const unsigned int *indices,
+					 unsigned int n,
+					 __global T *out_values,
+					 __global unsigned int *out_indices)
+{
+	__local T local_values[WORKGROUP_SIZE];
+	__local unsigned int local_indices[WORKGROUP_SIZE];
+
+	T acc = IDENTITY;
+	unsigned int acc_index = NO_INDEX;
+	for (unsigned int i = get_local_id(0); i < n; i += WORKGROUP_SIZE) {
+		T x = values[i];
+		unsigned int x_index = 0;
+#ifdef HAS_INDEX
+		x_index = indices[i];
+#endif
+		COMBINE(acc, acc_index, x, x_index);
+	}
+
+	reduce_group(acc, acc_index, local_values, local_indices, out_values, out_indices);
+}
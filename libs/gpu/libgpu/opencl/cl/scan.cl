@@ -0,0 +1,69 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define T float
+#define WORKGROUP_SIZE 256
+#define SCAN_LOCAL_T T
+#include "scan_local.cl"
+#endif
+
+#line 10
+
+// Compiled by gpu::inclusiveScan/gpu::exclusiveScan for each element type T with scan_local.cl as a header
+// (SCAN_LOCAL_T is T), see libgpu/scan.cpp
+
+#ifdef T_IS_DOUBLE
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+
+#define VALUES_PER_ITEM	4
+#define BLOCK_SIZE		(WORKGROUP_SIZE * VALUES_PER_ITEM)
+
+// Scans every block of BLOCK_SIZE values independently and stores totals of blocks into block_sums.
+// Work item scans its VALUES_PER_ITEM consecutive values in registers, totals of work items are scanned
+// in local memory with scan_local. Can be used in place (values == result).
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void scan_blocks(__global const T *values,
+				 __global T *result,
+				 unsigned int n,
+				 __global T *block_sums,
+				 int exclusive)
+{
+	__local T sums[WORKGROUP_SIZE];
+
+	const unsigned int local_id = get_local_id(0);
+	const unsigned int base = get_group_id(0) * BLOCK_SIZE + local_id * VALUES_PER_ITEM;
+
+	T items[VALUES_PER_ITEM];
+	T total = 0;
+	for (unsigned int k = 0; k < VALUES_PER_ITEM; ++k) {
+		T x = (base + k < n) ? values[base + k] : 0;
+		items[k] = exclusive ? total : total + x;
+		total += x;
+	}
+
+	sums[local_id] = total;
+	const T block_total = scan_local(sums);
+	if (local_id == 0)
+		block_sums[get_group_id(0)] = block_total;
+
+	const T prefix = sums[local_id];
+	for (unsigned int k = 0; k < VALUES_PER_ITEM; ++k) {
+		if (base + k < n)
+			result[base + k] = prefix + items[k];
+	}
+}
+
+// Adds scanned totals of previous blocks to every value of the block
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void add_block_offsets(__global T *result,
+					   unsigned int n,
+					   __global const T *block_offsets)
+{
+	const unsigned int base = get_group_id(0) * BLOCK_SIZE + get_local_id(0) * VALUES_PER_ITEM;
+	const T offset = block_offsets[get_group_id(0)];
+
+	for (unsigned int k = 0; k < VALUES_PER_ITEM; ++k) {
+		if (base + k < n)
+			result[base + k] += offset;
+	}
+}
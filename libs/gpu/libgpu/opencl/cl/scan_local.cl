@@ -0,0 +1,62 @@
+#ifndef scan_local_cl // pragma once
+#define scan_local_cl
+
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define WORKGROUP_SIZE 256
+#endif
+
+#line 10
+
+// Scan of values of a work group in local memory shared by scan.cl, compact.cl and radix_sort.cl. It is not a program by itself,
+// its source is passed to ProgramCache as a header of these programs. Values have type SCAN_LOCAL_T (unsigned int if not defined),
+// WORKGROUP_SIZE should be a power of two.
+
+#ifndef SCAN_LOCAL_T
+#define SCAN_LOCAL_T unsigned int
+#endif
+
+#ifdef T_IS_DOUBLE
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+
+// Exclusive prefix sums of WORKGROUP_SIZE values in local memory in place, returns their total. Called by all work items
+// of the group: work-efficient up-sweep/down-sweep (Blelloch) scan, barriers make values written before the call visible.
+SCAN_LOCAL_T scan_local(__local SCAN_LOCAL_T *sums)
+{
+	const unsigned int local_id = get_local_id(0);
+
+	// up-sweep: builds tree of partial sums in place
+	unsigned int offset = 1;
+	for (unsigned int d = WORKGROUP_SIZE / 2; d > 0; d /= 2) {
+		barrier(CLK_LOCAL_MEM_FENCE);
+		if (local_id < d) {
+			unsigned int ai = offset * (2 * local_id + 1) - 1;
+			unsigned int bi = offset * (2 * local_id + 2) - 1;
+			sums[bi] += sums[ai];
+		}
+		offset *= 2;
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+	const SCAN_LOCAL_T total = sums[WORKGROUP_SIZE - 1];
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// down-sweep: turns the tree into exclusive prefix sums
+	if (local_id == 0)
+		sums[WORKGROUP_SIZE - 1] = 0;
+	for (unsigned int d = 1; d < WORKGROUP_SIZE; d *= 2) {
+		offset /= 2;
+		barrier(CLK_LOCAL_MEM_FENCE);
+		if (local_id < d) {
+			unsigned int ai = offset * (2 * local_id + 1) - 1;
+			unsigned int bi = offset * (2 * local_id + 2) - 1;
+			SCAN_LOCAL_T t = sums[ai];
+			sums[ai] = sums[bi];
+			sums[bi] += t;
+		}
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+	return total;
+}
+
+#endif
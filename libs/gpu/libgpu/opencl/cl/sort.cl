@@ -0,0 +1,163 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define T float
+#define WORKGROUP_SIZE 256
+#define BLOCK_SIZE 1024
+#define TILE_SIZE 1024
+bool sort_less(const T a, const T b) { return a < b; }
+#endif
+
+#line 11
+
+// Compiled by gpu::bitonicSort, gpu::merge and gpu::mergeSort for each comparator, see libgpu/sort.cpp.
+// Element type T and function bool sort_less(const T a, const T b) come from the header made of the comparator.
+
+#define ITEMS_PER_WORK_ITEM	(TILE_SIZE / WORKGROUP_SIZE)
+
+// Sorts every block of BLOCK_SIZE elements in local memory with bitonic sorting network, in place.
+// Network is the variant where all comparators are ascending: the first step of every merge compares mirrored
+// elements instead of reversing every other sequence. Then elements after n (in the last block) are never swapped
+// with elements before n, so they are not loaded and don't need a sentinel greater than any value of T.
+// Network is not stable, equal elements can go in any order.
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void bitonic_sort_blocks(__global T *values,
+						 unsigned int n)
+{
+	__local T block[BLOCK_SIZE];
+
+	const unsigned int local_id = get_local_id(0);
+	const unsigned int block_start = get_group_id(0) * BLOCK_SIZE;
+	const unsigned int valid = min((unsigned int) BLOCK_SIZE, n - block_start);
+
+	for (unsigned int i = local_id; i < valid; i += WORKGROUP_SIZE)
+		block[i] = values[block_start + i];
+
+	for (unsigned int size = 2; size <= BLOCK_SIZE; size *= 2) {
+		for (unsigned int stride = size / 2; stride > 0; stride /= 2) {
+			barrier(CLK_LOCAL_MEM_FENCE);
+			// every work item does BLOCK_SIZE / 2 / WORKGROUP_SIZE comparators
+			for (unsigned int c = local_id; c < BLOCK_SIZE / 2; c += WORKGROUP_SIZE) {
+				unsigned int lo = (c / stride) * 2 * stride + c % stride;
+				unsigned int hi = (stride == size / 2) ? (lo / size) * size + size - 1 - lo % size : lo + stride;
+				if (hi < valid) {
+					T a = block[lo];
+					T b = block[hi];
+					if (sort_less(b, a)) {
+						block[lo] = b;
+						block[hi] = a;
+					}
+				}
+			}
+		}
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (unsigned int i = local_id; i < valid; i += WORKGROUP_SIZE)
+		values[block_start + i] = block[i];
+}
+
+// Merge path: how many of the first diagonal elements of merged a and b come from a.
+// Elements of a go before equal elements of b, so merge is stable.
+unsigned int merge_path_global(__global const T *a, unsigned int na,
+							   __global const T *b, unsigned int nb,
+							   unsigned int diagonal)
+{
+	unsigned int begin = (diagonal > nb) ? diagonal - nb : 0;
+	unsigned int end = min(diagonal, na);
+	while (begin < end) {
+		unsigned int mid = (begin + end) / 2;
+		if (!sort_less(b[diagonal - 1 - mid], a[mid]))
+			begin = mid + 1;
+		else
+			end = mid;
+	}
+	return begin;
+}
+
+// Same search in the tile loaded into local memory: a is tile[0, na), b is tile[na, na + nb)
+unsigned int merge_path_local(__local const T *tile, unsigned int na, unsigned int nb, unsigned int diagonal)
+{
+	unsigned int begin = (diagonal > nb) ? diagonal - nb : 0;
+	unsigned int end = min(diagonal, na);
+	while (begin < end) {
+		unsigned int mid = (begin + end) / 2;
+		if (!sort_less(tile[na + diagonal - 1 - mid], tile[mid]))
+			begin = mid + 1;
+		else
+			end = mid;
+	}
+	return begin;
+}
+
+// Work group merges TILE_SIZE consecutive elements of the result of merging sorted a and b starting from tile_start.
+// Ends of the tile in a and b are found with merge path search in global memory, both parts are loaded into local memory
+// with coalesced reads, then every work item finds its ITEMS_PER_WORK_ITEM outputs on the merge path of the tile
+// and merges them sequentially. So every group and every work item gets the same amount of work whatever the data is.
+void merge_tile(__global const T *a, unsigned int na,
+				__global const T *b, unsigned int nb,
+				unsigned int tile_start,
+				__global T *result,
+				__local T *tile,
+				__local unsigned int *tile_splits)
+{
+	const unsigned int local_id = get_local_id(0);
+	const unsigned int tile_end = min(tile_start + TILE_SIZE, na + nb);
+
+	if (local_id < 2)
+		tile_splits[local_id] = merge_path_global(a, na, b, nb, local_id == 0 ? tile_start : tile_end);
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	const unsigned int a_start = tile_splits[0];
+	const unsigned int a_end = tile_splits[1];
+	const unsigned int b_start = tile_start - a_start;
+	const unsigned int b_end = tile_end - a_end;
+	const unsigned int tile_na = a_end - a_start;
+	const unsigned int tile_nb = b_end - b_start;
+
+	for (unsigned int i = local_id; i < tile_na; i += WORKGROUP_SIZE)
+		tile[i] = a[a_start + i];
+	for (unsigned int i = local_id; i < tile_nb; i += WORKGROUP_SIZE)
+		tile[tile_na + i] = b[b_start + i];
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	const unsigned int diagonal = min(local_id * ITEMS_PER_WORK_ITEM, tile_na + tile_nb);
+	unsigned int i = merge_path_local(tile, tile_na, tile_nb, diagonal);
+	unsigned int j = diagonal - i;
+	for (unsigned int k = 0; k < ITEMS_PER_WORK_ITEM && diagonal + k < tile_na + tile_nb; ++k) {
+		bool from_a = (j >= tile_nb) || (i < tile_na && !sort_less(tile[tile_na + j], tile[i]));
+		result[tile_start + diagonal + k] = from_a ? tile[i++] : tile[tile_na + j++];
+	}
+}
+
+// Merges sorted a and b into result, one work group per TILE_SIZE elements of the result
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void merge(__global const T *a,
+		   unsigned int na,
+		   __global const T *b,
+		   unsigned int nb,
+		   __global T *result)
+{
+	__local T tile[TILE_SIZE];
+	__local unsigned int tile_splits[2];
+
+	merge_tile(a, na, b, nb, get_group_id(0) * TILE_SIZE, result, tile, tile_splits);
+}
+
+// One pass of merge sort: merges pairs of consecutive sorted runs of width elements, width is a multiple of TILE_SIZE,
+// so that every tile of the result belongs to one pair
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void merge_pass(__global const T *values,
+				unsigned int n,
+				unsigned int width,
+				__global T *result)
+{
+	__local T tile[TILE_SIZE];
+	__local unsigned int tile_splits[2];
+
+	const unsigned int start = get_group_id(0) * TILE_SIZE;
+	const unsigned int pair_start = start - start % (2 * width);
+	const unsigned int na = min(width, n - pair_start);
+	const unsigned int nb = min(width, n - pair_start - na);
+
+	merge_tile(values + pair_start, na, values + pair_start + na, nb, start - pair_start, result + pair_start, tile, tile_splits);
+}
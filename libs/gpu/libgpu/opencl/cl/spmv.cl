@@ -0,0 +1,158 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define T float
+#define WORKGROUP_SIZE 256
+#define VECTOR_SIZE 8
+#define ITEMS_PER_THREAD 16
+#define ROW_LIST
+#endif
+
+#line 11
+
+// Compiled by gpu::CsrMatrix for each value type T, see libgpu/csr_matrix.cpp. y = A * x for CSR matrix A:
+// values and column indices of row i are [row_offsets[i], row_offsets[i + 1]).
+// ROW_LIST - kernel multiplies only rows of one bin of row lengths listed in row_list, otherwise rows [0, nrows).
+
+#ifdef T_IS_DOUBLE
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+
+#ifdef ROW_LIST
+#define ROW_LIST_ARG	, __global const unsigned int *row_list
+#define ROW(i)			row_list[i]
+#else
+#define ROW_LIST_ARG
+#define ROW(i)			(i)
+#endif
+
+// Thread per row: the best for short rows, as no work items are idle
+__kernel void spmv_scalar(__global const unsigned int *row_offsets,
+						  __global const unsigned int *column_indices,
+						  __global const T *values,
+						  __global const T *x,
+						  __global T *y,
+						  unsigned int nrows
+						  ROW_LIST_ARG)
+{
+	const unsigned int i = get_global_id(0);
+	if (i >= nrows)
+		return;
+
+	const unsigned int row = ROW(i);
+	const unsigned int end = row_offsets[row + 1];
+	T sum = 0;
+	for (unsigned int j = row_offsets[row]; j < end; ++j)
+		sum += values[j] * x[column_indices[j]];
+	y[row] = sum;
+}
+
+// VECTOR_SIZE work items per row (up to a warp): neighbouring work items read neighbouring values of the row,
+// partial sums are reduced in local memory
+__kernel __attribute__((reqd_work_group_size(WORKGROUP_SIZE, 1, 1)))
+void spmv_vector(__global const unsigned int *row_offsets,
+				 __global const unsigned int *column_indices,
+				 __global const T *values,
+				 __global const T *x,
+				 __global T *y,
+				 unsigned int nrows
+				 ROW_LIST_ARG)
+{
+	__local T partial[WORKGROUP_SIZE];
+
+	const unsigned int local_id = get_local_id(0);
+	const unsigned int lane = local_id % VECTOR_SIZE;
+	const unsigned int i = get_global_id(0) / VECTOR_SIZE;
+
+	unsigned int row = 0;
+	T sum = 0;
+	if (i < nrows) {
+		row = ROW(i);
+		const unsigned int end = row_offsets[row + 1];
+		for (unsigned int j = row_offsets[row] + lane; j < end; j += VECTOR_SIZE)
+			sum += values[j] * x[column_indices[j]];
+	}
+	partial[local_id] = sum;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (unsigned int step = VECTOR_SIZE / 2; step > 0; step /= 2) {
+		if (lane < step)
+			partial[local_id] += partial[local_id + step];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (lane == 0 && i < nrows)
+		y[row] = partial[local_id];
+}
+
+// Merge-based SpMV (Merrill, Garland): multiplication is a merge of row ends (row_offsets + 1) with indices of values,
+// every work item takes ITEMS_PER_THREAD steps of the merge path - either a value or the end of a row, so that the work
+// is balanced regardless of row lengths. Work item finds its start on the path with binary search, writes rows that end
+// in its part and leaves the partial sum of the row it stopped in as carry, carries are added by spmv_merge_fixup.
+__kernel void spmv_merge(__global const unsigned int *row_offsets,
+						 __global const unsigned int *column_indices,
+						 __global const T *values,
+						 __global const T *x,
+						 __global T *y,
+						 unsigned int nrows,
+						 unsigned int nnz,
+						 unsigned int nthreads,
+						 __global unsigned int *carry_rows,
+						 __global T *carry_values)
+{
+	const unsigned int thread = get_global_id(0);
+	if (thread >= nthreads)
+		return;
+
+	__global const unsigned int *row_ends = row_offsets + 1;
+	const unsigned int path_length = nrows + nnz;
+	const unsigned int diagonal = min(thread * ITEMS_PER_THREAD, path_length);
+	const unsigned int diagonal_end = min(diagonal + ITEMS_PER_THREAD, path_length);
+
+	// the first row i on the diagonal, such that row_ends[i] > diagonal - i - 1 (i.e. value diagonal - i is not consumed before row i ends)
+	unsigned int lo = diagonal > nnz ? diagonal - nnz : 0;
+	unsigned int hi = min(diagonal, nrows);
+	while (lo < hi) {
+		unsigned int mid = (lo + hi) / 2;
+		if (row_ends[mid] <= diagonal - mid - 1)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	unsigned int row = lo;
+	unsigned int j = diagonal - lo;
+	T sum = 0;
+	for (unsigned int step = diagonal; step < diagonal_end; ++step) {
+		if (row < nrows && j < row_ends[row]) {
+			sum += values[j] * x[column_indices[j]];
+			++j;
+		} else {
+			y[row] = sum;
+			sum = 0;
+			++row;
+		}
+	}
+	carry_rows[thread] = row;
+	carry_values[thread] = sum;
+}
+
+// Adds carries to their rows: the first work item of a run of carries of one row sums the whole run
+__kernel void spmv_merge_fixup(__global T *y,
+							   unsigned int nrows,
+							   unsigned int nthreads,
+							   __global const unsigned int *carry_rows,
+							   __global const T *carry_values)
+{
+	const unsigned int thread = get_global_id(0);
+	if (thread >= nthreads)
+		return;
+
+	const unsigned int row = carry_rows[thread];
+	if (row >= nrows || (thread > 0 && carry_rows[thread - 1] == row))
+		return;
+
+	T sum = 0;
+	for (unsigned int t = thread; t < nthreads && carry_rows[t] == row; ++t)
+		sum += carry_values[t];
+	y[row] += sum;
+}
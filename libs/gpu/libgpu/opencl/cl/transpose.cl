@@ -0,0 +1,106 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define E uint
+#define TILE 32
+#define TILE_ROWS 8
+#define CHUNK 1024
+#define NARROW_PITCH 5
+#endif
+
+#line 11
+
+// Compiled by gpu::transpose for each element type E (uchar, ushort, uint, uint2 or uint4 - elements are only moved),
+// see libgpu/transpose.cpp. Matrices are row-major and densely packed: rows x columns matrix is transposed into columns x rows.
+
+// TILE x TILE tiles of every matrix of the batch (third dimension of NDRange) are read by rows and written by columns
+// through local memory, so that both global reads and writes are coalesced. Row of the tile is padded by one element,
+// so that reading a column of the tile hits different banks of local memory. Work group is TILE x TILE_ROWS,
+// every work item moves TILE / TILE_ROWS elements.
+__kernel __attribute__((reqd_work_group_size(TILE, TILE_ROWS, 1)))
+void transpose_tiles(__global const E *src,
+					 __global E *dst,
+					 unsigned int rows,
+					 unsigned int columns)
+{
+	__local E tile[TILE * (TILE + 1)];
+
+	const unsigned int lx = get_local_id(0);
+	const unsigned int ly = get_local_id(1);
+	const unsigned int matrix_offset = get_group_id(2) * rows * columns;
+	const unsigned int tile_column = get_group_id(0) * TILE;
+	const unsigned int tile_row = get_group_id(1) * TILE;
+
+	for (unsigned int j = ly; j < TILE; j += TILE_ROWS) {
+		unsigned int row = tile_row + j;
+		unsigned int column = tile_column + lx;
+		if (row < rows && column < columns)
+			tile[j * (TILE + 1) + lx] = src[matrix_offset + row * columns + column];
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// element (row, column) goes to (column, row) of the result
+	for (unsigned int j = ly; j < TILE; j += TILE_ROWS) {
+		unsigned int row = tile_row + lx;
+		unsigned int column = tile_column + j;
+		if (row < rows && column < columns)
+			dst[matrix_offset + column * rows + row] = tile[lx * (TILE + 1) + j];
+	}
+}
+
+// Matrices with few columns (array of structures -> structure of arrays, interleaved -> planar images): tiles would be mostly empty,
+// so work group reads contiguous chunk of rows (CHUNK elements at most) and writes every column of them contiguously.
+// Rows are stored in local memory with odd NARROW_PITCH >= columns, so that reading a column hits different banks.
+// Matrices of the batch are the second dimension of NDRange.
+__kernel void transpose_narrow_columns(__global const E *src,
+									   __global E *dst,
+									   unsigned int rows,
+									   unsigned int columns,
+									   unsigned int chunk_rows)
+{
+	__local E chunk[CHUNK];
+
+	const unsigned int local_id = get_local_id(0);
+	const unsigned int group_size = get_local_size(0);
+	const unsigned int first_row = get_group_id(0) * chunk_rows;
+	const unsigned int nrows = min(chunk_rows, rows - first_row);
+	const unsigned int count = nrows * columns;
+	const unsigned int matrix_offset = get_group_id(1) * rows * columns;
+
+	for (unsigned int e = local_id; e < count; e += group_size)
+		chunk[(e / columns) * NARROW_PITCH + e % columns] = src[matrix_offset + first_row * columns + e];
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (unsigned int e = local_id; e < count; e += group_size) {
+		unsigned int column = e / nrows;
+		unsigned int row = e % nrows;
+		dst[matrix_offset + column * rows + first_row + row] = chunk[row * NARROW_PITCH + column];
+	}
+}
+
+// Matrices with few rows (structure of arrays -> array of structures, planar -> interleaved images):
+// work group reads chunk of every row and writes their transposition contiguously. Batch is the same as above.
+__kernel void transpose_narrow_rows(__global const E *src,
+									__global E *dst,
+									unsigned int rows,
+									unsigned int columns,
+									unsigned int chunk_columns)
+{
+	__local E chunk[CHUNK];
+
+	const unsigned int local_id = get_local_id(0);
+	const unsigned int group_size = get_local_size(0);
+	const unsigned int first_column = get_group_id(0) * chunk_columns;
+	const unsigned int ncolumns = min(chunk_columns, columns - first_column);
+	const unsigned int count = ncolumns * rows;
+	const unsigned int matrix_offset = get_group_id(1) * rows * columns;
+
+	for (unsigned int e = local_id; e < count; e += group_size) {
+		unsigned int row = e / ncolumns;
+		unsigned int column = e % ncolumns;
+		chunk[column * NARROW_PITCH + row] = src[matrix_offset + row * columns + first_column + column];
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (unsigned int e = local_id; e < count; e += group_size)
+		dst[matrix_offset + first_column * rows + e] = chunk[(e / rows) * NARROW_PITCH + e % rows];
+}
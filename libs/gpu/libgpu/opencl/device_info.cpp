@@ -19,6 +19,18 @@ DeviceInfo::DeviceInfo()
 	vendor_id					= 0;
 	warp_size					= 0;
 	wavefront_width				= 0;
+	preferred_vector_width_char		= 0;
+	preferred_vector_width_short	= 0;
+	preferred_vector_width_int		= 0;
+	preferred_vector_width_long		= 0;
+	preferred_vector_width_float	= 0;
+	preferred_vector_width_double	= 0;
+	native_vector_width_char		= 0;
+	native_vector_width_short		= 0;
+	native_vector_width_int			= 0;
+	native_vector_width_long		= 0;
+	native_vector_width_float		= 0;
+	native_vector_width_double		= 0;
 	opencl_major_version		= 0;
 	opencl_minor_version		= 0;
 }
@@ -35,6 +47,12 @@ void DeviceInfo::print() const
 		std::cout << "  warp size " << warp_size << std::endl;
 	if (wavefront_width != 0)
 		std::cout << "  wavefront width " << wavefront_width << std::endl;
+	std::cout << "  vector widths preferred/native: char " << preferred_vector_width_char << "/" << native_vector_width_char
+			  << ", short " << preferred_vector_width_short << "/" << native_vector_width_short
+			  << ", int " << preferred_vector_width_int << "/" << native_vector_width_int
+			  << ", long " << preferred_vector_width_long << "/" << native_vector_width_long
+			  << ", float " << preferred_vector_width_float << "/" << native_vector_width_float
+			  << ", double " << preferred_vector_width_double << "/" << native_vector_width_double << std::endl;
 }
 
 void DeviceInfo::init(cl_device_id device_id)
@@ -89,6 +107,7 @@ void DeviceInfo::init(cl_device_id device_id)
 
 	initExtensions(platform_id, device_id);
 	initOpenCLVersion(platform_id, device_id);
+	initVectorWidths(device_id);
 
 	if (device_type == CL_DEVICE_TYPE_GPU && vendor_id == ID_AMD && hasExtension(CL_AMD_DEVICE_ATTRIBUTE_QUERY_EXT)) {
 		OCL_SAFE_CALL(clGetDeviceInfo(device_id, CL_DEVICE_BOARD_NAME_AMD, sizeof(device_string), &device_string, NULL));
@@ -164,6 +183,54 @@ void DeviceInfo::parseOpenCLVersion(char* buffer, int buffer_limit, int& major_v
 	minor_verions = atoi(buffer + firstDotIndex + 1);
 }
 
+void DeviceInfo::initVectorWidths(cl_device_id device_id)
+{
+	const cl_device_info preferred_params[]	= { CL_DEVICE_PREFERRED_VECTOR_WIDTH_CHAR, CL_DEVICE_PREFERRED_VECTOR_WIDTH_SHORT, CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT,
+												CL_DEVICE_PREFERRED_VECTOR_WIDTH_LONG, CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT, CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE };
+	const cl_device_info native_params[]	= { CL_DEVICE_NATIVE_VECTOR_WIDTH_CHAR, CL_DEVICE_NATIVE_VECTOR_WIDTH_SHORT, CL_DEVICE_NATIVE_VECTOR_WIDTH_INT,
+												CL_DEVICE_NATIVE_VECTOR_WIDTH_LONG, CL_DEVICE_NATIVE_VECTOR_WIDTH_FLOAT, CL_DEVICE_NATIVE_VECTOR_WIDTH_DOUBLE };
+	unsigned int *preferred_widths[]	= { &preferred_vector_width_char, &preferred_vector_width_short, &preferred_vector_width_int,
+											&preferred_vector_width_long, &preferred_vector_width_float, &preferred_vector_width_double };
+	unsigned int *native_widths[]		= { &native_vector_width_char, &native_vector_width_short, &native_vector_width_int,
+											&native_vector_width_long, &native_vector_width_float, &native_vector_width_double };
+
+	// native widths appeared in OpenCL 1.1
+	bool has_native_widths = opencl_major_version > 1 || (opencl_major_version == 1 && opencl_minor_version >= 1);
+
+	for (int i = 0; i < 6; ++i) {
+		cl_uint width = 0;
+		OCL_SAFE_CALL(clGetDeviceInfo(device_id, preferred_params[i], sizeof(width), &width, NULL));
+		*preferred_widths[i] = width;
+
+		width = 0;
+		if (has_native_widths)
+			OCL_SAFE_CALL(clGetDeviceInfo(device_id, native_params[i], sizeof(width), &width, NULL));
+		*native_widths[i] = width;
+	}
+}
+
+unsigned int DeviceInfo::preferredVectorWidth(const std::string &type) const
+{
+	if (type == "char" || type == "uchar")		return preferred_vector_width_char;
+	if (type == "short" || type == "ushort")	return preferred_vector_width_short;
+	if (type == "int" || type == "uint")		return preferred_vector_width_int;
+	if (type == "long" || type == "ulong")		return preferred_vector_width_long;
+	if (type == "float")						return preferred_vector_width_float;
+	if (type == "double")						return preferred_vector_width_double;
+	return 0;
+}
+
+unsigned int DeviceInfo::nativeVectorWidth(const std::string &type) const
+{
+	if (type == "char" || type == "uchar")		return native_vector_width_char;
+	if (type == "short" || type == "ushort")	return native_vector_width_short;
+	if (type == "int" || type == "uint")		return native_vector_width_int;
+	if (type == "long" || type == "ulong")		return native_vector_width_long;
+	if (type == "float")						return native_vector_width_float;
+	if (type == "double")						return native_vector_width_double;
+	return 0;
+}
+
 bool DeviceInfo::isIntelGPU() const
 {
 	return device_type == CL_DEVICE_TYPE_GPU
@@ -19,6 +19,10 @@ public:
 	bool 				isIntelGPU() const;
 	bool				hasExtension(std::string extension)	{ return extensions.count(extension) > 0;}
 
+	// Vector widths for OpenCL scalar type ("char", "uchar", ..., "float", "double"), unsigned types have widths of signed ones
+	unsigned int		preferredVectorWidth(const std::string &type) const;
+	unsigned int		nativeVectorWidth(const std::string &type) const;
+
 	std::string				device_name;
 	std::string				vendor_name;
 	unsigned int			device_type;
@@ -35,6 +39,21 @@ public:
 	std::string				driver_version;
 	std::string				platform_version;
 
+	// Preferred vector widths are the ones that the compiler recommends for performance, native ones - widths of the hardware
+	// (OpenCL 1.1+, zero for older devices). Widths for double are zero if cl_khr_fp64 is not supported.
+	unsigned int			preferred_vector_width_char;
+	unsigned int			preferred_vector_width_short;
+	unsigned int			preferred_vector_width_int;
+	unsigned int			preferred_vector_width_long;
+	unsigned int			preferred_vector_width_float;
+	unsigned int			preferred_vector_width_double;
+	unsigned int			native_vector_width_char;
+	unsigned int			native_vector_width_short;
+	unsigned int			native_vector_width_int;
+	unsigned int			native_vector_width_long;
+	unsigned int			native_vector_width_float;
+	unsigned int			native_vector_width_double;
+
 	int 					opencl_major_version;
 	int 					opencl_minor_version;
 
@@ -43,6 +62,7 @@ public:
 protected:
 	void				initExtensions(cl_platform_id platform_id, cl_device_id device_id);
 	void				initOpenCLVersion(cl_platform_id platform_id, cl_device_id device_id);
+	void				initVectorWidths(cl_device_id device_id);
 	void				parseOpenCLVersion(char* buffer, int buffer_limit, int& major_version, int& minor_verions);
 };
 
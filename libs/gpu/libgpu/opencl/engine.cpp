@@ -7,7 +7,9 @@
 #include <fstream>
 #include <sstream>
 #include <cassert>
+#include <set>
 #include <vector>
+#include <atomic>
 
 #include <libclew/ocl_init.h>
 
@@ -106,24 +108,85 @@ void OpenCLKernel::setArg(cl_uint arg_index, size_t arg_size, const void *arg_va
 		throw std::runtime_error("clSetKernelArg " + to_string(kernel_name_) + "#" + to_string(arg_index) + " (" +to_string(arg_size) + " bytes) failed: " + errorString(ciErrNum));
 }
 
+static std::atomic<int>		next_engine_id(1);
+
+// Queue of the engine that was used last by the current thread, so that queue() usually does not need a lock
+static THREAD_LOCAL int					cached_queue_engine_id	= 0;
+static THREAD_LOCAL cl_command_queue	cached_queue			= 0;
+
+// Kernels of the current thread, direct-mapped by kernel id, so that findKernel usually does not need a lock.
+// Engine ids are never reused, so entries of destroyed or reinitialized engines are never matched.
+struct CachedKernel {
+	int				engine_id;
+	int				kernel_id;
+	OpenCLKernel *	kernel;
+};
+static const int						cached_kernels_count	= 64;
+static THREAD_LOCAL CachedKernel		cached_kernels[cached_kernels_count];
+
+// Engines that are alive, so that exiting threads release their kernels and queues only in engines that still exist
+static Mutex							live_engines_mutex;
+static std::set<OpenCLEngine *>			live_engines;
+
+// Engines in which the current thread created kernels or queues, they are released when the thread exits.
+// Kernels and queues created after that (e.g. by destructors of static objects run by the main thread) are released with their engines.
+static THREAD_LOCAL bool				thread_resources_released	= false;
+
+class ThreadResources {
+public:
+	~ThreadResources()
+	{
+		thread_resources_released	= true;
+		cached_queue_engine_id		= 0;
+		for (int i = 0; i < cached_kernels_count; ++i)
+			cached_kernels[i].engine_id = 0;
+
+		Lock lock(live_engines_mutex);
+		for (std::set<OpenCLEngine *>::iterator it = engines.begin(); it != engines.end(); ++it) {
+			if (live_engines.count(*it))
+				(*it)->releaseThread(std::this_thread::get_id());
+		}
+	}
+
+	std::set<OpenCLEngine *>	engines;
+};
+static thread_local ThreadResources		thread_resources;
+
+static void addThreadResources(OpenCLEngine *engine)
+{
+	// thread local object must not be touched after its destruction
+	if (!thread_resources_released)
+		thread_resources.engines.insert(engine);
+}
+
 OpenCLEngine::OpenCLEngine()
 {
+	id_							= next_engine_id++;
 	platform_id_				= 0;
 	device_id_					= 0;
 	context_					= 0;
-	command_queue_				= 0;
 	total_mem_size_				= 0;
+
+	Lock lock(live_engines_mutex);
+	live_engines.insert(this);
 }
 
 OpenCLEngine::~OpenCLEngine()
 {
-	for (std::map<int, OpenCLKernel *>::iterator it = kernels_.begin(); it != kernels_.end(); ++it)
+	{
+		Lock lock(live_engines_mutex);
+		live_engines.erase(this);
+	}
+
+	for (std::map<kernel_key, OpenCLKernel *>::iterator it = kernels_.begin(); it != kernels_.end(); ++it)
 		delete it->second;
 
 	for (std::map<int, cl_program>::iterator it = programs_.begin(); it != programs_.end(); ++it)
 		clReleaseProgram(it->second);
 
-	if (command_queue_)		clReleaseCommandQueue(command_queue_);
+	for (std::map<std::thread::id, cl_command_queue>::iterator it = queues_.begin(); it != queues_.end(); ++it)
+		clReleaseCommandQueue(it->second);
+
 	if (context_)			clReleaseContext(context_);
 }
 
@@ -145,9 +208,19 @@ void OpenCLEngine::init(cl_platform_id platform_id, cl_device_id device_id, cons
 	if (!ocl_init())
 		throw ocl_exception("Can't init OpenCL driver");
 
-	if (command_queue_) {
-		clReleaseCommandQueue(command_queue_);
-		command_queue_ = 0;
+	if (!queues_.empty() || !kernels_.empty()) {
+		for (std::map<std::thread::id, cl_command_queue>::iterator it = queues_.begin(); it != queues_.end(); ++it)
+			clReleaseCommandQueue(it->second);
+		queues_.clear();
+		// kernels and programs belong to the previous context
+		for (std::map<kernel_key, OpenCLKernel *>::iterator it = kernels_.begin(); it != kernels_.end(); ++it)
+			delete it->second;
+		kernels_.clear();
+		for (std::map<int, cl_program>::iterator it = programs_.begin(); it != programs_.end(); ++it)
+			clReleaseProgram(it->second);
+		programs_.clear();
+		// invalidate queues and kernels cached by threads
+		id_ = next_engine_id++;
 	}
 
 	if (context_) {
@@ -189,12 +262,12 @@ void OpenCLEngine::init(cl_platform_id platform_id, cl_device_id device_id, cons
 	context_		= clCreateContext(context_props, 1, &device_id, NULL, NULL, &ciErrNum);
 	OCL_SAFE_CALL(ciErrNum);
 
-	command_queue_	= clCreateCommandQueue(context_, device_id, 0, &ciErrNum);
-	OCL_SAFE_CALL(ciErrNum);
-
 	platform_id_	= platform_id;
 	device_id_		= device_id;
 
+	// create queue of the initializing thread right away, so that errors are reported from init
+	queue();
+
 	if (device_info_.device_type == CL_DEVICE_TYPE_GPU) {
 		if (device_info_.warp_size) {
 			wavefront_size_ = device_info_.warp_size;
@@ -217,6 +290,33 @@ void OpenCLEngine::init(cl_platform_id platform_id, cl_device_id device_id, cons
 	}
 }
 
+cl_command_queue OpenCLEngine::queue()
+{
+	if (cached_queue_engine_id == id_)
+		return cached_queue;
+
+	cl_command_queue queue = 0;
+	{
+		Lock lock(mutex_);
+
+		std::thread::id thread = std::this_thread::get_id();
+		std::map<std::thread::id, cl_command_queue>::iterator it = queues_.find(thread);
+		if (it != queues_.end()) {
+			queue = it->second;
+		} else {
+			cl_int ciErrNum = CL_SUCCESS;
+			queue = clCreateCommandQueue(context_, device_id_, 0, &ciErrNum);
+			OCL_SAFE_CALL(ciErrNum);
+			queues_[thread] = queue;
+			addThreadResources(this);
+		}
+	}
+
+	cached_queue_engine_id	= id_;
+	cached_queue			= queue;
+	return queue;
+}
+
 void ocl::oclPrintBuildLog(cl_program program)
 {
 	size_t device_count;
@@ -320,6 +420,15 @@ void OpenCLEngine::releaseMemObject(cl_mem memobj)
 
 void OpenCLEngine::ndRangeKernel(OpenCLKernel &kernel, cl_uint work_dim, const size_t *global_work_offset,
 								 const size_t *global_work_size, const size_t *local_work_size)
+{
+	checkNDRange(kernel, work_dim, global_work_size, local_work_size);
+
+	cl_event ev = NULL;
+	OCL_SAFE_CALL(clEnqueueNDRangeKernel(queue(), kernel.kernel(), work_dim, global_work_offset, global_work_size, local_work_size, 0, NULL, &ev));
+	trackEvent(ev, "", &kernel);
+}
+
+void OpenCLEngine::checkNDRange(OpenCLKernel &kernel, cl_uint work_dim, const size_t *global_work_size, const size_t *local_work_size)
 {
 	if (work_dim < 1 || work_dim > 3)
 		throw ocl_exception("Wrong work dimension size: " + to_string(work_dim) + "!");
@@ -352,35 +461,40 @@ void OpenCLEngine::ndRangeKernel(OpenCLKernel &kernel, cl_uint work_dim, const s
 								+ to_string(global_work_size[d]) + ", while device has " + to_string(device_info_.device_address_bits) + " address bits!");
 		}
 	}
+}
 
-	cl_event ev = NULL;
-	OCL_SAFE_CALL(clEnqueueNDRangeKernel(queue(), kernel.kernel(), work_dim, global_work_offset, global_work_size, local_work_size, 0, NULL, &ev));
-	trackEvent(ev, "Kernel " + kernel.kernelName() + ": ");
+// Error message prefix is assembled only on failure, so that successful launches do not touch the heap
+static std::string eventMessage(const char *message, const OpenCLKernel *kernel)
+{
+	if (kernel)
+		return "Kernel " + kernel->kernelName() + ": ";
+	return message;
 }
 
-void OpenCLEngine::trackEvent(cl_event ev, std::string message)
+void OpenCLEngine::trackEvent(cl_event ev, const char *message, const OpenCLKernel *kernel)
 {
-	cl_int		ciErrNum	= CL_SUCCESS;
 	cl_int		result		= CL_SUCCESS;
 
 	try {
-		OCL_SAFE_CALL_MESSAGE(clFlush(queue()), message);
-		OCL_SAFE_CALL_MESSAGE(clWaitForEvents(1, &ev), message);
-		OCL_SAFE_CALL_MESSAGE(clGetEventInfo(ev, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(cl_int), &result, 0), message);
+		OCL_SAFE_CALL_MESSAGE(clFlush(queue()), eventMessage(message, kernel));
+		OCL_SAFE_CALL_MESSAGE(clWaitForEvents(1, &ev), eventMessage(message, kernel));
+		OCL_SAFE_CALL_MESSAGE(clGetEventInfo(ev, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(cl_int), &result, 0), eventMessage(message, kernel));
 
 		if (result != CL_COMPLETE) {
 			throw ocl_exception("Wait for event succeed, but it is still is not complete with execution status: " + to_string(result) + "!");
 		}
 	} catch (...) {
-		OCL_SAFE_CALL_MESSAGE(clReleaseEvent(ev), message);
+		OCL_SAFE_CALL_MESSAGE(clReleaseEvent(ev), eventMessage(message, kernel));
 		throw;
 	}
 
-	OCL_SAFE_CALL_MESSAGE(clReleaseEvent(ev), message);
+	OCL_SAFE_CALL_MESSAGE(clReleaseEvent(ev), eventMessage(message, kernel));
 }
 
 cl_program OpenCLEngine::findProgram(int id) const
 {
+	Lock lock(mutex_);
+
 	std::map<int, cl_program>::const_iterator it = programs_.find(id);
 	if (it != programs_.end())
 		return it->second;
@@ -389,12 +503,70 @@ cl_program OpenCLEngine::findProgram(int id) const
 
 OpenCLKernel *OpenCLEngine::findKernel(int id) const
 {
-	std::map<int, OpenCLKernel *>::const_iterator it = kernels_.find(id);
-	if (it != kernels_.end())
-		return it->second;
-	return 0;
+	CachedKernel &cached = cached_kernels[id % cached_kernels_count];
+	if (cached.engine_id == id_ && cached.kernel_id == id)
+		return cached.kernel;
+
+	Lock lock(mutex_);
+
+	std::map<kernel_key, OpenCLKernel *>::const_iterator it = kernels_.find(kernel_key(id, std::this_thread::get_id()));
+	if (it == kernels_.end())
+		return 0;
+
+	cached.engine_id	= id_;
+	cached.kernel_id	= id;
+	cached.kernel		= it->second;
+	return it->second;
+}
+
+void OpenCLEngine::addProgram(int id, cl_program program)
+{
+	Lock lock(mutex_);
+
+	programs_[id] = program;
 }
 
+void OpenCLEngine::addKernel(int id, OpenCLKernel *kernel)
+{
+	Lock lock(mutex_);
+
+	kernel_key key(id, std::this_thread::get_id());
+	if (kernels_.count(key))
+		delete kernels_[key];
+	kernels_[key] = kernel;
+	addThreadResources(this);
+
+	CachedKernel &cached = cached_kernels[id % cached_kernels_count];
+	cached.engine_id	= id_;
+	cached.kernel_id	= id;
+	cached.kernel		= kernel;
+}
+
+void OpenCLEngine::releaseThread(std::thread::id thread)
+{
+	Lock lock(mutex_);
+
+	for (std::map<kernel_key, OpenCLKernel *>::iterator it = kernels_.begin(); it != kernels_.end(); ) {
+		if (it->first.second == thread) {
+			delete it->second;
+			kernels_.erase(it++);
+		} else {
+			++it;
+		}
+	}
+
+	std::map<std::thread::id, cl_command_queue>::iterator it = queues_.find(thread);
+	if (it != queues_.end()) {
+		clReleaseCommandQueue(it->second);
+		queues_.erase(it);
+	}
+}
+
+// Ids of programs and kernels are keys of per-engine and per-thread caches, and ProgramCache creates programs and kernels
+// lazily from any thread, so ids are taken from atomic counters (one for programs made from binaries and from source)
+static std::atomic<int>		next_program_id(0);
+static std::atomic<int>		next_kernel_id(0);
+
 VersionedBinary::VersionedBinary(const char *data, const size_t size,
 								 int bits, const int opencl_major_version, const int opencl_minor_version)
 		: data_(data), size_(size), device_address_bits_(bits), opencl_major_version_(opencl_major_version), opencl_minor_version_(opencl_minor_version)
@@ -402,7 +574,6 @@ VersionedBinary::VersionedBinary(const char *data, const size_t size,
 
 ProgramBinaries::ProgramBinaries(std::vector<VersionedBinary> binaries, std::string defines, std::string program_name) : binaries_(binaries)
 {
-	static int next_program_id = 0;
 	program_name_ = program_name;
 	id_			= next_program_id++;
 	defines_	= defines;
@@ -410,7 +581,6 @@ ProgramBinaries::ProgramBinaries(std::vector<VersionedBinary> binaries, std::str
 
 ProgramBinaries::ProgramBinaries(const char *source_code, size_t source_code_length, std::string defines, std::string program_name) : binaries_({VersionedBinary(source_code, source_code_length, 0, 1, 2)})
 {
-	static int next_program_id = 0;
 	program_name_ = program_name;
 	id_			= next_program_id++;
 	defines_	= defines;
@@ -451,7 +621,6 @@ KernelSource::KernelSource(std::shared_ptr<ocl::ProgramBinaries> program, const
 
 int KernelSource::getNextKernelId()
 {
-	static int next_kernel_id = 0;
 	return next_kernel_id++;
 }
 
@@ -496,143 +665,158 @@ namespace ocl {
 	}
 }
 
-OpenCLKernel *KernelSource::getKernel(const std::shared_ptr<OpenCLEngine> &cl, bool printLog)
+cl_program KernelSource::buildProgram(const std::shared_ptr<OpenCLEngine> &cl, bool printLog)
 {
-	OpenCLKernel *kernel = cl->findKernel(id_);
-	if (kernel)
-		return kernel;
-
-	cl_program program = cl->findProgram(program_->id());
-
-	if (!program) {
-		Lock lock(cached_kernels_mutex);
-
-		bool verbose = printLog || OCL_VERBOSE_COMPILE_LOG;
+	cl_program program = 0;
 
-		const VersionedBinary* binary = program_->getBinary(cl);
-		const std::vector<unsigned char>* cachedCompiledBinary = getCachedBinary(program_->id(), cl->platform(), cl->device());
+	bool verbose = printLog || OCL_VERBOSE_COMPILE_LOG;
 
-		cl_int ciErrNum = CL_SUCCESS;
+	const VersionedBinary* binary = program_->getBinary(cl);
+	const std::vector<unsigned char>* cachedCompiledBinary = getCachedBinary(program_->id(), cl->platform(), cl->device());
 
-		std::string options = program_->defines();
+	cl_int ciErrNum = CL_SUCCESS;
 
-		std::vector<unsigned char> loaded_from_file_binaries;
-		std::string binaries_to_load_filename = LOAD_KERNEL_BINARIES_FROM_FILE;
+	std::string options = program_->defines();
 
-		if (!binaries_to_load_filename.empty()){
-			std::ifstream program_binaries_file;
-			program_binaries_file.open(binaries_to_load_filename);
+	std::vector<unsigned char> loaded_from_file_binaries;
+	std::string binaries_to_load_filename = LOAD_KERNEL_BINARIES_FROM_FILE;
 
-			std::string binaries_string((std::istreambuf_iterator<char>(program_binaries_file)), std::istreambuf_iterator<char>());
+	if (!binaries_to_load_filename.empty()){
+		std::ifstream program_binaries_file;
+		program_binaries_file.open(binaries_to_load_filename);
 
-			loaded_from_file_binaries = std::vector<unsigned char>(binaries_string.size());
-			for (int i = 0; i < binaries_string.size(); ++i) {
-				loaded_from_file_binaries[i] = (unsigned char) binaries_string[i];
-			}
-			cachedCompiledBinary = &loaded_from_file_binaries;
+		std::string binaries_string((std::istreambuf_iterator<char>(program_binaries_file)), std::istreambuf_iterator<char>());
 
-			program_binaries_file.close();
+		loaded_from_file_binaries = std::vector<unsigned char>(binaries_string.size());
+		for (int i = 0; i < binaries_string.size(); ++i) {
+			loaded_from_file_binaries[i] = (unsigned char) binaries_string[i];
 		}
+		cachedCompiledBinary = &loaded_from_file_binaries;
 
-		if (cachedCompiledBinary != NULL) {
-			std::vector<const unsigned char *>	kernel_ptrs;
-			std::vector<size_t>					kernel_sizes;
+		program_binaries_file.close();
+	}
 
-			kernel_ptrs.push_back(cachedCompiledBinary->data());
-			kernel_sizes.push_back(cachedCompiledBinary->size());
+	if (cachedCompiledBinary != NULL) {
+		std::vector<const unsigned char *>	kernel_ptrs;
+		std::vector<size_t>					kernel_sizes;
 
-			cl_device_id device = cl->device();
-			cl_int binary_status;
+		kernel_ptrs.push_back(cachedCompiledBinary->data());
+		kernel_sizes.push_back(cachedCompiledBinary->size());
 
-			program = clCreateProgramWithBinary(cl->context(), 1, &device, &kernel_sizes[0], &kernel_ptrs[0], &binary_status, &ciErrNum);
-			OCL_SAFE_CALL(binary_status);
-			OCL_SAFE_CALL(ciErrNum);
-		} else if (binary->deviceAddressBits() == 0) {
-			std::vector<const char *>			kernel_ptrs;
-			std::vector<size_t>					kernel_sizes;
+		cl_device_id device = cl->device();
+		cl_int binary_status;
 
-			kernel_ptrs.push_back(binary->data());
-			kernel_sizes.push_back(binary->size());
+		program = clCreateProgramWithBinary(cl->context(), 1, &device, &kernel_sizes[0], &kernel_ptrs[0], &binary_status, &ciErrNum);
+		OCL_SAFE_CALL(binary_status);
+		OCL_SAFE_CALL(ciErrNum);
+	} else if (binary->deviceAddressBits() == 0) {
+		std::vector<const char *>			kernel_ptrs;
+		std::vector<size_t>					kernel_sizes;
 
-			program = clCreateProgramWithSource(cl->context(), kernel_ptrs.size(), &kernel_ptrs[0], &kernel_sizes[0], &ciErrNum);
-			OCL_SAFE_CALL(ciErrNum);
-		} else {
-			std::vector<const unsigned char *>	kernel_ptrs;
-			std::vector<size_t>					kernel_sizes;
+		kernel_ptrs.push_back(binary->data());
+		kernel_sizes.push_back(binary->size());
 
-			kernel_ptrs.push_back((unsigned char*) binary->data());
-			kernel_sizes.push_back(binary->size());
+		program = clCreateProgramWithSource(cl->context(), kernel_ptrs.size(), &kernel_ptrs[0], &kernel_sizes[0], &ciErrNum);
+		OCL_SAFE_CALL(ciErrNum);
+	} else {
+		std::vector<const unsigned char *>	kernel_ptrs;
+		std::vector<size_t>					kernel_sizes;
 
-			cl_device_id device = cl->device();
-			cl_int binary_status;
+		kernel_ptrs.push_back((unsigned char*) binary->data());
+		kernel_sizes.push_back(binary->size());
 
-			program = clCreateProgramWithBinary(cl->context(), 1, &device, &kernel_sizes[0], &kernel_ptrs[0], &binary_status, &ciErrNum);
-			OCL_SAFE_CALL(binary_status);
-			OCL_SAFE_CALL(ciErrNum);
+		cl_device_id device = cl->device();
+		cl_int binary_status;
 
-			if (cl->deviceInfo().extensions.count("cl_khr_spir") == 0)
-				throw ocl_exception("Device does not support SPIR!");
+		program = clCreateProgramWithBinary(cl->context(), 1, &device, &kernel_sizes[0], &kernel_ptrs[0], &binary_status, &ciErrNum);
+		OCL_SAFE_CALL(binary_status);
+		OCL_SAFE_CALL(ciErrNum);
 
-			options += " -x spir";
-		}
+		if (cl->deviceInfo().extensions.count("cl_khr_spir") == 0)
+			throw ocl_exception("Device does not support SPIR!");
 
-		options += " -D WARP_SIZE=" + to_string(cl->wavefrontSize());
+		options += " -x spir";
+	}
 
-		timer tm;
-		tm.start();
+	options += " -D WARP_SIZE=" + to_string(cl->wavefrontSize());
 
-		if (cachedCompiledBinary == NULL && verbose) {
-			if (program_->programName() == "") {
-				std::cout << "Building kernels for " << cl->deviceName() << "... " << std::endl;
-			}
+	timer tm;
+	tm.start();
+
+	if (cachedCompiledBinary == NULL && verbose) {
+		if (program_->programName() == "") {
+			std::cout << "Building kernels for " << cl->deviceName() << "... " << std::endl;
+		}
 //			else {
 //				std::cout << "Building kernel " << program_->programName() << " for " << cl->deviceName() << "... " << std::endl;
 //			}
-		}
+	}
 
-		ciErrNum = clBuildProgram(program, 0, NULL, options.c_str(), NULL, NULL);
+	ciErrNum = clBuildProgram(program, 0, NULL, options.c_str(), NULL, NULL);
 
-		if (ciErrNum == CL_SUCCESS && cachedCompiledBinary == NULL) {
-			if (program_->programName() == "" && verbose) {
-				std::cout << "Kernels compilation done in " << tm.elapsed() << " seconds" << std::endl;
-			}
+	if (ciErrNum == CL_SUCCESS && cachedCompiledBinary == NULL) {
+		if (program_->programName() == "" && verbose) {
+			std::cout << "Kernels compilation done in " << tm.elapsed() << " seconds" << std::endl;
+		}
 //			else {
 //				std::cout << "Kernel " << program_->programName() << " compilation done in " << tm.elapsed() << " seconds" << std::endl;
 //			}
 
+		std::vector<unsigned char> binaries = getProgramBinaries(program);
+		setCachedBinary(program_->id(), cl->platform(), cl->device(), binaries);
+	}
+
+	if (ciErrNum != CL_SUCCESS || verbose) {
+		ocl::oclPrintBuildLog(program);
+
+		std::string binaries_filename = DUMP_KERNEL_BINARIES_TO_FILE;
+		if (!binaries_filename.empty()) {
 			std::vector<unsigned char> binaries = getProgramBinaries(program);
-			setCachedBinary(program_->id(), cl->platform(), cl->device(), binaries);
+			std::string binaries_string((char*) binaries.data(), binaries.size());
+
+			std::ofstream program_binaries_file;
+			program_binaries_file.open(binaries_filename + "_platform" + to_string(cl->platform()) + "_device" + to_string(cl->device()) + "_program" + to_string(program_->id()));
+
+			program_binaries_file << binaries_string;
+			program_binaries_file.close();
 		}
+	}
+
+	if (ciErrNum != CL_SUCCESS) {
+		clReleaseProgram(program);
+		program = 0;
+	}
 
-		if (ciErrNum != CL_SUCCESS || verbose) {
-			ocl::oclPrintBuildLog(program);
+	OCL_SAFE_CALL(ciErrNum);
 
-			std::string binaries_filename = DUMP_KERNEL_BINARIES_TO_FILE;
-			if (!binaries_filename.empty()) {
-				std::vector<unsigned char> binaries = getProgramBinaries(program);
-				std::string binaries_string((char*) binaries.data(), binaries.size());
+	return program;
+}
 
-				std::ofstream program_binaries_file;
-				program_binaries_file.open(binaries_filename + "_platform" + to_string(cl->platform()) + "_device" + to_string(cl->device()) + "_program" + to_string(program_->id()));
+OpenCLKernel *KernelSource::getKernel(const std::shared_ptr<OpenCLEngine> &cl, bool printLog)
+{
+	OpenCLKernel *kernel = cl->findKernel(id_);
+	if (kernel)
+		return kernel;
 
-				program_binaries_file << binaries_string;
-				program_binaries_file.close();
-			}
-		}
+	cl_program program = cl->findProgram(program_->id());
 
-		if (ciErrNum != CL_SUCCESS) {
-			clReleaseProgram(program);
-			program = 0;
-		}
+	if (!program) {
+		Lock lock(cached_kernels_mutex);
 
-		OCL_SAFE_CALL(ciErrNum);
-		cl->programs()[program_->id()] = program;
+		// another thread could have built the program while we were waiting for the lock
+		program = cl->findProgram(program_->id());
+		if (!program) {
+			program = buildProgram(cl, printLog);
+			cl->addProgram(program_->id(), program);
+		}
 	}
 
+	// each thread gets its own cl_kernel instance created from the shared program, so that concurrent launches do not race on arguments
+	// (clCloneKernel would preserve already set arguments, but it requires OpenCL 2.1, and arguments are set on every launch anyway)
 	kernel = new OpenCLKernel;
-	kernel->create(program, name_.c_str());
+	kernel->create(program, name_.c_str(), cl->device());
 
-	cl->kernels()[id_] = kernel;
+	cl->addKernel(id_, kernel);
 
 	return kernel;
 }
@@ -721,6 +905,7 @@ void KernelSource::precompile(const std::shared_ptr<OpenCLEngine> &cl, bool prin
 OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer &arg)
 {
 	is_null = false;
+	buffer = &arg;
 	size = sizeof(cl_mem);
 	cl_mem_storage = arg.clmem();
 	value = &cl_mem_storage;
@@ -733,6 +918,7 @@ template<typename T>
 OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<T> &arg)
 {
 	is_null = false;
+	buffer = &arg;
 	size = sizeof(cl_mem);
 	cl_mem_storage = arg.clmem();
 	value = &cl_mem_storage;
@@ -742,10 +928,13 @@ OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<T> &arg)
 }
 
 template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<char> &arg);
+template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<signed char> &arg);
 template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<unsigned char> &arg);
 template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<short> &arg);
 template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<unsigned short> &arg);
 template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<int> &arg);
 template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<unsigned int> &arg);
+template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<int64_t> &arg);
+template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<uint64_t> &arg);
 template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<float> &arg);
 template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<double> &arg);
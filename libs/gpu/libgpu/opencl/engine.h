@@ -12,11 +12,14 @@
 #include <libgpu/opencl/device_info.h>
 #include <libgpu/opencl/utils.h>
 #include <libgpu/utils.h>
+#include <libutils/thread_mutex.h>
 #include <memory>
+#include <thread>
 #include <map>
 
 namespace gpu {
 	class WorkSize;
+	class CommandList;
 	class shared_device_buffer;
 
 	template <typename T>
@@ -34,6 +37,8 @@ namespace ocl {
 	template<> struct OpenCLType<uint8_t>		{ typedef cl_uchar	type; static std::string name() { return "uchar";	}  static uint8_t		max() { return CL_UCHAR_MAX;	} static uint8_t		min() { return 0;			} };
 	template<> struct OpenCLType<uint16_t>		{ typedef cl_ushort	type; static std::string name() { return "ushort";	}  static uint16_t		max() { return CL_CHAR_MAX;		} static uint16_t		min() { return 0; 			} };
 	template<> struct OpenCLType<uint32_t>		{ typedef cl_uint	type; static std::string name() { return "uint";	}  static uint32_t		max() { return CL_UINT_MAX;		} static uint32_t		min() { return 0;			} };
+	template<> struct OpenCLType<int64_t>		{ typedef cl_long	type; static std::string name() { return "long";	}  static int64_t		max() { return CL_LONG_MAX;		} static int64_t		min() { return CL_LONG_MIN;	} };
+	template<> struct OpenCLType<uint64_t>		{ typedef cl_ulong	type; static std::string name() { return "ulong";	}  static uint64_t		max() { return CL_ULONG_MAX;	} static uint64_t		min() { return 0;			} };
 	template<> struct OpenCLType<float>			{ typedef cl_float	type; static std::string name() { return "float";	}  static float			max() { return CL_FLT_MAX;		} static float			min() { return CL_FLT_MIN;	} };
 	template<> struct OpenCLType<double>		{ typedef cl_double	type; static std::string name() { return "double";	}  static double		max() { return std::numeric_limits<double>::max();		} static double			min() { return CL_DBL_MIN;	} };
 
@@ -50,12 +55,12 @@ namespace ocl {
 
 	class OpenCLKernelArg {
 	public:
-		OpenCLKernelArg() : is_null(true), size(0), value(0), cl_mem_storage(NULL) { }
+		OpenCLKernelArg() : is_null(true), size(0), value(0), buffer(NULL), cl_mem_storage(NULL) { }
 
 		template <typename T>
-		OpenCLKernelArg(const T &arg) : is_null(false), size(sizeof(arg)), value(&arg), cl_mem_storage(NULL) { }
+		OpenCLKernelArg(const T &arg) : is_null(false), size(sizeof(arg)), value(&arg), buffer(NULL), cl_mem_storage(NULL) { }
 
-		OpenCLKernelArg(const LocalMem &arg) : is_null(false), size(arg.size), value(0), cl_mem_storage(NULL) { }
+		OpenCLKernelArg(const LocalMem &arg) : is_null(false), size(arg.size), value(0), buffer(NULL), cl_mem_storage(NULL) { }
 
 		OpenCLKernelArg(const gpu::shared_device_buffer &arg);
 
@@ -65,6 +70,7 @@ namespace ocl {
 		bool			is_null;
 		size_t			size;
 		const void *	value;
+		const gpu::shared_device_buffer *	buffer;		// set for device buffer arguments, so that recorded launches can keep them alive
 	protected:
 		cl_mem 			cl_mem_storage;
 	};
@@ -77,7 +83,7 @@ namespace ocl {
 		void		create(cl_program program, const char *kernel_name, cl_device_id device_id_=NULL);
 
 		cl_kernel	kernel(void)			{ return kernel_;			}
-		std::string kernelName(void)		{ return kernel_name_;		}
+		const std::string &kernelName(void) const	{ return kernel_name_;	}
 		size_t		workGroupSize(void)		{ return work_group_size_;	}
 
 		typedef OpenCLKernelArg Arg;
@@ -158,6 +164,8 @@ namespace ocl {
 		void				copyBuffer(cl_mem src_buffer, cl_mem dst_buffer, size_t src_offset, size_t dst_offset, size_t cb);
 		void				ndRangeKernel(OpenCLKernel &kernel, cl_uint work_dim, const size_t *global_work_offset,
 											const size_t *global_work_size, const size_t *local_work_size);
+		void				checkNDRange(OpenCLKernel &kernel, cl_uint work_dim, const size_t *global_work_size, const size_t *local_work_size);
+		void				trackEvent(cl_event ev, const char *message="", const OpenCLKernel *kernel=NULL);
 		void				releaseMemObject(cl_mem memobj);
 
 		const DeviceInfo &	deviceInfo() const			{ return device_info_;				}
@@ -165,7 +173,8 @@ namespace ocl {
 		cl_platform_id		platform()					{ return platform_id_;				}
 		cl_device_id		device()					{ return device_id_;				}
 		cl_context			context()					{ return context_;					}
-		cl_command_queue	queue()						{ return command_queue_;			}
+		int					id() const					{ return id_;						}	// unique among engines and their re-initializations
+		cl_command_queue	queue();	// command queue of the calling thread, created on first use
 
 		const std::string &	deviceName()				{ return device_info_.device_name;				}
 		size_t				maxComputeUnits() const		{ return device_info_.max_compute_units;		}
@@ -177,27 +186,35 @@ namespace ocl {
 		size_t 				wavefrontSize()				{ return wavefront_size_;						}
 		size_t 				totalMemSize()				{ return total_mem_size_;						}
 
-		std::map<int, cl_program> &		programs()	{ return programs_;	}
-		std::map<int, OpenCLKernel *> &	kernels()	{ return kernels_;	}
-
+		// Programs are shared by all threads using this engine, while kernels are created per calling thread:
+		// clSetKernelArg+clEnqueueNDRangeKernel on the same cl_kernel is not thread safe, but on different ones it is.
+		// Kernels of the calling thread are cached in thread local storage, so findKernel usually does not need a lock.
 		cl_program						findProgram(int id) const;
 		OpenCLKernel *					findKernel(int id) const;
+		void							addProgram(int id, cl_program program);
+		void							addKernel(int id, OpenCLKernel *kernel);
 
-	protected:
-		void				trackEvent(cl_event ev, std::string message="");
+		// Releases kernels and command queue of the thread, called when the thread exits
+		void							releaseThread(std::thread::id thread);
 
+	protected:
 		cl_platform_id		platform_id_;
 		cl_device_id		device_id_;
 		cl_context			context_;
-		cl_command_queue	command_queue_;
 
 		size_t 				wavefront_size_;
 
 		DeviceInfo			device_info_;
 		size_t				total_mem_size_;
 
-		std::map<int, cl_program>		programs_;
-		std::map<int, OpenCLKernel *>	kernels_;
+		typedef std::pair<int, std::thread::id>	kernel_key;
+
+		int									id_;	// unique across all engines ever created, identifies engine in per-thread queue cache
+
+		Mutex								mutex_;
+		std::map<std::thread::id, cl_command_queue>	queues_;
+		std::map<int, cl_program>			programs_;
+		std::map<kernel_key, OpenCLKernel *>	kernels_;
 	};
 
 	void		oclPrintBuildLog(cl_program program);
@@ -253,9 +270,12 @@ public:
 	void precompile(const std::shared_ptr<OpenCLEngine> &cl, bool printLog=false);
 
 protected:
+	friend class gpu::CommandList;
+
 	int getNextKernelId();
 
 	OpenCLKernel *getKernel(const std::shared_ptr<OpenCLEngine> &cl, bool printLog=false);
+	cl_program buildProgram(const std::shared_ptr<OpenCLEngine> &cl, bool printLog);
 
 	std::shared_ptr<ocl::ProgramBinaries> program_;
 
@@ -0,0 +1,76 @@
+#include "program_cache.h"
+
+namespace ocl {
+
+ProgramCache::ProgramCache(const char *source_code, size_t source_code_length, const std::string &program_name)
+	: source_code_(source_code), source_code_length_(source_code_length), program_name_(program_name)
+{
+}
+
+KernelSource &ProgramCache::kernel(const std::string &name, const std::string &defines, const std::string &header)
+{
+	Lock lock(mutex_);
+
+	ProgramKey program_key(header, defines);
+	std::pair<std::string, ProgramKey> key(name, program_key);
+	std::map<std::pair<std::string, ProgramKey>, std::shared_ptr<KernelSource>>::iterator it = kernels_.find(key);
+	if (it != kernels_.end())
+		return *it->second;
+
+	std::shared_ptr<ProgramBinaries> &program = programs_[program_key];
+	if (!program) {
+		if (header.empty()) {
+			program = std::make_shared<ProgramBinaries>(source_code_, source_code_length_, defines, program_name_);
+		} else {
+			// programs keep pointer to the source code, so it lives as long as the cache
+			std::shared_ptr<std::string> &source = sources_[header];
+			if (!source)
+				source = std::make_shared<std::string>(header + "\n" + std::string(source_code_, source_code_length_));
+			program = std::make_shared<ProgramBinaries>(source->data(), source->size(), defines, program_name_);
+		}
+	}
+
+	std::shared_ptr<KernelSource> kernel = std::make_shared<KernelSource>(program, name);
+	kernels_[key] = kernel;
+	return *kernel;
+}
+
+template <typename T>
+struct TypeLimits;
+
+template <> struct TypeLimits<int8_t>	{ static const char *lowest() { return "CHAR_MIN";	}	static const char *highest() { return "CHAR_MAX";	} };
+template <> struct TypeLimits<int16_t>	{ static const char *lowest() { return "SHRT_MIN";	}	static const char *highest() { return "SHRT_MAX";	} };
+template <> struct TypeLimits<int32_t>	{ static const char *lowest() { return "INT_MIN";	}	static const char *highest() { return "INT_MAX";	} };
+template <> struct TypeLimits<uint8_t>	{ static const char *lowest() { return "0";			}	static const char *highest() { return "UCHAR_MAX";	} };
+template <> struct TypeLimits<uint16_t>	{ static const char *lowest() { return "0";			}	static const char *highest() { return "USHRT_MAX";	} };
+template <> struct TypeLimits<uint32_t>	{ static const char *lowest() { return "0";			}	static const char *highest() { return "UINT_MAX";	} };
+template <> struct TypeLimits<int64_t>	{ static const char *lowest() { return "LONG_MIN";	}	static const char *highest() { return "LONG_MAX";	} };
+template <> struct TypeLimits<uint64_t>	{ static const char *lowest() { return "0";			}	static const char *highest() { return "ULONG_MAX";	} };
+template <> struct TypeLimits<float>	{ static const char *lowest() { return "(-FLT_MAX)";}	static const char *highest() { return "FLT_MAX";	} };
+template <> struct TypeLimits<double>	{ static const char *lowest() { return "(-DBL_MAX)";}	static const char *highest() { return "DBL_MAX";	} };
+
+template <typename T>
+std::string typeDefines(const std::string &prefix)
+{
+	std::string name = OpenCLType<T>::name();
+	std::string defines = " -D " + prefix + "=" + name
+						+ " -D " + prefix + "4=" + name + "4"
+						+ " -D " + prefix + "_LOWEST=" + TypeLimits<T>::lowest()
+						+ " -D " + prefix + "_HIGHEST=" + TypeLimits<T>::highest();
+	if (name == "double")
+		defines += " -D " + prefix + "_IS_DOUBLE";
+	return defines;
+}
+
+template std::string typeDefines<int8_t>(const std::string &prefix);
+template std::string typeDefines<int16_t>(const std::string &prefix);
+template std::string typeDefines<int32_t>(const std::string &prefix);
+template std::string typeDefines<uint8_t>(const std::string &prefix);
+template std::string typeDefines<uint16_t>(const std::string &prefix);
+template std::string typeDefines<uint32_t>(const std::string &prefix);
+template std::string typeDefines<int64_t>(const std::string &prefix);
+template std::string typeDefines<uint64_t>(const std::string &prefix);
+template std::string typeDefines<float>(const std::string &prefix);
+template std::string typeDefines<double>(const std::string &prefix);
+
+}
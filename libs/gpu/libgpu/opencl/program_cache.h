@@ -0,0 +1,40 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <libgpu/opencl/engine.h>
+#include <libutils/thread_mutex.h>
+
+namespace ocl {
+
+// Kernels of library primitives (reduce, scan, ...) are written once for generic element types and operations
+// selected by defines, and compiled lazily for every combination of defines that is actually used.
+// Programs are created once per process and shared by all threads and engines.
+// Operations that can't be expressed with defines (comparators of user types, predicates) are passed as header -
+// OpenCL code that is put before the source code of the program.
+class ProgramCache {
+public:
+	ProgramCache(const char *source_code, size_t source_code_length, const std::string &program_name);
+
+	KernelSource &			kernel(const std::string &name, const std::string &defines, const std::string &header = std::string());
+
+protected:
+	const char *			source_code_;
+	size_t					source_code_length_;
+	std::string				program_name_;
+
+	typedef std::pair<std::string, std::string> ProgramKey;	// header and defines
+
+	Mutex					mutex_;
+	std::map<std::string, std::shared_ptr<std::string>>									sources_;	// header + source code, referenced by programs
+	std::map<ProgramKey, std::shared_ptr<ProgramBinaries>>								programs_;
+	std::map<std::pair<std::string, ProgramKey>, std::shared_ptr<KernelSource>>			kernels_;
+};
+
+// Defines describing element type T for kernels: <prefix>=float <prefix>4=float4 <prefix>_LOWEST=(-FLT_MAX) <prefix>_HIGHEST=FLT_MAX
+// and <prefix>_IS_DOUBLE for double (such kernels should enable cl_khr_fp64)
+template <typename T>
+std::string typeDefines(const std::string &prefix = "T");
+
+}
@@ -0,0 +1,110 @@
+#include "sub_devices.h"
+#include "utils.h"
+
+namespace ocl {
+
+SubDevices::SubDevices()
+{
+}
+
+SubDevices::~SubDevices()
+{
+	release();
+}
+
+bool SubDevices::isSupported(cl_device_id device)
+{
+	cl_uint max_sub_devices = 0;
+	// OpenCL 1.1 drivers do not know this parameter, as well as libclew without clCreateSubDevices in the driver
+	if (clGetDeviceInfo(device, CL_DEVICE_PARTITION_MAX_SUB_DEVICES, sizeof(max_sub_devices), &max_sub_devices, NULL) != CL_SUCCESS)
+		return false;
+	return max_sub_devices > 1;
+}
+
+bool SubDevices::isPartitionSupported(cl_device_id device, cl_device_partition_property type)
+{
+	if (!isSupported(device))
+		return false;
+
+	size_t size = 0;
+	if (clGetDeviceInfo(device, CL_DEVICE_PARTITION_PROPERTIES, 0, NULL, &size) != CL_SUCCESS)
+		return false;
+	std::vector<cl_device_partition_property> types(size / sizeof(cl_device_partition_property));
+	if (types.empty() || clGetDeviceInfo(device, CL_DEVICE_PARTITION_PROPERTIES, size, types.data(), NULL) != CL_SUCCESS)
+		return false;
+	for (size_t k = 0; k < types.size() && types[k] != 0; ++k) {
+		if (types[k] == type)
+			return true;
+	}
+	return false;
+}
+
+bool SubDevices::isAffinityDomainSupported(cl_device_id device, cl_device_affinity_domain domain)
+{
+	if (!isPartitionSupported(device, CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN))
+		return false;
+
+	cl_device_affinity_domain domains = 0;
+	if (clGetDeviceInfo(device, CL_DEVICE_PARTITION_AFFINITY_DOMAIN, sizeof(domains), &domains, NULL) != CL_SUCCESS)
+		return false;
+	return (domains & domain) != 0;
+}
+
+void SubDevices::partitionEqually(cl_device_id device, unsigned int compute_units)
+{
+	const cl_device_partition_property properties[] = { CL_DEVICE_PARTITION_EQUALLY, (cl_device_partition_property) compute_units, 0 };
+	partition(device, properties);
+}
+
+void SubDevices::partitionByCounts(cl_device_id device, const std::vector<unsigned int> &compute_units)
+{
+	std::vector<cl_device_partition_property> properties;
+	properties.push_back(CL_DEVICE_PARTITION_BY_COUNTS);
+	for (size_t k = 0; k < compute_units.size(); ++k)
+		properties.push_back((cl_device_partition_property) compute_units[k]);
+	properties.push_back(CL_DEVICE_PARTITION_BY_COUNTS_LIST_END);
+	properties.push_back(0);
+	partition(device, properties.data());
+}
+
+void SubDevices::partitionByAffinityDomain(cl_device_id device, cl_device_affinity_domain domain)
+{
+	const cl_device_partition_property properties[] = { CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN, (cl_device_partition_property) domain, 0 };
+	partition(device, properties);
+}
+
+void SubDevices::partition(cl_device_id device, const cl_device_partition_property *properties)
+{
+	if (!isSupported(device))
+		throw ocl_exception("Device can't be partitioned into sub-devices (OpenCL 1.2 clCreateSubDevices is required)");
+
+	release();
+
+	cl_uint ndevices = 0;
+	OCL_SAFE_CALL_MESSAGE(clCreateSubDevices(device, properties, 0, NULL, &ndevices), "clCreateSubDevices: ");
+
+	std::vector<cl_device_id> devices(ndevices);
+	OCL_SAFE_CALL_MESSAGE(clCreateSubDevices(device, properties, ndevices, devices.data(), NULL), "clCreateSubDevices: ");
+
+	devices_ = devices;
+}
+
+void SubDevices::release()
+{
+	for (size_t k = 0; k < devices_.size(); ++k)
+		clReleaseDevice(devices_[k]);
+	devices_.clear();
+}
+
+std::vector<sh_ptr_ocl_engine> SubDevices::createEngines() const
+{
+	std::vector<sh_ptr_ocl_engine> engines;
+	for (size_t k = 0; k < devices_.size(); ++k) {
+		sh_ptr_ocl_engine engine = std::make_shared<OpenCLEngine>();
+		engine->init(devices_[k]);
+		engines.push_back(engine);
+	}
+	return engines;
+}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <CL/cl.h>
+#include "engine.h"
+
+namespace ocl {
+
+// Partition of an OpenCL device (in practice a multi-socket CPU) into sub-devices with clCreateSubDevices (OpenCL 1.2).
+// Every sub-device is a regular cl_device_id, so gpu::Context::init(subDevices.device(i)) or createEngines() gives
+// each of them its own engine. With one sub-device per NUMA node work can be pinned near its memory,
+// with several small sub-devices independent pipelines do not compete for the same cores.
+// Sub-devices are released in destructor, so SubDevices should outlive initialization of contexts that use them
+// (created OpenCL contexts retain their devices themselves).
+class SubDevices {
+public:
+	SubDevices();
+	~SubDevices();
+
+	static bool			isSupported(cl_device_id device);	// true if driver provides clCreateSubDevices and device can be partitioned
+	static bool			isPartitionSupported(cl_device_id device, cl_device_partition_property type);		// true if device supports partitioning of this type
+	static bool			isAffinityDomainSupported(cl_device_id device, cl_device_affinity_domain domain);		// true if device can be partitioned by this affinity domain
+
+	void				partitionEqually(cl_device_id device, unsigned int compute_units);
+	void				partitionByCounts(cl_device_id device, const std::vector<unsigned int> &compute_units);
+	void				partitionByAffinityDomain(cl_device_id device, cl_device_affinity_domain domain = CL_DEVICE_AFFINITY_DOMAIN_NUMA);
+
+	size_t				size() const					{ return devices_.size();	}
+	cl_device_id		device(size_t index) const		{ return devices_[index];	}
+	const std::vector<cl_device_id> &	devices() const	{ return devices_;			}
+
+	std::vector<sh_ptr_ocl_engine>	createEngines() const;	// one engine per sub-device
+
+protected:
+	void				partition(cl_device_id device, const cl_device_partition_property *properties);
+	void				release();
+
+	std::vector<cl_device_id>	devices_;
+
+private:
+	SubDevices(const SubDevices &);
+	SubDevices &operator= (const SubDevices &);
+};
+
+}
@@ -19,6 +19,7 @@ std::string errorString(cl_int code)
 	case CL_IMAGE_FORMAT_NOT_SUPPORTED:			return "CL_IMAGE_FORMAT_NOT_SUPPORTED";
 	case CL_BUILD_PROGRAM_FAILURE:				return "CL_BUILD_PROGRAM_FAILURE";
 	case CL_MAP_FAILURE:						return "CL_MAP_FAILURE";
+	case CL_DEVICE_PARTITION_FAILED:			return "CL_DEVICE_PARTITION_FAILED";
 
 	case CL_INVALID_VALUE:						return "CL_INVALID_VALUE";
 	case CL_INVALID_DEVICE_TYPE:				return "CL_INVALID_DEVICE_TYPE";
@@ -54,6 +55,7 @@ std::string errorString(cl_int code)
 	case CL_INVALID_BUFFER_SIZE:				return "CL_INVALID_BUFFER_SIZE";
 	case CL_INVALID_MIP_LEVEL:					return "CL_INVALID_MIP_LEVEL";
 	case CL_INVALID_GLOBAL_WORK_SIZE:			return "CL_INVALID_GLOBAL_WORK_SIZE";
+	case CL_INVALID_DEVICE_PARTITION_COUNT:		return "CL_INVALID_DEVICE_PARTITION_COUNT";
 	default:									return "CL_UNKNOWN_ERROR_CODE_" + to_string(code);
 	}
 }
@@ -48,7 +48,7 @@ public:
 
 std::string errorString(cl_int code);
 
-static inline void reportError(cl_int err, int line, std::string prefix="")
+static inline void reportError(cl_int err, int line, std::string prefix)
 {
 	if (CL_SUCCESS == err)
 		return;
@@ -63,7 +63,16 @@ static inline void reportError(cl_int err, int line, std::string prefix="")
 	}
 }
 
-#define OCL_SAFE_CALL(expr)  ocl::reportError(expr, __LINE__, "")
-#define OCL_SAFE_CALL_MESSAGE(expr, message)  ocl::reportError(expr, __LINE__, message)
+static inline void reportError(cl_int err, int line)
+{
+	if (CL_SUCCESS == err)
+		return;
+
+	reportError(err, line, "");
+}
+
+#define OCL_SAFE_CALL(expr)  ocl::reportError(expr, __LINE__)
+// message is evaluated only if expr fails, so it can be built on the fly without slowing down successful calls
+#define OCL_SAFE_CALL_MESSAGE(expr, message)  do { cl_int ocl_safe_call_err = (expr); if (ocl_safe_call_err != CL_SUCCESS) ocl::reportError(ocl_safe_call_err, __LINE__, message); } while (false)
 
 }
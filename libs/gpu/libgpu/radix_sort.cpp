@@ -0,0 +1,131 @@
+#include "radix_sort.h"
+#include "context.h"
+#include "scan.h"
+#include "work_size.h"
+
+#include <libgpu/opencl/program_cache.h>
+#include <libutils/string_utils.h>
+
+#include "opencl/cl/radix_sort_cl.h"
+
+#include <limits>
+
+namespace gpu {
+
+// Every work group sorts a block of 256 * 4 keys in local memory: two copies of keys and values take 24 KB for 64-bit keys
+static const unsigned int radix_sort_workgroup_size		= 256;
+static const unsigned int radix_sort_values_per_item	= 4;
+static const unsigned int radix_sort_block_size			= radix_sort_workgroup_size * radix_sort_values_per_item;
+static const unsigned int radix_sort_max_bits			= 8;
+
+static ocl::ProgramCache radix_sort_programs(radix_sort_kernel, radix_sort_kernel_length, "radix_sort");
+
+// How keys are sorted by kernels: as unsigned integers of the same width after order-preserving transformation (KEY_ORDER in radix_sort.cl)
+template <typename K>
+struct RadixSortKey;
+
+template <> struct RadixSortKey<uint32_t>	{ static const char *bits() { return "uint";	}	static int order() { return 0; } };
+template <> struct RadixSortKey<int32_t>	{ static const char *bits() { return "uint";	}	static int order() { return 1; } };
+template <> struct RadixSortKey<float>		{ static const char *bits() { return "uint";	}	static int order() { return 2; } };
+template <> struct RadixSortKey<uint64_t>	{ static const char *bits() { return "ulong";	}	static int order() { return 0; } };
+template <> struct RadixSortKey<int64_t>	{ static const char *bits() { return "ulong";	}	static int order() { return 1; } };
+template <> struct RadixSortKey<double>		{ static const char *bits() { return "ulong";	}	static int order() { return 2; } };
+
+template <typename K>
+static void radixSortPasses(gpu_mem_any &keys, gpu_mem_any *values, size_t n, unsigned int bitsPerPass)
+{
+	if (bitsPerPass < 1 || bitsPerPass > radix_sort_max_bits)
+		throw gpu_exception("Radix sort supports from 1 to " + to_string(radix_sort_max_bits) + " bits per pass, but " + to_string(bitsPerPass) + " requested!");
+	if (n > keys.size() / sizeof(K))
+		throw gpu_exception("Not enough keys in device buffer: " + to_string(n) + " > " + to_string(keys.size() / sizeof(K)));
+	if (values && n > values->size() / sizeof(unsigned int))
+		throw gpu_exception("Not enough values in device buffer: " + to_string(n) + " > " + to_string(values->size() / sizeof(unsigned int)));
+	if (n > std::numeric_limits<unsigned int>::max() - radix_sort_block_size)
+		throw gpu_exception("Radix sort supports at most 2^32-" + to_string(radix_sort_block_size + 1) + " elements, but " + to_string(n) + " requested!");
+	if (n <= 1)
+		return;
+
+	std::string defines = "-D KEY_BITS=" + std::string(RadixSortKey<K>::bits())
+						+ " -D KEY_ORDER=" + to_string(RadixSortKey<K>::order())
+						+ " -D RADIX_BITS=" + to_string(bitsPerPass)
+						+ " -D WORKGROUP_SIZE=" + to_string(radix_sort_workgroup_size);
+	if (values)
+		defines += " -D HAS_VALUES";
+
+	unsigned int nblocks = divup((unsigned int) n, radix_sort_block_size);
+	unsigned int nbuckets = 1 << bitsPerPass;
+	WorkSize ws(radix_sort_workgroup_size, nblocks * radix_sort_workgroup_size);
+
+	gpu_mem_32u counts = gpu_mem_32u::createN(nbuckets * nblocks);
+	gpu_mem_any keys_buffer = gpu_mem_any::create(n * sizeof(K));
+	gpu_mem_any values_buffer = gpu_mem_any::create(values ? n * sizeof(unsigned int) : 1);
+
+	// passes go back and forth between the sorted buffers and temporary ones; without values keys are passed instead,
+	// kernels compiled without HAS_VALUES never touch them
+	gpu_mem_any *src_keys = &keys;
+	gpu_mem_any *dst_keys = &keys_buffer;
+	gpu_mem_any *src_values = values ? values : &keys;
+	gpu_mem_any *dst_values = values ? &values_buffer : &keys_buffer;
+
+	unsigned int passes = divup((unsigned int) (sizeof(K) * 8), bitsPerPass);
+	for (unsigned int pass = 0; pass < passes; ++pass) {
+		unsigned int shift = pass * bitsPerPass;
+		radix_sort_programs.kernel("radix_sort_count", defines, scanLocalHeader()).exec(ws, *src_keys, (unsigned int) n, shift, counts, nblocks);
+		exclusiveScan(counts, counts);
+		radix_sort_programs.kernel("radix_sort_scatter", defines, scanLocalHeader()).exec(ws, *src_keys, *src_values, (unsigned int) n, shift,
+				counts, nblocks, *dst_keys, *dst_values);
+		std::swap(src_keys, dst_keys);
+		std::swap(src_values, dst_values);
+	}
+
+	if (src_keys != &keys) {
+		src_keys->copyTo(keys, n * sizeof(K));
+		if (values)
+			src_values->copyTo(*values, n * sizeof(unsigned int));
+	}
+}
+
+template <typename K>
+void radixSort(shared_device_buffer_typed<K> &keys)
+{
+	radixSortPasses<K>(keys, NULL, keys.number(), 4);
+}
+
+template <typename K>
+void radixSort(shared_device_buffer_typed<K> &keys, size_t n, unsigned int bitsPerPass)
+{
+	radixSortPasses<K>(keys, NULL, n, bitsPerPass);
+}
+
+template <typename K, typename V>
+void radixSort(shared_device_buffer_typed<K> &keys, shared_device_buffer_typed<V> &values)
+{
+	radixSort(keys, values, keys.number(), 4);
+}
+
+template <typename K, typename V>
+void radixSort(shared_device_buffer_typed<K> &keys, shared_device_buffer_typed<V> &values, size_t n, unsigned int bitsPerPass)
+{
+	static_assert(sizeof(V) == sizeof(unsigned int), "Only 32-bit values are supported");
+	radixSortPasses<K>(keys, &values, n, bitsPerPass);
+}
+
+#define INSTANTIATE_RADIX_SORT_VALUES(K, V) \
+	template void radixSort<K, V>(shared_device_buffer_typed<K> &keys, shared_device_buffer_typed<V> &values); \
+	template void radixSort<K, V>(shared_device_buffer_typed<K> &keys, shared_device_buffer_typed<V> &values, size_t n, unsigned int bitsPerPass);
+
+#define INSTANTIATE_RADIX_SORT(K) \
+	template void radixSort<K>(shared_device_buffer_typed<K> &keys); \
+	template void radixSort<K>(shared_device_buffer_typed<K> &keys, size_t n, unsigned int bitsPerPass); \
+	INSTANTIATE_RADIX_SORT_VALUES(K, uint32_t) \
+	INSTANTIATE_RADIX_SORT_VALUES(K, int32_t) \
+	INSTANTIATE_RADIX_SORT_VALUES(K, float)
+
+INSTANTIATE_RADIX_SORT(uint32_t)
+INSTANTIATE_RADIX_SORT(int32_t)
+INSTANTIATE_RADIX_SORT(float)
+INSTANTIATE_RADIX_SORT(uint64_t)
+INSTANTIATE_RADIX_SORT(int64_t)
+INSTANTIATE_RADIX_SORT(double)
+
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+// Stable LSD radix sort of first n keys (whole buffer if n is not specified) in ascending order with the active context, in place.
+// Keys can be uint32_t, int32_t, float, uint64_t, int64_t or double. Signed and floating point keys are sorted as unsigned integers
+// after flipping their sign bit (and all bits of negative floating point numbers), so -0 goes before +0 and NaNs go to the ends.
+// Every pass sorts by bitsPerPass bits (1 to 8): histograms of blocks in local memory, exclusive scan of all histograms
+// with gpu::exclusiveScan, scatter of locally sorted blocks. More bits mean fewer passes, but bigger histograms and local sorts.
+template <typename K>
+void radixSort(shared_device_buffer_typed<K> &keys);
+
+template <typename K>
+void radixSort(shared_device_buffer_typed<K> &keys, size_t n, unsigned int bitsPerPass = 4);
+
+// Key-value sort: 32-bit values (uint32_t, int32_t or float) are moved together with their keys, values of equal keys keep their order
+template <typename K, typename V>
+void radixSort(shared_device_buffer_typed<K> &keys, shared_device_buffer_typed<V> &values);
+
+template <typename K, typename V>
+void radixSort(shared_device_buffer_typed<K> &keys, shared_device_buffer_typed<V> &values, size_t n, unsigned int bitsPerPass = 4);
+
+}
@@ -0,0 +1,108 @@
+#include "reduce.h"
+#include "context.h"
+#include "work_size.h"
+
+#include <libgpu/opencl/program_cache.h>
+#include <libutils/string_utils.h>
+
+#include "opencl/cl/reduce_cl.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace gpu {
+
+// Tuned for GPUs: 256 work items per group, each loads 4 values at a time,
+// and at most 1024 groups in the first pass, so that the final pass is a single short loop of one work group
+static const unsigned int reduce_workgroup_size	= 256;
+static const unsigned int reduce_values_per_item	= 4;
+static const unsigned int reduce_max_groups		= 1024;
+
+static ocl::ProgramCache reduce_programs(reduce_kernel, reduce_kernel_length, "reduce");
+
+static const char *opDefine(ReduceOp op)
+{
+	switch (op) {
+	case ReduceSum:		return "REDUCE_SUM";
+	case ReduceMin:		return "REDUCE_MIN";
+	case ReduceMax:		return "REDUCE_MAX";
+	case ReduceArgMin:	return "REDUCE_ARGMIN";
+	case ReduceArgMax:	return "REDUCE_ARGMAX";
+	}
+	throw gpu_exception("Unknown reduce operation " + to_string((int) op) + "!");
+}
+
+template <typename T>
+T reduce(const shared_device_buffer_typed<T> &buffer, ReduceOp op, size_t *index)
+{
+	return reduce(buffer, buffer.number(), op, index);
+}
+
+template <typename T>
+T reduce(const shared_device_buffer_typed<T> &buffer, size_t n, ReduceOp op, size_t *index)
+{
+	if (n == 0)
+		throw gpu_exception("Can't reduce empty range!");
+	if (n > buffer.number())
+		throw gpu_exception("Not enough data in device buffer: " + to_string(n) + " > " + to_string(buffer.number()));
+	if (n > std::numeric_limits<unsigned int>::max())
+		throw gpu_exception("Reduce supports at most 2^32-1 elements, but " + to_string(n) + " requested!");
+
+	bool with_index = (op == ReduceArgMin || op == ReduceArgMax);
+
+	std::string defines = ocl::typeDefines<T>() + " -D " + opDefine(op) + " -D WORKGROUP_SIZE=" + to_string(reduce_workgroup_size);
+	ocl::KernelSource &reduce_values	= reduce_programs.kernel("reduce_values", defines);
+	ocl::KernelSource &reduce_partials	= reduce_programs.kernel("reduce_partials", defines);
+
+	unsigned int ngroups = std::min(divup((unsigned int) n, reduce_workgroup_size * reduce_values_per_item), reduce_max_groups);
+
+	gpu_mem_any partial_values		= gpu_mem_any::create(ngroups * sizeof(T));
+	gpu_mem_any partial_indices		= gpu_mem_any::create(ngroups * sizeof(unsigned int));
+
+	// buffers are passed untyped, so that any element type can be used as kernel argument
+	reduce_values.exec(WorkSize(reduce_workgroup_size, ngroups * reduce_workgroup_size),
+					   (const gpu_mem_any &) buffer, (unsigned int) n, partial_values, partial_indices);
+
+	if (ngroups > 1) {
+		gpu_mem_any result_value	= gpu_mem_any::create(sizeof(T));
+		gpu_mem_any result_index	= gpu_mem_any::create(sizeof(unsigned int));
+		reduce_partials.exec(WorkSize(reduce_workgroup_size, reduce_workgroup_size),
+							 partial_values, partial_indices, ngroups, result_value, result_index);
+		partial_values	= result_value;
+		partial_indices	= result_index;
+	}
+
+	T result;
+	partial_values.read(&result, sizeof(T));
+	if (index) {
+		unsigned int result_index = 0;
+		if (with_index)
+			partial_indices.read(&result_index, sizeof(unsigned int));
+		*index = result_index;
+	}
+	return result;
+}
+
+template int8_t		reduce<int8_t>	(const shared_device_buffer_typed<int8_t>	&buffer, ReduceOp op, size_t *index);
+template int16_t	reduce<int16_t>	(const shared_device_buffer_typed<int16_t>	&buffer, ReduceOp op, size_t *index);
+template int32_t	reduce<int32_t>	(const shared_device_buffer_typed<int32_t>	&buffer, ReduceOp op, size_t *index);
+template uint8_t	reduce<uint8_t>	(const shared_device_buffer_typed<uint8_t>	&buffer, ReduceOp op, size_t *index);
+template uint16_t	reduce<uint16_t>(const shared_device_buffer_typed<uint16_t>	&buffer, ReduceOp op, size_t *index);
+template uint32_t	reduce<uint32_t>(const shared_device_buffer_typed<uint32_t>	&buffer, ReduceOp op, size_t *index);
+template int64_t	reduce<int64_t>	(const shared_device_buffer_typed<int64_t>	&buffer, ReduceOp op, size_t *index);
+template uint64_t	reduce<uint64_t>(const shared_device_buffer_typed<uint64_t>	&buffer, ReduceOp op, size_t *index);
+template float		reduce<float>	(const shared_device_buffer_typed<float>	&buffer, ReduceOp op, size_t *index);
+template double		reduce<double>	(const shared_device_buffer_typed<double>	&buffer, ReduceOp op, size_t *index);
+
+template int8_t		reduce<int8_t>	(const shared_device_buffer_typed<int8_t>	&buffer, size_t n, ReduceOp op, size_t *index);
+template int16_t	reduce<int16_t>	(const shared_device_buffer_typed<int16_t>	&buffer, size_t n, ReduceOp op, size_t *index);
+template int32_t	reduce<int32_t>	(const shared_device_buffer_typed<int32_t>	&buffer, size_t n, ReduceOp op, size_t *index);
+template uint8_t	reduce<uint8_t>	(const shared_device_buffer_typed<uint8_t>	&buffer, size_t n, ReduceOp op, size_t *index);
+template uint16_t	reduce<uint16_t>(const shared_device_buffer_typed<uint16_t>	&buffer, size_t n, ReduceOp op, size_t *index);
+template uint32_t	reduce<uint32_t>(const shared_device_buffer_typed<uint32_t>	&buffer, size_t n, ReduceOp op, size_t *index);
+template int64_t	reduce<int64_t>	(const shared_device_buffer_typed<int64_t>	&buffer, size_t n, ReduceOp op, size_t *index);
+template uint64_t	reduce<uint64_t>(const shared_device_buffer_typed<uint64_t>	&buffer, size_t n, ReduceOp op, size_t *index);
+template float		reduce<float>	(const shared_device_buffer_typed<float>	&buffer, size_t n, ReduceOp op, size_t *index);
+template double		reduce<double>	(const shared_device_buffer_typed<double>	&buffer, size_t n, ReduceOp op, size_t *index);
+
+}
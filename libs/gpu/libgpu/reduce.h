@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+enum ReduceOp {
+	ReduceSum,
+	ReduceMin,
+	ReduceMax,
+	ReduceArgMin,
+	ReduceArgMax
+};
+
+// Reduces first n elements of device buffer (whole buffer if n is not specified) with the active context,
+// only the final value is read back to host. Sum is accumulated in T, so for small integer types it wraps around.
+// ReduceArgMin/ReduceArgMax return the minimum/maximum and store index of its first occurrence into *index.
+template <typename T>
+T reduce(const shared_device_buffer_typed<T> &buffer, ReduceOp op, size_t *index = NULL);
+
+template <typename T>
+T reduce(const shared_device_buffer_typed<T> &buffer, size_t n, ReduceOp op, size_t *index = NULL);
+
+}
@@ -0,0 +1,103 @@
+#include "scan.h"
+#include "context.h"
+#include "work_size.h"
+
+#include <libgpu/opencl/program_cache.h>
+#include <libutils/string_utils.h>
+
+#include "opencl/cl/scan_cl.h"
+#include "opencl/cl/scan_local_cl.h"
+
+#include <limits>
+
+namespace gpu {
+
+// Every work group scans a block of 256 * 4 values, so each level of recursion over block sums is 1024 times smaller
+static const unsigned int scan_workgroup_size	= 256;
+static const unsigned int scan_values_per_item	= 4;
+static const unsigned int scan_block_size		= scan_workgroup_size * scan_values_per_item;
+
+static ocl::ProgramCache scan_programs(scan_kernel, scan_kernel_length, "scan");
+
+const std::string &scanLocalHeader()
+{
+	static const std::string header(scan_local_kernel, scan_local_kernel_length);
+	return header;
+}
+
+template <typename T>
+static void scanLevel(const gpu_mem_any &values, gpu_mem_any &result, unsigned int n, bool exclusive, const std::string &defines)
+{
+	unsigned int nblocks = divup(n, scan_block_size);
+	WorkSize ws(scan_workgroup_size, nblocks * scan_workgroup_size);
+
+	gpu_mem_any block_sums = gpu_mem_any::create(nblocks * sizeof(T));
+	scan_programs.kernel("scan_blocks", defines, scanLocalHeader()).exec(ws, values, result, n, block_sums, (int) exclusive);
+
+	if (nblocks > 1) {
+		// offsets of blocks are exclusive scan of their sums
+		scanLevel<T>(block_sums, block_sums, nblocks, true, defines);
+		scan_programs.kernel("add_block_offsets", defines, scanLocalHeader()).exec(ws, result, n, block_sums);
+	}
+}
+
+template <typename T>
+static void scan(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, size_t n, bool exclusive)
+{
+	if (n > values.number())
+		throw gpu_exception("Not enough data in device buffer: " + to_string(n) + " > " + to_string(values.number()));
+	if (n > std::numeric_limits<unsigned int>::max())
+		throw gpu_exception("Scan supports at most 2^32-1 elements, but " + to_string(n) + " requested!");
+	if (n == 0)
+		return;
+
+	if (result.number() < n)
+		result.resizeN(n);
+
+	std::string defines = ocl::typeDefines<T>() + " -D SCAN_LOCAL_T=T -D WORKGROUP_SIZE=" + to_string(scan_workgroup_size);
+	// buffers are passed untyped, so that any element type can be used as kernel argument
+	scanLevel<T>(values, result, (unsigned int) n, exclusive, defines);
+}
+
+template <typename T>
+void inclusiveScan(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result)
+{
+	scan(values, result, values.number(), false);
+}
+
+template <typename T>
+void inclusiveScan(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, size_t n)
+{
+	scan(values, result, n, false);
+}
+
+template <typename T>
+void exclusiveScan(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result)
+{
+	scan(values, result, values.number(), true);
+}
+
+template <typename T>
+void exclusiveScan(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, size_t n)
+{
+	scan(values, result, n, true);
+}
+
+#define INSTANTIATE_SCAN(T) \
+	template void inclusiveScan<T>(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result); \
+	template void inclusiveScan<T>(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, size_t n); \
+	template void exclusiveScan<T>(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result); \
+	template void exclusiveScan<T>(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, size_t n);
+
+INSTANTIATE_SCAN(int8_t)
+INSTANTIATE_SCAN(int16_t)
+INSTANTIATE_SCAN(int32_t)
+INSTANTIATE_SCAN(int64_t)
+INSTANTIATE_SCAN(uint8_t)
+INSTANTIATE_SCAN(uint16_t)
+INSTANTIATE_SCAN(uint32_t)
+INSTANTIATE_SCAN(uint64_t)
+INSTANTIATE_SCAN(float)
+INSTANTIATE_SCAN(double)
+
+}
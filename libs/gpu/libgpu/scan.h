@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+// Prefix sums of first n values (whole buffer if n is not specified) with the active context:
+// inclusive scan gives result[i] = values[0] + ... + values[i], exclusive scan gives result[i] = values[0] + ... + values[i - 1].
+// Result is resized if it is too small, scan can be done in place (result is the same buffer as values).
+// Sums are accumulated in T, so for small integer types they wrap around.
+template <typename T>
+void inclusiveScan(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result);
+
+template <typename T>
+void inclusiveScan(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, size_t n);
+
+template <typename T>
+void exclusiveScan(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result);
+
+template <typename T>
+void exclusiveScan(const shared_device_buffer_typed<T> &values, shared_device_buffer_typed<T> &result, size_t n);
+
+// Source of scan_local.cl - scan of a work group in local memory, passed as ProgramCache header to kernels that need it
+const std::string &scanLocalHeader();
+
+}
@@ -76,9 +76,11 @@ typedef shared_device_buffer						gpu_mem_any;
 typedef shared_device_buffer_typed<int8_t>			gpu_mem_8i;
 typedef shared_device_buffer_typed<int16_t>			gpu_mem_16i;
 typedef shared_device_buffer_typed<int32_t>			gpu_mem_32i;
+typedef shared_device_buffer_typed<int64_t>			gpu_mem_64i;
 typedef shared_device_buffer_typed<uint8_t>			gpu_mem_8u;
 typedef shared_device_buffer_typed<uint16_t>		gpu_mem_16u;
 typedef shared_device_buffer_typed<uint32_t>		gpu_mem_32u;
+typedef shared_device_buffer_typed<uint64_t>		gpu_mem_64u;
 typedef shared_device_buffer_typed<float>			gpu_mem_32f;
 typedef shared_device_buffer_typed<double>			gpu_mem_64f;
 
@@ -0,0 +1,168 @@
+#include "sort.h"
+#include "context.h"
+#include "work_size.h"
+
+#include <libgpu/opencl/program_cache.h>
+#include <libutils/string_utils.h>
+
+#include "opencl/cl/sort_cl.h"
+
+#include <limits>
+#include <algorithm>
+
+namespace gpu {
+
+// Block of bitonic sort and tile of merge are the same: as many elements as fit into 16 KB of local memory,
+// at most 1024 and at least 64. Every work item handles 2 to 4 elements.
+static const size_t sort_local_memory		= 16 * 1024;
+static const size_t sort_max_block_size	= 1024;
+static const size_t sort_min_block_size	= 64;
+static const size_t sort_max_workgroup_size	= 256;
+
+static ocl::ProgramCache sort_programs(sort_kernel, sort_kernel_length, "sort");
+
+SortComparator::SortComparator(const std::string &type_name, size_t type_size, const std::string &less, const std::string &declarations)
+	: type_name(type_name), type_size(type_size), less(less), declarations(declarations)
+{
+	if (type_size == 0)
+		throw gpu_exception("Size of " + type_name + " can't be zero!");
+}
+
+template <typename T>
+static std::string builtinDeclarations()
+{
+	return std::string(ocl::OpenCLType<T>::name()) == "double" ? "#pragma OPENCL EXTENSION cl_khr_fp64 : enable" : "";
+}
+
+template <typename T>
+SortComparator ascendingOrder()
+{
+	return SortComparator(ocl::OpenCLType<T>::name(), sizeof(T), "a < b", builtinDeclarations<T>());
+}
+
+template <typename T>
+SortComparator descendingOrder()
+{
+	return SortComparator(ocl::OpenCLType<T>::name(), sizeof(T), "b < a", builtinDeclarations<T>());
+}
+
+static size_t blockSize(const SortComparator &comparator)
+{
+	if (comparator.type_size * sort_min_block_size > sort_local_memory)
+		throw gpu_exception("Elements of " + to_string(comparator.type_size) + " bytes are too big for sort, at most "
+							+ to_string(sort_local_memory / sort_min_block_size) + " bytes are supported!");
+
+	size_t block_size = sort_max_block_size;
+	while (block_size * comparator.type_size > sort_local_memory)
+		block_size /= 2;
+	return block_size;
+}
+
+static size_t workgroupSize(size_t block_size)
+{
+	return std::min(sort_max_workgroup_size, block_size / 2);
+}
+
+// Type and comparator are put before the source code of the program, sizes are passed as defines
+static ocl::KernelSource &sortKernel(const std::string &name, const SortComparator &comparator)
+{
+	size_t block_size = blockSize(comparator);
+
+	std::string header = comparator.declarations + "\n"
+						 + "#define T " + comparator.type_name + "\n"
+						 + "bool sort_less(const T a, const T b) { return (" + comparator.less + "); }\n";
+	std::string defines = "-D WORKGROUP_SIZE=" + to_string(workgroupSize(block_size))
+						+ " -D BLOCK_SIZE=" + to_string(block_size)
+						+ " -D TILE_SIZE=" + to_string(block_size);
+	return sort_programs.kernel(name, defines, header);
+}
+
+static void checkSize(const gpu_mem_any &buffer, size_t n, const SortComparator &comparator)
+{
+	if (n > buffer.size() / comparator.type_size)
+		throw gpu_exception("Not enough data in device buffer: " + to_string(n) + " > " + to_string(buffer.size() / comparator.type_size));
+	if (n > std::numeric_limits<unsigned int>::max() / 2)
+		throw gpu_exception("Sort supports at most 2^31-1 elements, but " + to_string(n) + " requested!");
+}
+
+size_t bitonicSortMaxSize(const SortComparator &comparator)
+{
+	return blockSize(comparator);
+}
+
+void bitonicSort(gpu_mem_any &values, size_t n, const SortComparator &comparator)
+{
+	checkSize(values, n, comparator);
+	size_t block_size = blockSize(comparator);
+	if (n > block_size)
+		throw gpu_exception("Bitonic sort of " + comparator.type_name + " supports at most " + to_string(block_size)
+							+ " elements, but " + to_string(n) + " requested, use mergeSort!");
+	if (n <= 1)
+		return;
+
+	size_t workgroup_size = workgroupSize(block_size);
+	sortKernel("bitonic_sort_blocks", comparator).exec(WorkSize(workgroup_size, workgroup_size), values, (unsigned int) n);
+}
+
+void merge(const gpu_mem_any &a, size_t na, const gpu_mem_any &b, size_t nb, gpu_mem_any &result, const SortComparator &comparator)
+{
+	checkSize(a, na, comparator);
+	checkSize(b, nb, comparator);
+	if (na + nb > std::numeric_limits<unsigned int>::max() / 2)
+		throw gpu_exception("Merge supports at most 2^31-1 elements, but " + to_string(na + nb) + " requested!");
+	// result is written while other work groups still read a and b
+	if (!result.isNull() && (result.clmem() == a.clmem() || result.clmem() == b.clmem()))
+		throw gpu_exception("Merge can't be done in place, result should be different from a and b!");
+	if (result.size() < (na + nb) * comparator.type_size)
+		result.resize((na + nb) * comparator.type_size);
+	if (na + nb == 0)
+		return;
+
+	size_t tile_size = blockSize(comparator);
+	size_t workgroup_size = workgroupSize(tile_size);
+	unsigned int ntiles = divup((unsigned int) (na + nb), (unsigned int) tile_size);
+	sortKernel("merge", comparator).exec(WorkSize(workgroup_size, ntiles * workgroup_size),
+										 a, (unsigned int) na, b, (unsigned int) nb, result);
+}
+
+void mergeSort(gpu_mem_any &values, size_t n, const SortComparator &comparator)
+{
+	checkSize(values, n, comparator);
+	if (n <= 1)
+		return;
+
+	size_t block_size = blockSize(comparator);
+	size_t workgroup_size = workgroupSize(block_size);
+	unsigned int nblocks = divup((unsigned int) n, (unsigned int) block_size);
+	WorkSize ws(workgroup_size, nblocks * workgroup_size);
+
+	sortKernel("bitonic_sort_blocks", comparator).exec(ws, values, (unsigned int) n);
+	if (nblocks == 1)
+		return;
+
+	// passes go back and forth between values and temporary buffer, runs are twice longer after every pass
+	gpu_mem_any buffer = gpu_mem_any::create(n * comparator.type_size);
+	gpu_mem_any *src = &values;
+	gpu_mem_any *dst = &buffer;
+	ocl::KernelSource &merge_pass = sortKernel("merge_pass", comparator);
+	for (size_t width = block_size; width < n; width *= 2) {
+		merge_pass.exec(ws, *src, (unsigned int) n, (unsigned int) width, *dst);
+		std::swap(src, dst);
+	}
+
+	if (src != &values)
+		src->copyTo(values, n * comparator.type_size);
+}
+
+#define INSTANTIATE_SORT_ORDER(T) \
+	template SortComparator ascendingOrder<T>(); \
+	template SortComparator descendingOrder<T>();
+
+INSTANTIATE_SORT_ORDER(uint32_t)
+INSTANTIATE_SORT_ORDER(int32_t)
+INSTANTIATE_SORT_ORDER(float)
+INSTANTIATE_SORT_ORDER(uint64_t)
+INSTANTIATE_SORT_ORDER(int64_t)
+INSTANTIATE_SORT_ORDER(double)
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+// Order of elements for comparison sorts, given as OpenCL code: elements of type type_name (declared in declarations
+// if it is not a built-in type) are compared with expression less of two arguments a and b, for example
+// SortComparator("Particle", sizeof(Particle), "a.cell < b.cell || (a.cell == b.cell && a.id < b.id)",
+//                "typedef struct { unsigned int cell; unsigned int id; float mass; } Particle;")
+// Layout of the declared type must match the host type of type_size bytes. Kernels are compiled for every comparator.
+struct SortComparator {
+	SortComparator(const std::string &type_name, size_t type_size, const std::string &less, const std::string &declarations = std::string());
+
+	std::string		type_name;
+	size_t			type_size;
+	std::string		less;
+	std::string		declarations;
+};
+
+// Comparators of built-in types: uint32_t, int32_t, float, uint64_t, int64_t and double
+template <typename T>
+SortComparator ascendingOrder();
+
+template <typename T>
+SortComparator descendingOrder();
+
+// Elements that bitonicSort sorts in local memory of one work group - 1024 for elements up to 16 bytes, less for bigger ones
+size_t bitonicSortMaxSize(const SortComparator &comparator);
+
+// Sorts first n elements (n <= bitonicSortMaxSize) with bitonic sorting network in local memory of one work group, in place.
+// Not stable. Single kernel launch, so it is the fastest way to sort small arrays.
+void bitonicSort(gpu_mem_any &values, size_t n, const SortComparator &comparator);
+
+// Merges sorted a[0, na) and sorted b[0, nb) into result[0, na + nb), result is resized if it is too small
+// and should be a buffer different from a and b.
+// Stable: elements of a go before equal elements of b. Every work group merges the same number of elements
+// found with merge path search, so merge is fast for any data, e.g. for appending sorted batch to sorted array.
+void merge(const gpu_mem_any &a, size_t na, const gpu_mem_any &b, size_t nb, gpu_mem_any &result, const SortComparator &comparator);
+
+// Sorts first n elements in place: blocks are sorted with bitonic sort, then merged by pairs with merge passes.
+// Equal elements can go in any order (blocks are sorted with bitonic network). Use gpu::radixSort to sort plain keys,
+// this sort is for short arrays and elements with custom order.
+void mergeSort(gpu_mem_any &values, size_t n, const SortComparator &comparator);
+
+template <typename T>
+void bitonicSort(shared_device_buffer_typed<T> &values, const SortComparator &comparator = ascendingOrder<T>())
+{
+	bitonicSort(values, values.number(), comparator);
+}
+
+template <typename T>
+void merge(const shared_device_buffer_typed<T> &a, const shared_device_buffer_typed<T> &b, shared_device_buffer_typed<T> &result,
+		   const SortComparator &comparator = ascendingOrder<T>())
+{
+	merge(a, a.number(), b, b.number(), result, comparator);
+}
+
+template <typename T>
+void mergeSort(shared_device_buffer_typed<T> &values, const SortComparator &comparator = ascendingOrder<T>())
+{
+	mergeSort(values, values.number(), comparator);
+}
+
+}
@@ -0,0 +1,96 @@
+#include "transpose.h"
+#include "context.h"
+#include "work_size.h"
+
+#include <libgpu/opencl/program_cache.h>
+#include <libutils/string_utils.h>
+
+#include "opencl/cl/transpose_cl.h"
+
+#include <limits>
+
+namespace gpu {
+
+// Tiles are 32x32 elements (32x33 with padding) and are moved by 32x8 work groups.
+// Matrices with at most 32 rows or columns are moved in chunks of at most 1024 elements by 256 work items
+// (tile takes 32 * 33 elements of local memory - 16896 bytes for 16-byte elements, chunk - 1024 elements, 16384 bytes,
+// both fit into 32 KB that OpenCL guarantees).
+static const unsigned int transpose_tile				= 32;
+static const unsigned int transpose_tile_rows			= 8;
+static const unsigned int transpose_narrow_max			= 32;
+static const unsigned int transpose_chunk				= 1024;
+static const unsigned int transpose_chunk_workgroup_size	= 256;
+
+static ocl::ProgramCache transpose_programs(transpose_kernel, transpose_kernel_length, "transpose");
+
+// Elements are moved as OpenCL types of the same size
+static std::string transposeElementType(size_t element_size)
+{
+	switch (element_size) {
+	case 1:		return "uchar";
+	case 2:		return "ushort";
+	case 4:		return "uint";
+	case 8:		return "uint2";
+	case 16:	return "uint4";
+	default:
+		throw gpu_exception("Transpose supports elements of 1, 2, 4, 8 or 16 bytes, but " + to_string(element_size) + " requested!");
+	}
+}
+
+void transpose(const gpu_mem_any &src, gpu_mem_any &dst, size_t rows, size_t columns, size_t element_size, size_t batch)
+{
+	std::string defines = "-D E=" + transposeElementType(element_size) + " -D TILE=" + to_string(transpose_tile)
+						+ " -D TILE_ROWS=" + to_string(transpose_tile_rows) + " -D CHUNK=" + to_string(transpose_chunk);
+
+	size_t n = rows * columns * batch;
+	if (n > std::numeric_limits<unsigned int>::max())
+		throw gpu_exception("Transpose supports at most 2^32-1 elements, but " + to_string(n) + " requested!");
+	if (n * element_size > src.size())
+		throw gpu_exception("Not enough data in device buffer: " + to_string(n * element_size) + " > " + to_string(src.size()) + " bytes");
+	// work groups write elements that other work groups may not have read yet
+	if (!src.isNull() && src.clmem() == dst.clmem())
+		throw gpu_exception("Transpose can't be done in place, src and dst should be different buffers!");
+
+	dst.grow(n * element_size);
+	if (n == 0)
+		return;
+
+	// vectors are the same after transposition
+	if (rows == 1 || columns == 1) {
+		src.copyTo(dst, n * element_size);
+		return;
+	}
+
+	if (columns <= transpose_narrow_max && columns <= rows) {
+		// odd pitch, so that neighbouring work items read different banks
+		unsigned int pitch = (unsigned int) columns | 1;
+		unsigned int chunk_rows = transpose_chunk / pitch;
+		WorkSize ws(transpose_chunk_workgroup_size, 1, divup((unsigned int) rows, chunk_rows) * transpose_chunk_workgroup_size, (unsigned int) batch);
+		transpose_programs.kernel("transpose_narrow_columns", defines + " -D NARROW_PITCH=" + to_string(pitch))
+				.exec(ws, src, dst, (unsigned int) rows, (unsigned int) columns, chunk_rows);
+	} else if (rows <= transpose_narrow_max) {
+		unsigned int pitch = (unsigned int) rows | 1;
+		unsigned int chunk_columns = transpose_chunk / pitch;
+		WorkSize ws(transpose_chunk_workgroup_size, 1, divup((unsigned int) columns, chunk_columns) * transpose_chunk_workgroup_size, (unsigned int) batch);
+		transpose_programs.kernel("transpose_narrow_rows", defines + " -D NARROW_PITCH=" + to_string(pitch))
+				.exec(ws, src, dst, (unsigned int) rows, (unsigned int) columns, chunk_columns);
+	} else {
+		WorkSize ws(transpose_tile, transpose_tile_rows, 1,
+					divup((unsigned int) columns, transpose_tile) * transpose_tile,
+					divup((unsigned int) rows, transpose_tile) * transpose_tile_rows,
+					(unsigned int) batch);
+		transpose_programs.kernel("transpose_tiles", defines).exec(ws, src, dst, (unsigned int) rows, (unsigned int) columns);
+	}
+}
+
+void aosToSoa(const gpu_mem_any &src, gpu_mem_any &dst, size_t n, size_t nfields, size_t field_size)
+{
+	transpose(src, dst, n, nfields, field_size);
+}
+
+void soaToAos(const gpu_mem_any &src, gpu_mem_any &dst, size_t n, size_t nfields, size_t field_size)
+{
+	transpose(src, dst, nfields, n, field_size);
+}
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+// Transposes batch of densely packed row-major matrices rows x columns, stored one after another in src,
+// into columns x rows matrices in dst (resized if it is too small, can't be the same buffer as src) with the active context.
+// Elements are only moved, so any element type of 1, 2, 4, 8 or 16 bytes can be transposed (element_size is in bytes).
+// Matrices are transposed through tiles in local memory, so that both reads and writes are coalesced, matrices with
+// few rows or columns (up to 32) go through contiguous chunks instead, so that bandwidth is close to the one of a plain copy.
+void transpose(const gpu_mem_any &src, gpu_mem_any &dst, size_t rows, size_t columns, size_t element_size, size_t batch = 1);
+
+template <typename T>
+void transpose(const shared_device_buffer_typed<T> &src, shared_device_buffer_typed<T> &dst, size_t rows, size_t columns, size_t batch = 1)
+{
+	transpose(src, dst, rows, columns, sizeof(T), batch);
+}
+
+// Array of n structures of nfields fields of field_size bytes each into nfields arrays of n fields and back,
+// e.g. interleaved images::Image pixels (n = width * height, nfields = cn) into planar layout of channels
+void aosToSoa(const gpu_mem_any &src, gpu_mem_any &dst, size_t n, size_t nfields, size_t field_size);
+void soaToAos(const gpu_mem_any &src, gpu_mem_any &dst, size_t n, size_t nfields, size_t field_size);
+
+template <typename T>
+void aosToSoa(const shared_device_buffer_typed<T> &src, shared_device_buffer_typed<T> &dst, size_t n, size_t nfields)
+{
+	aosToSoa(src, dst, n, nfields, sizeof(T));
+}
+
+template <typename T>
+void soaToAos(const shared_device_buffer_typed<T> &src, shared_device_buffer_typed<T> &dst, size_t n, size_t nfields)
+{
+	soaToAos(src, dst, n, nfields, sizeof(T));
+}
+
+}
@@ -3,6 +3,12 @@
 #include <string>
 #include <stdexcept>
 
+#ifdef _MSC_VER
+    #define THREAD_LOCAL __declspec(thread)
+#else
+    #define THREAD_LOCAL __thread
+#endif
+
 namespace gpu {
 
 	class gpu_exception : public std::runtime_error {
@@ -101,6 +101,11 @@ namespace images {
         bool isNull()   { return !((bool) data);    };
         T* ptr()        { return data.get();        }
 
+        // Rows of crops and reshaped images can be farther apart than width * cn, stride is in elements
+        T* rowPtr(size_t row)               { return data.get() + offset + row * stride;    }
+        const T* rowPtr(size_t row) const   { return data.get() + offset + row * stride;    }
+        ptrdiff_t rowStride() const         { return stride;                                }
+
         inline T& operator()(size_t row, size_t col) {
             assert (row < height && col < width);
             return data.get()[offset + row * stride + col * cn];
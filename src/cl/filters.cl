@@ -0,0 +1,108 @@
+#ifdef __CLION_IDE__
+#include <libgpu/opencl/cl/clion_defines.cl>
+#define GROUP_X 32
+#define GROUP_Y 8
+#define ITEMS_X 1
+#define ITEMS_Y 4
+#define CN 3
+#define RADIUS_X 0
+#define RADIUS_Y 3
+#endif
+
+#line 13
+
+// Картинка на устройстве - плотные строки по width * CN float, каналы пикселя идут подряд и фильтруются независимо:
+// соседний по горизонтали элемент того же канала отстоит на CN. За краем картинки повторяется крайний пиксель.
+// Ядро (2 * RADIUS_X + 1) x (2 * RADIUS_Y + 1) - корреляция без разворота: dst(x, y) = sum k(i, j) * src(x + i - RX, y + j - RY).
+// Сепарабельная свертка - два прохода этим же кернелом с ядрами из одной строки и из одного столбца.
+
+// Рабочая группа GROUP_X x GROUP_Y считает плитку TILE_X x TILE_Y элементов, каждый work item - ITEMS_X x ITEMS_Y элементов
+// с шагом в размер группы, чтобы соседние work item-ы читали и писали соседние элементы
+#define TILE_X      (GROUP_X * ITEMS_X)
+#define TILE_Y      (GROUP_Y * ITEMS_Y)
+#define HALO_X      (RADIUS_X * CN)
+#define HALO_Y      RADIUS_Y
+#define LOCAL_X     (TILE_X + 2 * HALO_X)
+#define LOCAL_Y     (TILE_Y + 2 * HALO_Y)
+
+// Загружает плитку вместе с каймой в локальную память, координаты за краем картинки прижимаются к краю (с сохранением канала)
+void load_tile(__global const float *src, int row_width, int height, int x0, int y0, __local float *tile)
+{
+    const int local_id = get_local_id(1) * GROUP_X + get_local_id(0);
+    for (int e = local_id; e < LOCAL_X * LOCAL_Y; e += GROUP_X * GROUP_Y) {
+        int x = x0 - HALO_X + e % LOCAL_X;
+        int y = y0 - HALO_Y + e / LOCAL_X;
+        if (x < 0) {
+            x = (x % CN + CN) % CN;
+        } else if (x >= row_width) {
+            x = row_width - CN + x % CN;
+        }
+        y = clamp(y, 0, height - 1);
+        tile[e] = src[y * row_width + x];
+    }
+}
+
+__kernel __attribute__((reqd_work_group_size(GROUP_X, GROUP_Y, 1)))
+void convolve(__global const float *src,
+              __global       float *dst,
+              unsigned int width,
+              unsigned int height,
+              __constant float *weights)
+{
+    __local float tile[LOCAL_X * LOCAL_Y];
+
+    const int row_width = width * CN;
+    const int x0 = get_group_id(0) * TILE_X;
+    const int y0 = get_group_id(1) * TILE_Y;
+    load_tile(src, row_width, height, x0, y0, tile);
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (int iy = 0; iy < ITEMS_Y; ++iy) {
+        const int ty = get_local_id(1) + iy * GROUP_Y;
+        for (int ix = 0; ix < ITEMS_X; ++ix) {
+            const int tx = get_local_id(0) + ix * GROUP_X;
+            if (x0 + tx >= row_width || y0 + ty >= height)
+                continue;
+
+            float sum = 0.0f;
+            for (int j = 0; j <= 2 * RADIUS_Y; ++j) {
+                for (int i = 0; i <= 2 * RADIUS_X; ++i) {
+                    sum += weights[j * (2 * RADIUS_X + 1) + i] * tile[(ty + j) * LOCAL_X + tx + i * CN];
+                }
+            }
+            dst[(y0 + ty) * row_width + x0 + tx] = sum;
+        }
+    }
+}
+
+// Модуль градиента Собеля sqrt(gx^2 + gy^2) - обе производные по одной плитке с каймой в один пиксель (RADIUS_X = RADIUS_Y = 1)
+__kernel __attribute__((reqd_work_group_size(GROUP_X, GROUP_Y, 1)))
+void sobel(__global const float *src,
+           __global       float *dst,
+           unsigned int width,
+           unsigned int height)
+{
+    __local float tile[LOCAL_X * LOCAL_Y];
+
+    const int row_width = width * CN;
+    const int x0 = get_group_id(0) * TILE_X;
+    const int y0 = get_group_id(1) * TILE_Y;
+    load_tile(src, row_width, height, x0, y0, tile);
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (int iy = 0; iy < ITEMS_Y; ++iy) {
+        const int ty = get_local_id(1) + iy * GROUP_Y;
+        for (int ix = 0; ix < ITEMS_X; ++ix) {
+            const int tx = get_local_id(0) + ix * GROUP_X;
+            if (x0 + tx >= row_width || y0 + ty >= height)
+                continue;
+
+            __local const float *top    = tile + ty * LOCAL_X + tx;
+            __local const float *middle = top + LOCAL_X;
+            __local const float *bottom = middle + LOCAL_X;
+            float gx = (top[2 * CN] - top[0]) + 2.0f * (middle[2 * CN] - middle[0]) + (bottom[2 * CN] - bottom[0]);
+            float gy = (bottom[0] - top[0]) + 2.0f * (bottom[CN] - top[CN]) + (bottom[2 * CN] - top[2 * CN]);
+            dst[(y0 + ty) * row_width + x0 + tx] = sqrt(gx * gx + gy * gy);
+        }
+    }
+}
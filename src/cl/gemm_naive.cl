@@ -0,0 +1,30 @@
+#ifdef __CLION_IDE__
+#include <libgpu/opencl/cl/clion_defines.cl>
+#define T float
+#endif
+
+#line 7
+
+#ifdef T_IS_DOUBLE
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+
+// Наивное умножение C = A * B: каждый work item считает один элемент C, читая строку A и столбец B из глобальной памяти
+__kernel void gemm_naive(__global const T *a,
+                         __global const T *b,
+                         __global       T *c,
+                         unsigned int m,
+                         unsigned int n,
+                         unsigned int k)
+{
+    const unsigned int column = get_global_id(0);
+    const unsigned int row = get_global_id(1);
+    if (row >= m || column >= n)
+        return;
+
+    T sum = 0;
+    for (unsigned int p = 0; p < k; ++p) {
+        sum += a[row * k + p] * b[p * n + column];
+    }
+    c[row * n + column] = sum;
+}
@@ -0,0 +1,489 @@
+#ifdef __CLION_IDE__
+#include <libgpu/opencl/cl/clion_defines.cl>
+#include <libgpu/opencl/cl/common.cl>
+#define TILE_SIZE 16
+#define REGION_SIZE 64
+#endif
+
+#line 9
+
+// Перед этим файлом при компиляции вставляется libgpu/opencl/cl/common.cl (см. mandelbrot.cpp) - оттуда double-float функции df_*
+
+// Без слияния умножения со сложением в FMA результат не зависит от того, как компилятор соберет выражения
+// в разных кернелах - ускоренный рендер обязан совпадать с полным перебором до бита
+#pragma OPENCL FP_CONTRACT OFF
+
+// Должны совпадать с MandelbrotAcceleration в mandelbrot.h
+#define MANDELBROT_INTERIOR_TESTS  1
+#define MANDELBROT_PERIODICITY     2
+
+// Квадрат радиуса, после которого точка считается убежавшей. Большой радиус нужен для гладкой раскраски -
+// чем дальше убежала точка, тем точнее формула дробной части числа итераций
+#define BAILOUT2 (256.0f * 256.0f)
+
+// Возвращает долю итераций до убегания от iterations - от 0 до 1, для точек множества (не убежавших) ровно 1.
+// Ускорения (flags) никогда не меняют результат, только время его получения.
+float mandelbrot_value(float x0, float y0, unsigned int iterations, unsigned int flags)
+{
+    if (flags & MANDELBROT_INTERIOR_TESTS) {
+        // Главная кардиоида и круг периода 2 - больше половины площади множества, там итерировать незачем.
+        // Области чуть сжаты, чтобы точки у самой границы (где float итерации могут и убежать) честно итерировались
+        float xq = x0 - 0.25f;
+        float q = xq * xq + y0 * y0;
+        if (q * (q + xq) < 0.999f * 0.25f * y0 * y0) {
+            return 1.0f;
+        }
+        if ((x0 + 1.0f) * (x0 + 1.0f) + y0 * y0 < 0.999f * 0.0625f) {
+            return 1.0f;
+        }
+    }
+
+    float x = x0;
+    float y = y0;
+    // Проверка периодичности (по Бренту): запоминаем точку на итерациях 2^k и сравниваем с ней следующие.
+    // Сравнение точное - если float орбита вернулась в ту же точку, дальше она повторяется вечно и никогда не убежит
+    float savedX = x;
+    float savedY = y;
+    unsigned int saveAt = 8;
+    unsigned int iter = 0;
+    for (; iter < iterations; ++iter) {
+        float xPrev = x;
+        x = x * x - y * y + x0;
+        y = 2.0f * xPrev * y + y0;
+        if ((x * x + y * y) > BAILOUT2) {
+            break;
+        }
+        if (flags & MANDELBROT_PERIODICITY) {
+            if (x == savedX && y == savedY) {
+                return 1.0f;
+            }
+            if (iter == saveAt) {
+                savedX = x;
+                savedY = y;
+                saveAt *= 2;
+            }
+        }
+    }
+    if (iter == iterations) {
+        return 1.0f;
+    }
+
+    // Гладкая раскраска: дробная добавка к числу итераций по тому, насколько далеко за радиус убежала точка
+    float r2 = x * x + y * y;
+    float smooth = iter + 1.0f - log2(log2(r2) * 0.5f);
+    return clamp(smooth / iterations, 0.0f, 0.99999f);
+}
+
+// Каждая рабочая группа - плитка TILE_SIZE x TILE_SIZE пикселей. Стоимость плиток очень разная - внутри множества
+// каждая точка делает все iterations итераций, снаружи - единицы, поэтому группы запускаются в количестве
+// "сколько влезает на устройство" и сами берут следующую плитку из общего атомарного счетчика.
+// Так группы, которым достались дешевые плитки, успевают обработать больше плиток, и все заканчивают одновременно.
+__kernel __attribute__((reqd_work_group_size(TILE_SIZE, TILE_SIZE, 1)))
+void mandelbrot(__global float *results,
+                unsigned int width, unsigned int height,
+                float fromX, float fromY, float step,
+                unsigned int iterations, unsigned int flags,
+                __global unsigned int *next_tile)
+{
+    __local unsigned int tile_shared;
+
+    const unsigned int lx = get_local_id(0);
+    const unsigned int ly = get_local_id(1);
+
+    const unsigned int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    const unsigned int tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    const unsigned int ntiles = tilesX * tilesY;
+
+    while (true) {
+        if (lx == 0 && ly == 0) {
+            tile_shared = atomic_inc(next_tile);
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+        const unsigned int tile = tile_shared;
+        // прежде чем первый поток перезапишет номер плитки, все должны его прочитать
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if (tile >= ntiles) {
+            break;
+        }
+
+        const unsigned int i = (tile % tilesX) * TILE_SIZE + lx;
+        const unsigned int j = (tile / tilesX) * TILE_SIZE + ly;
+        if (i < width && j < height) {
+            // строка 0 - верх картинки, т.е. наибольшая мнимая часть
+            float x0 = fromX + (i + 0.5f) * step;
+            float y0 = fromY - (j + 0.5f) * step;
+            results[j * width + i] = mandelbrot_value(x0, y0, iterations, flags);
+        }
+    }
+}
+
+// Трассировка границ (Мариани-Силвер): множество связно и не имеет дыр, поэтому если непрерывная граница прямоугольника
+// лежит в множестве, то и весь прямоугольник лежит в нем. Но мы знаем лишь значения в центрах пикселей границы,
+// а внешние нити тоньше пикселя могут пройти между ними - поэтому заливка прямоугольника, у которого все посчитанные
+// пиксели границы в множестве, приближенная: изредка она заливает внешние пиксели нитей. Заливаем только множество:
+// снаружи у каждого пикселя своя гладкая дробная часть, и заливка одинаковым значением изменила бы картинку.
+//
+// Группа обрабатывает регион REGION_SIZE x REGION_SIZE: считает границы прямоугольников размера REGION_SIZE,
+// REGION_SIZE/2, ... TRACE_MIN_SIZE (каждый раз только тех, что еще не залиты), затем оставшиеся пиксели.
+// Пиксели, которые нужно посчитать, каждый раз собираются в плотный список, чтобы все потоки группы были заняты.
+
+#define GROUP_SIZE      (TILE_SIZE * TILE_SIZE)
+#define REGION_PIXELS   (REGION_SIZE * REGION_SIZE)
+#define TRACE_MIN_SIZE  8
+#define NOT_COMPUTED    (-1.0f)
+
+// Считает еще не посчитанные пиксели региона, лежащие на границах прямоугольников размера size (size=0 - все)
+void compute_region_pixels(__local float *values, __local unsigned short *list, __local unsigned int *count,
+                           unsigned int size,
+                           unsigned int regionX, unsigned int regionY,
+                           float fromX, float fromY, float step,
+                           unsigned int iterations, unsigned int flags)
+{
+    const unsigned int lid = get_local_id(0);
+
+    if (lid == 0) {
+        *count = 0;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (unsigned int p = lid; p < REGION_PIXELS; p += GROUP_SIZE) {
+        if (values[p] != NOT_COMPUTED) {
+            continue;
+        }
+        bool needed = true;
+        if (size != 0) {
+            unsigned int bx = (p % REGION_SIZE) % size;
+            unsigned int by = (p / REGION_SIZE) % size;
+            needed = (bx == 0 || by == 0 || bx == size - 1 || by == size - 1);
+        }
+        if (needed) {
+            list[atomic_inc(count)] = (unsigned short) p;
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    const unsigned int n = *count;
+    for (unsigned int k = lid; k < n; k += GROUP_SIZE) {
+        unsigned int p = list[k];
+        // пиксели за краем картинки тоже считаем - они нужны для границ прямоугольников, но не записываются
+        unsigned int i = regionX + p % REGION_SIZE;
+        unsigned int j = regionY + p / REGION_SIZE;
+        values[p] = mandelbrot_value(fromX + (i + 0.5f) * step, fromY - (j + 0.5f) * step, iterations, flags);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+}
+
+__kernel __attribute__((reqd_work_group_size(GROUP_SIZE, 1, 1)))
+void mandelbrot_traced(__global float *results,
+                       unsigned int width, unsigned int height,
+                       float fromX, float fromY, float step,
+                       unsigned int iterations, unsigned int flags,
+                       __global unsigned int *next_region)
+{
+    __local unsigned int region_shared;
+    __local unsigned int count;
+    __local float values[REGION_PIXELS];
+    __local unsigned short list[REGION_PIXELS];
+    __local int inside[(REGION_SIZE / TRACE_MIN_SIZE) * (REGION_SIZE / TRACE_MIN_SIZE)];
+
+    const unsigned int lid = get_local_id(0);
+
+    const unsigned int regionsX = (width + REGION_SIZE - 1) / REGION_SIZE;
+    const unsigned int regionsY = (height + REGION_SIZE - 1) / REGION_SIZE;
+    const unsigned int nregions = regionsX * regionsY;
+
+    while (true) {
+        if (lid == 0) {
+            region_shared = atomic_inc(next_region);
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+        const unsigned int region = region_shared;
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if (region >= nregions) {
+            break;
+        }
+
+        const unsigned int regionX = (region % regionsX) * REGION_SIZE;
+        const unsigned int regionY = (region / regionsX) * REGION_SIZE;
+
+        for (unsigned int p = lid; p < REGION_PIXELS; p += GROUP_SIZE) {
+            values[p] = NOT_COMPUTED;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        for (unsigned int size = REGION_SIZE; size >= TRACE_MIN_SIZE; size /= 2) {
+            const unsigned int rectsX = REGION_SIZE / size;
+
+            for (unsigned int r = lid; r < rectsX * rectsX; r += GROUP_SIZE) {
+                inside[r] = 1;
+            }
+            compute_region_pixels(values, list, &count, size, regionX, regionY, fromX, fromY, step, iterations, flags);
+
+            // у уже залитых прямоугольников граница тоже в множестве, повторная заливка ничего не меняет
+            for (unsigned int p = lid; p < REGION_PIXELS; p += GROUP_SIZE) {
+                unsigned int px = p % REGION_SIZE;
+                unsigned int py = p / REGION_SIZE;
+                unsigned int bx = px % size;
+                unsigned int by = py % size;
+                bool border = (bx == 0 || by == 0 || bx == size - 1 || by == size - 1);
+                if (border && values[p] != 1.0f) {
+                    inside[(py / size) * rectsX + px / size] = 0;
+                }
+            }
+            barrier(CLK_LOCAL_MEM_FENCE);
+
+            for (unsigned int p = lid; p < REGION_PIXELS; p += GROUP_SIZE) {
+                unsigned int px = p % REGION_SIZE;
+                unsigned int py = p / REGION_SIZE;
+                if (values[p] == NOT_COMPUTED && inside[(py / size) * rectsX + px / size]) {
+                    values[p] = 1.0f;
+                }
+            }
+            barrier(CLK_LOCAL_MEM_FENCE);
+        }
+
+        compute_region_pixels(values, list, &count, 0, regionX, regionY, fromX, fromY, step, iterations, flags);
+
+        for (unsigned int p = lid; p < REGION_PIXELS; p += GROUP_SIZE) {
+            unsigned int i = regionX + p % REGION_SIZE;
+            unsigned int j = regionY + p / REGION_SIZE;
+            if (i < width && j < height) {
+                results[j * width + i] = values[p];
+            }
+        }
+    }
+}
+
+// Прогрессивный рендер для интерактивного просмотра. Пиксели лежат на сетке origin + (offset + i) * step, где offset -
+// целочисленный сдвиг картинки относительно начала сетки. Пока сдвиг меньше 2^24, координата пикселя зависит только
+// от его номера на сетке, поэтому после сдвига картинки на целое число пикселей (или зума в 2^k раз - шаг делится точно)
+// значения совпадающих пикселей не меняются до бита и берутся из прошлого кадра.
+
+// Переносит значения пикселей, которые есть и в прошлом кадре, остальные помечает непосчитанными (oldWidth=0 - все).
+// zoomLog2 > 0 - приближение в 2^zoomLog2 раз: на прошлой сетке есть только пиксели с номером, кратным 2^zoomLog2
+__kernel void mandelbrot_progressive_reuse(__global const float *old_values,
+                                           unsigned int oldWidth, unsigned int oldHeight,
+                                           int oldOffsetX, int oldOffsetY,
+                                           __global float *values,
+                                           unsigned int width, unsigned int height,
+                                           int offsetX, int offsetY,
+                                           int zoomLog2)
+{
+    const unsigned int i = get_global_id(0);
+    const unsigned int j = get_global_id(1);
+    if (i >= width || j >= height) {
+        return;
+    }
+
+    int gx = offsetX + (int) i;
+    int gy = offsetY + (int) j;
+    bool onOldGrid = true;
+    if (zoomLog2 > 0) {
+        int d = 1 << zoomLog2;
+        onOldGrid = (gx % d == 0) && (gy % d == 0);
+        gx /= d;
+        gy /= d;
+    } else if (zoomLog2 < 0) {
+        gx *= 1 << (-zoomLog2);
+        gy *= 1 << (-zoomLog2);
+    }
+
+    const int io = gx - oldOffsetX;
+    const int jo = gy - oldOffsetY;
+    float value = NOT_COMPUTED;
+    if (onOldGrid && io >= 0 && jo >= 0 && io < (int) oldWidth && jo < (int) oldHeight) {
+        value = old_values[jo * oldWidth + io];
+    }
+    values[j * width + i] = value;
+}
+
+// Один проход уточнения - подрешетка пикселей (firstX + k * stride, firstY + l * stride). Уже известные пиксели пропускаются
+__kernel void mandelbrot_progressive(__global float *values,
+                                     unsigned int width, unsigned int height,
+                                     float originX, float originY, float step,
+                                     int offsetX, int offsetY,
+                                     unsigned int stride, unsigned int firstX, unsigned int firstY,
+                                     unsigned int iterations, unsigned int flags)
+{
+    const unsigned int i = firstX + get_global_id(0) * stride;
+    const unsigned int j = firstY + get_global_id(1) * stride;
+    if (i >= width || j >= height) {
+        return;
+    }
+    if (values[j * width + i] != NOT_COMPUTED) {
+        return;
+    }
+
+    float x0 = originX + (float) (offsetX + (int) i) * step;
+    float y0 = originY - (float) (offsetY + (int) j) * step;
+    values[j * width + i] = mandelbrot_value(x0, y0, iterations, flags);
+}
+
+// Картинка для показа: непосчитанный пиксель берет значение из угла своего блока 2x2, 4x4 или 8x8 - первый проход
+// считает углы всех блоков 8x8, поэтому после него значение найдется у каждого пикселя
+__kernel void mandelbrot_progressive_preview(__global const float *values,
+                                             unsigned int width, unsigned int height,
+                                             __global float *preview)
+{
+    const unsigned int i = get_global_id(0);
+    const unsigned int j = get_global_id(1);
+    if (i >= width || j >= height) {
+        return;
+    }
+
+    float value = values[j * width + i];
+    for (unsigned int mask = 1; mask <= 7 && value == NOT_COMPUTED; mask = mask * 2 + 1) {
+        value = values[(j & ~mask) * width + (i & ~mask)];
+    }
+    preview[j * width + i] = value;
+}
+
+// Глубокий зум (возмущения): float не различает соседние пиксели уже при ширине области около 1e-6, поэтому
+// опорная орбита Z_n центра вида считается на хосте с высокой точностью, а для пикселя c = c_ref + dc итерируется
+// только отклонение от нее: z_n = Z_n + d_n, d_{n+1} = (2 Z_n + d_n) d_n + dc. Отклонения малы, но их относительная
+// точность не зависит от глубины зума. Считаются они в double, если устройство его поддерживает, иначе в double-float.
+
+#ifdef DEEP_DOUBLE
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+typedef double deep_t;
+#define deep_from_float(a)          ((double) (a))
+#define deep_from_hi_lo(hi, lo)     ((double) (hi) + (double) (lo))
+#define deep_to_float(a)            ((float) (a))
+#define deep_add(a, b)              ((a) + (b))
+#define deep_sub(a, b)              ((a) - (b))
+#define deep_mul(a, b)              ((a) * (b))
+#else
+typedef float2 deep_t;
+#define deep_from_float(a)          df_from_float(a)
+#define deep_from_hi_lo(hi, lo)     make_float2(hi, lo)
+#define deep_to_float(a)            df_to_float(a)
+#define deep_add(a, b)              df_add(a, b)
+#define deep_sub(a, b)              df_sub(a, b)
+#define deep_mul(a, b)              df_mul(a, b)
+#endif
+
+// orbit[n] - Z_n в виде (re.hi, re.lo, im.hi, im.lo), Z_0 = 0, Z_1 = c_ref. Счет итераций такой же, как в mandelbrot_value
+float mandelbrot_deep_value(deep_t dcx, deep_t dcy, __global const float4 *orbit, unsigned int orbitLength, unsigned int iterations)
+{
+    deep_t dx = dcx;
+    deep_t dy = dcy;
+    unsigned int m = 1;
+    float x = 0.0f;
+    float y = 0.0f;
+    unsigned int iter = 0;
+    for (; iter < iterations; ++iter) {
+        float4 z = orbit[m];
+        deep_t ax = deep_add(deep_add(deep_from_hi_lo(z.x, z.y), deep_from_hi_lo(z.x, z.y)), dx);
+        deep_t ay = deep_add(deep_add(deep_from_hi_lo(z.z, z.w), deep_from_hi_lo(z.z, z.w)), dy);
+        deep_t ndx = deep_add(deep_sub(deep_mul(ax, dx), deep_mul(ay, dy)), dcx);
+        deep_t ndy = deep_add(deep_add(deep_mul(ax, dy), deep_mul(ay, dx)), dcy);
+        dx = ndx;
+        dy = ndy;
+        ++m;
+
+        z = orbit[m];
+        deep_t zx = deep_add(deep_from_hi_lo(z.x, z.y), dx);
+        deep_t zy = deep_add(deep_from_hi_lo(z.z, z.w), dy);
+        x = deep_to_float(zx);
+        y = deep_to_float(zy);
+        float r2 = x * x + y * y;
+        if (r2 > BAILOUT2) {
+            break;
+        }
+
+        // Перебазирование: когда точка подошла к нулю ближе, чем к опорной орбите (иначе отклонение теряет точность),
+        // или опорная орбита закончилась - продолжаем с начала опорной орбиты, считая отклонением всю точку z
+        float fdx = deep_to_float(dx);
+        float fdy = deep_to_float(dy);
+        if (r2 < fdx * fdx + fdy * fdy || m == orbitLength - 1) {
+            dx = zx;
+            dy = zy;
+            m = 0;
+        }
+    }
+    if (iter == iterations) {
+        return 1.0f;
+    }
+
+    float r2 = x * x + y * y;
+    float smooth = iter + 1.0f - log2(log2(r2) * 0.5f);
+    return clamp(smooth / iterations, 0.0f, 0.99999f);
+}
+
+// Плитки раздаются так же, как в mandelbrot. Смещение пикселя от центра вида dc = (i + 1/2 - width/2) * step
+__kernel __attribute__((reqd_work_group_size(TILE_SIZE, TILE_SIZE, 1)))
+void mandelbrot_deep(__global float *results,
+                     unsigned int width, unsigned int height,
+                     float stepHi, float stepLo,
+                     __global const float4 *orbit, unsigned int orbitLength,
+                     unsigned int iterations,
+                     __global unsigned int *next_tile)
+{
+    __local unsigned int tile_shared;
+
+    const unsigned int lx = get_local_id(0);
+    const unsigned int ly = get_local_id(1);
+
+    const unsigned int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    const unsigned int tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    const unsigned int ntiles = tilesX * tilesY;
+
+    const deep_t step = deep_from_hi_lo(stepHi, stepLo);
+
+    while (true) {
+        if (lx == 0 && ly == 0) {
+            tile_shared = atomic_inc(next_tile);
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+        const unsigned int tile = tile_shared;
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if (tile >= ntiles) {
+            break;
+        }
+
+        const unsigned int i = (tile % tilesX) * TILE_SIZE + lx;
+        const unsigned int j = (tile / tilesX) * TILE_SIZE + ly;
+        if (i < width && j < height) {
+            // полуцелые смещения в пикселях представимы во float точно
+            deep_t dcx = deep_mul(deep_from_float(i + 0.5f - 0.5f * width), step);
+            deep_t dcy = deep_mul(deep_from_float(0.5f * height - (j + 0.5f)), step);
+            results[j * width + i] = mandelbrot_deep_value(dcx, dcy, orbit, orbitLength, iterations);
+        }
+    }
+}
+
+// Раскраска: MANDELBROT_GRAYSCALE=0 - оттенки серого, MANDELBROT_PALETTE=1 - циклическая палитра. Точки множества черные.
+__kernel void mandelbrot_colorize(__global const float *values,
+                                  unsigned int width, unsigned int height,
+                                  __global unsigned char *pixels,
+                                  unsigned int cn,
+                                  unsigned int coloring)
+{
+    const unsigned int i = get_global_id(0);
+    const unsigned int j = get_global_id(1);
+    if (i >= width || j >= height) {
+        return;
+    }
+
+    float value = values[j * width + i];
+    float3 color = (float3) (0.0f, 0.0f, 0.0f);
+    if (value < 1.0f) {
+        if (coloring == 0) {
+            color = (float3) (value, value, value);
+        } else {
+            // палитра повторяется, поэтому sqrt растягивает быстро убегающие точки, которых большинство
+            float t = 4.0f * sqrt(value);
+            color = 0.5f + 0.5f * cos(6.2831853f * (t + (float3) (0.0f, 0.33f, 0.67f)));
+        }
+    }
+
+    unsigned char rgb[3] = {(unsigned char) (color.x * 255.0f + 0.5f),
+                            (unsigned char) (color.y * 255.0f + 0.5f),
+                            (unsigned char) (color.z * 255.0f + 0.5f)};
+    for (unsigned int c = 0; c < cn; ++c) {
+        pixels[(j * width + i) * cn + c] = (c < 3) ? rgb[c] : 255;
+    }
+}
@@ -0,0 +1,24 @@
+#ifdef __CLION_IDE__
+#include <libgpu/opencl/cl/clion_defines.cl>
+#endif
+
+#line 6
+
+// Достаточно тяжелый кернел, чтобы время работы устройства определялось вычислениями, а не запуском
+__kernel void iterate(__global const float* xs,
+                      __global       float* ys,
+                      unsigned int n,
+                      unsigned int iters)
+{
+    const unsigned int index = get_global_id(0);
+
+    if (index >= n)
+        return;
+
+    float x = xs[index];
+    float y = 0.0f;
+    for (unsigned int i = 0; i < iters; ++i) {
+        y = y * 0.5f + x;
+    }
+    ys[index] = y;
+}
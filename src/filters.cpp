@@ -0,0 +1,302 @@
+#include "filters.h"
+
+#include <libgpu/context.h>
+#include <libgpu/work_size.h>
+#include <libgpu/opencl/program_cache.h>
+#include <libutils/misc.h>
+#include <libutils/string_utils.h>
+
+// Этот файл будет сгенерирован автоматически в момент сборки - см. convertIntoHeader в CMakeLists.txt
+#include "cl/filters_cl.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+
+// Рабочая группа 32x8, плитка с каймой занимает не больше 16 Кб локальной памяти. Каждый work item считает 4 элемента
+// вдоль направления прохода одномерного ядра (2x2 для двумерного), для широких ядер - меньше, чтобы плитка поместилась
+static const unsigned int groupX = 32;
+static const unsigned int groupY = 8;
+static const unsigned int itemsPerWorkItem = 4;
+static const unsigned int maxTileFloats = 4096;
+
+// Кернелы компилируются под число каналов и размеры ядра, поэтому программы кешируются по набору define-ов
+static ocl::ProgramCache filtersPrograms(filters_kernel, filters_kernel_length, "filters");
+
+ConvolutionKernel::ConvolutionKernel(unsigned int width, unsigned int height, const std::vector<float> &weights)
+        : width(width), height(height), weights(weights)
+{
+    if (width % 2 == 0 || height % 2 == 0) {
+        throw std::runtime_error("Convolution kernel should have odd sizes, but it is " + to_string(width) + "x" + to_string(height) + "!");
+    }
+    if (weights.size() != width * height) {
+        throw std::runtime_error("Convolution kernel " + to_string(width) + "x" + to_string(height) + " has " + to_string(weights.size()) + " weights!");
+    }
+}
+
+SeparableKernel::SeparableKernel(const std::vector<float> &horizontal, const std::vector<float> &vertical)
+        : horizontal(horizontal), vertical(vertical)
+{
+    if (horizontal.size() % 2 == 0 || vertical.size() % 2 == 0) {
+        throw std::runtime_error("Separable kernel should have odd sizes, but it is " + to_string(horizontal.size()) + "x" + to_string(vertical.size()) + "!");
+    }
+}
+
+SeparableKernel gaussianKernel(float sigma)
+{
+    if (!(sigma > 0.0f)) {
+        throw std::runtime_error("Gaussian blur needs positive sigma, but it is " + to_string(sigma) + "!");
+    }
+    int radius = std::max(1, (int) std::ceil(3.0f * sigma));
+    std::vector<float> weights(2 * radius + 1);
+    double sum = 0.0;
+    for (int i = -radius; i <= radius; ++i) {
+        weights[i + radius] = (float) std::exp(-0.5 * i * i / (sigma * sigma));
+        sum += weights[i + radius];
+    }
+    for (size_t i = 0; i < weights.size(); ++i) {
+        weights[i] = (float) (weights[i] / sum);
+    }
+    return SeparableKernel(weights, weights);
+}
+
+ConvolutionKernel sharpenKernel(float amount)
+{
+    float side = -0.25f * amount;
+    return ConvolutionKernel(3, 3, {0.0f, side,           0.0f,
+                                    side, 1.0f + amount,  side,
+                                    0.0f, side,           0.0f});
+}
+
+SeparableKernel sobelXKernel()
+{
+    return SeparableKernel({-1.0f, 0.0f, 1.0f}, {1.0f, 2.0f, 1.0f});
+}
+
+SeparableKernel sobelYKernel()
+{
+    return SeparableKernel({1.0f, 2.0f, 1.0f}, {-1.0f, 0.0f, 1.0f});
+}
+
+static void checkSameSize(const images::Image<float> &src, const images::Image<float> &dst)
+{
+    if (src.width != dst.width || src.height != dst.height || src.cn != dst.cn) {
+        throw std::runtime_error("Filtered image should be of the same size as the source image: "
+                                 + to_string(dst.width) + "x" + to_string(dst.height) + "x" + to_string(dst.cn) + " instead of "
+                                 + to_string(src.width) + "x" + to_string(src.height) + "x" + to_string(src.cn) + "!");
+    }
+}
+
+// Выбирает, сколько элементов считает каждый work item, так чтобы плитка с каймой поместилась в локальную память
+static void chooseItems(unsigned int cn, unsigned int radiusX, unsigned int radiusY, unsigned int &itemsX, unsigned int &itemsY)
+{
+    itemsX = radiusY == 0 ? itemsPerWorkItem : (radiusX == 0 ? 1 : 2);
+    itemsY = radiusX == 0 ? itemsPerWorkItem : (radiusY == 0 ? 1 : 2);
+    while (true) {
+        unsigned int tileFloats = (groupX * itemsX + 2 * radiusX * cn) * (groupY * itemsY + 2 * radiusY);
+        if (tileFloats <= maxTileFloats) {
+            return;
+        }
+        if (itemsX == 1 && itemsY == 1) {
+            throw std::runtime_error("Convolution kernel " + to_string(2 * radiusX + 1) + "x" + to_string(2 * radiusY + 1)
+                                     + " is too big for " + to_string(cn) + " channels!");
+        }
+        if (itemsX >= itemsY) {
+            itemsX = std::max(1u, itemsX / 2);
+        } else {
+            itemsY = std::max(1u, itemsY / 2);
+        }
+    }
+}
+
+static std::string filterDefines(unsigned int cn, unsigned int radiusX, unsigned int radiusY, unsigned int itemsX, unsigned int itemsY)
+{
+    return "-D GROUP_X=" + to_string(groupX) + " -D GROUP_Y=" + to_string(groupY)
+           + " -D ITEMS_X=" + to_string(itemsX) + " -D ITEMS_Y=" + to_string(itemsY)
+           + " -D CN=" + to_string(cn) + " -D RADIUS_X=" + to_string(radiusX) + " -D RADIUS_Y=" + to_string(radiusY);
+}
+
+ImageFilter::ImageFilter()
+{
+}
+
+void ImageFilter::upload(const images::Image<float> &image)
+{
+    size_t rowSize = image.width * image.cn * sizeof(float);
+    src_.growN(image.width * image.height * image.cn);
+    src_.write2D(rowSize, image.rowPtr(0), image.rowStride() * sizeof(float), rowSize, image.height);
+}
+
+void ImageFilter::download(images::Image<float> &image)
+{
+    size_t rowSize = image.width * image.cn * sizeof(float);
+    dst_.read2D(rowSize, image.rowPtr(0), image.rowStride() * sizeof(float), rowSize, image.height);
+}
+
+void ImageFilter::convolve(const gpu::gpu_mem_32f &src, gpu::gpu_mem_32f &dst, unsigned int width, unsigned int height, unsigned int cn,
+                           const ConvolutionKernel &kernel)
+{
+    unsigned int itemsX, itemsY;
+    chooseItems(cn, kernel.radiusX(), kernel.radiusY(), itemsX, itemsY);
+    std::string defines = filterDefines(cn, kernel.radiusX(), kernel.radiusY(), itemsX, itemsY);
+
+    weights_.growN(kernel.weights.size());
+    weights_.writeN(kernel.weights.data(), kernel.weights.size());
+    dst.growN(width * height * cn);
+    if (width == 0 || height == 0) {
+        return;
+    }
+
+    gpu::WorkSize ws(groupX, groupY, gpu::divup(width * cn, groupX * itemsX) * groupX, gpu::divup(height, groupY * itemsY) * groupY);
+    filtersPrograms.kernel("convolve", defines).exec(ws, src, dst, width, height, weights_);
+}
+
+void ImageFilter::convolve(const gpu::gpu_mem_32f &src, gpu::gpu_mem_32f &dst, unsigned int width, unsigned int height, unsigned int cn,
+                           const SeparableKernel &kernel)
+{
+    convolve(src, temp_, width, height, cn, kernel.horizontalKernel());
+    convolve(temp_, dst, width, height, cn, kernel.verticalKernel());
+}
+
+void ImageFilter::sobel(const gpu::gpu_mem_32f &src, gpu::gpu_mem_32f &dst, unsigned int width, unsigned int height, unsigned int cn)
+{
+    unsigned int itemsX = 2;
+    unsigned int itemsY = 2;
+    std::string defines = filterDefines(cn, 1, 1, itemsX, itemsY);
+    dst.growN(width * height * cn);
+    if (width == 0 || height == 0) {
+        return;
+    }
+
+    gpu::WorkSize ws(groupX, groupY, gpu::divup(width * cn, groupX * itemsX) * groupX, gpu::divup(height, groupY * itemsY) * groupY);
+    filtersPrograms.kernel("sobel", defines).exec(ws, src, dst, width, height);
+}
+
+void ImageFilter::convolve(const images::Image<float> &src, images::Image<float> &dst, const ConvolutionKernel &kernel)
+{
+    checkSameSize(src, dst);
+    upload(src);
+    convolve(src_, dst_, (unsigned int) src.width, (unsigned int) src.height, (unsigned int) src.cn, kernel);
+    download(dst);
+}
+
+void ImageFilter::convolve(const images::Image<float> &src, images::Image<float> &dst, const SeparableKernel &kernel)
+{
+    checkSameSize(src, dst);
+    upload(src);
+    convolve(src_, dst_, (unsigned int) src.width, (unsigned int) src.height, (unsigned int) src.cn, kernel);
+    download(dst);
+}
+
+void ImageFilter::gaussianBlur(const images::Image<float> &src, images::Image<float> &dst, float sigma)
+{
+    convolve(src, dst, gaussianKernel(sigma));
+}
+
+void ImageFilter::sharpen(const images::Image<float> &src, images::Image<float> &dst, float amount)
+{
+    convolve(src, dst, sharpenKernel(amount));
+}
+
+void ImageFilter::sobel(const images::Image<float> &src, images::Image<float> &dst)
+{
+    checkSameSize(src, dst);
+    upload(src);
+    sobel(src_, dst_, (unsigned int) src.width, (unsigned int) src.height, (unsigned int) src.cn);
+    download(dst);
+}
+
+// Строка с каймой в radius пикселей с каждой стороны, за краем повторяется крайний пиксель
+static void padRow(const float *row, int width, int cn, int radius, float *padded)
+{
+    for (int x = -radius; x < width + radius; ++x) {
+        const float *pixel = row + std::min(std::max(x, 0), width - 1) * cn;
+        for (int c = 0; c < cn; ++c) {
+            padded[(x + radius) * cn + c] = pixel[c];
+        }
+    }
+}
+
+void convolveCPU(const images::Image<float> &src, images::Image<float> &dst, const ConvolutionKernel &kernel)
+{
+    checkSameSize(src, dst);
+    const int width = (int) src.width;
+    const int height = (int) src.height;
+    const int cn = (int) src.cn;
+    const int rowWidth = width * cn;
+    const int radiusX = (int) kernel.radiusX();
+    const int radiusY = (int) kernel.radiusY();
+
+    // dst может оказаться той же картинкой, поэтому результат сначала собирается целиком
+    images::Image<float> result(src.width, src.height, src.cn);
+
+    #pragma omp parallel
+    {
+        std::vector<float> padded((width + 2 * radiusX) * cn);
+        #pragma omp for schedule(static)
+        for (int y = 0; y < height; ++y) {
+            float *out = result.rowPtr(y);
+            std::fill(out, out + rowWidth, 0.0f);
+            for (int j = 0; j < (int) kernel.height; ++j) {
+                int sy = std::min(std::max(y + j - radiusY, 0), height - 1);
+                padRow(src.rowPtr(sy), width, cn, radiusX, padded.data());
+                for (int i = 0; i < (int) kernel.width; ++i) {
+                    const float weight = kernel.weights[j * kernel.width + i];
+                    if (weight == 0.0f) {
+                        continue;
+                    }
+                    const float *in = padded.data() + i * cn;
+                    #pragma omp simd
+                    for (int e = 0; e < rowWidth; ++e) {
+                        out[e] += weight * in[e];
+                    }
+                }
+            }
+        }
+    }
+
+    for (int y = 0; y < height; ++y) {
+        std::copy(result.rowPtr(y), result.rowPtr(y) + rowWidth, dst.rowPtr(y));
+    }
+}
+
+void convolveCPU(const images::Image<float> &src, images::Image<float> &dst, const SeparableKernel &kernel)
+{
+    images::Image<float> temp(src.width, src.height, src.cn);
+    convolveCPU(src, temp, kernel.horizontalKernel());
+    convolveCPU(temp, dst, kernel.verticalKernel());
+}
+
+void gaussianBlurCPU(const images::Image<float> &src, images::Image<float> &dst, float sigma)
+{
+    convolveCPU(src, dst, gaussianKernel(sigma));
+}
+
+void sharpenCPU(const images::Image<float> &src, images::Image<float> &dst, float amount)
+{
+    convolveCPU(src, dst, sharpenKernel(amount));
+}
+
+void sobelCPU(const images::Image<float> &src, images::Image<float> &dst)
+{
+    checkSameSize(src, dst);
+    images::Image<float> gx(src.width, src.height, src.cn);
+    images::Image<float> gy(src.width, src.height, src.cn);
+    convolveCPU(src, gx, sobelXKernel());
+    convolveCPU(src, gy, sobelYKernel());
+
+    const int rowWidth = (int) (src.width * src.cn);
+    #pragma omp parallel for schedule(static)
+    for (int y = 0; y < (int) src.height; ++y) {
+        const float *a = gx.rowPtr(y);
+        const float *b = gy.rowPtr(y);
+        float *out = dst.rowPtr(y);
+        #pragma omp simd
+        for (int e = 0; e < rowWidth; ++e) {
+            out[e] = std::sqrt(a[e] * a[e] + b[e] * b[e]);
+        }
+    }
+}
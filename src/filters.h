@@ -0,0 +1,79 @@
+#pragma once
+
+#include <libgpu/shared_device_buffer.h>
+#include <libimages/images.h>
+
+#include <vector>
+
+
+// Ядро свертки width x height (оба нечетные), коэффициенты по строкам, центр ядра - в его середине.
+// Применяется как корреляция, без разворота: dst(x, y) = sum k(i, j) * src(x + i - width / 2, y + j - height / 2)
+struct ConvolutionKernel {
+    unsigned int width;
+    unsigned int height;
+    std::vector<float> weights;
+
+    ConvolutionKernel(unsigned int width, unsigned int height, const std::vector<float> &weights);
+
+    unsigned int radiusX() const    { return width / 2;     }
+    unsigned int radiusY() const    { return height / 2;    }
+};
+
+// Сепарабельное ядро - произведение горизонтального ядра на вертикальное, свертка с ним - два одномерных прохода
+struct SeparableKernel {
+    std::vector<float> horizontal;
+    std::vector<float> vertical;
+
+    SeparableKernel(const std::vector<float> &horizontal, const std::vector<float> &vertical);
+
+    ConvolutionKernel horizontalKernel() const  { return ConvolutionKernel((unsigned int) horizontal.size(), 1, horizontal);  }
+    ConvolutionKernel verticalKernel() const    { return ConvolutionKernel(1, (unsigned int) vertical.size(), vertical);      }
+};
+
+// Нормированное гауссово ядро радиуса ceil(3 * sigma)
+SeparableKernel gaussianKernel(float sigma);
+// Повышение резкости: src + amount * (src - среднее четырех соседей), 3x3
+ConvolutionKernel sharpenKernel(float amount = 1.0f);
+// Производные Собеля по x и по y, 3x3
+SeparableKernel sobelXKernel();
+SeparableKernel sobelYKernel();
+
+// Фильтры картинок на видеокарте активного контекста. Картинки могут быть многоканальными - каналы фильтруются независимо,
+// за краем картинки повторяется крайний пиксель. Строки картинок копируются с учетом шага (write2D/read2D),
+// поэтому подходят и вырезанные куски. Результат должен быть того же размера, что и исходная картинка.
+// Плитки с каймой загружаются в локальную память, ядро свертки лежит в константной памяти.
+class ImageFilter {
+public:
+    ImageFilter();
+
+    void convolve(const images::Image<float> &src, images::Image<float> &dst, const ConvolutionKernel &kernel);
+    void convolve(const images::Image<float> &src, images::Image<float> &dst, const SeparableKernel &kernel);
+
+    void gaussianBlur(const images::Image<float> &src, images::Image<float> &dst, float sigma);
+    void sharpen(const images::Image<float> &src, images::Image<float> &dst, float amount = 1.0f);
+    // Модуль градиента Собеля sqrt(gx^2 + gy^2)
+    void sobel(const images::Image<float> &src, images::Image<float> &dst);
+
+    // Данные остаются на видеокарте: плотные строки по width * cn float, dst не должен совпадать с src
+    void convolve(const gpu::gpu_mem_32f &src, gpu::gpu_mem_32f &dst, unsigned int width, unsigned int height, unsigned int cn,
+                  const ConvolutionKernel &kernel);
+    void convolve(const gpu::gpu_mem_32f &src, gpu::gpu_mem_32f &dst, unsigned int width, unsigned int height, unsigned int cn,
+                  const SeparableKernel &kernel);
+    void sobel(const gpu::gpu_mem_32f &src, gpu::gpu_mem_32f &dst, unsigned int width, unsigned int height, unsigned int cn);
+
+protected:
+    void upload(const images::Image<float> &image);
+    void download(images::Image<float> &image);
+
+    gpu::gpu_mem_32f weights_;
+    gpu::gpu_mem_32f src_;
+    gpu::gpu_mem_32f dst_;
+    gpu::gpu_mem_32f temp_;
+};
+
+// Те же фильтры на процессоре: OpenMP по строкам и SIMD по элементам строки - запасной путь и эталон для проверки
+void convolveCPU(const images::Image<float> &src, images::Image<float> &dst, const ConvolutionKernel &kernel);
+void convolveCPU(const images::Image<float> &src, images::Image<float> &dst, const SeparableKernel &kernel);
+void gaussianBlurCPU(const images::Image<float> &src, images::Image<float> &dst, float sigma);
+void sharpenCPU(const images::Image<float> &src, images::Image<float> &dst, float amount = 1.0f);
+void sobelCPU(const images::Image<float> &src, images::Image<float> &dst);
@@ -0,0 +1,128 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/csr_matrix.h>
+#include <libgpu/cg.h>
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+
+// Уравнение Пуассона на сетке size x size: пятиточечный оператор Лапласа плюс небольшая неоднородная добавка на диагонали,
+// чтобы предобуславливателю Якоби было что делать
+template <typename T>
+gpu::CsrMatrix<T> poissonMatrix(unsigned int size)
+{
+    unsigned int n = size * size;
+    std::vector<unsigned int> row_offsets(1, 0);
+    std::vector<unsigned int> column_indices;
+    std::vector<T> values;
+    for (unsigned int y = 0; y < size; ++y) {
+        for (unsigned int x = 0; x < size; ++x) {
+            unsigned int i = y * size + x;
+            if (y > 0)          { column_indices.push_back(i - size);  values.push_back(-1); }
+            if (x > 0)          { column_indices.push_back(i - 1);     values.push_back(-1); }
+            column_indices.push_back(i);
+            values.push_back((T) (4.0 + 0.01 * (1 + (i * 7) % 100)));
+            if (x + 1 < size)   { column_indices.push_back(i + 1);     values.push_back(-1); }
+            if (y + 1 < size)   { column_indices.push_back(i + size);  values.push_back(-1); }
+            row_offsets.push_back((unsigned int) values.size());
+        }
+    }
+
+    gpu::gpu_mem_32u row_offsets_gpu = gpu::gpu_mem_32u::createN(row_offsets.size());
+    gpu::gpu_mem_32u column_indices_gpu = gpu::gpu_mem_32u::createN(column_indices.size());
+    gpu::shared_device_buffer_typed<T> values_gpu = gpu::shared_device_buffer_typed<T>::createN(values.size());
+    row_offsets_gpu.writeN(row_offsets.data(), row_offsets.size());
+    column_indices_gpu.writeN(column_indices.data(), column_indices.size());
+    values_gpu.writeN(values.data(), values.size());
+    return gpu::CsrMatrix<T>(n, n, row_offsets_gpu, column_indices_gpu, values_gpu);
+}
+
+template <typename T>
+void benchmarkCg(const std::string &name, unsigned int size, double tolerance)
+{
+    gpu::CsrMatrix<T> a = poissonMatrix<T>(size);
+    unsigned int n = a.rows();
+
+    // правая часть строится по известному решению
+    FastRandom r(n);
+    std::vector<T> solution(n);
+    for (unsigned int i = 0; i < n; ++i) {
+        solution[i] = (T) (r.nextf() / 1000.0f);
+    }
+    gpu::shared_device_buffer_typed<T> solution_gpu = gpu::shared_device_buffer_typed<T>::createN(n);
+    gpu::shared_device_buffer_typed<T> b_gpu, x_gpu;
+    solution_gpu.writeN(solution.data(), n);
+    a.multiply(solution_gpu, b_gpu);
+
+    std::cout << name << ", Poisson " << size << "x" << size << " (" << n << " unknowns, " << a.nnz() << " values):" << std::endl;
+
+    // время одного SpMV - нижняя граница времени итерации
+    timer t_spmv;
+    for (int iter = 0; iter < 10; ++iter) {
+        a.multiply(solution_gpu, x_gpu);
+        t_spmv.nextLap();
+    }
+
+    x_gpu = gpu::shared_device_buffer_typed<T>();
+    gpu::conjugateGradient(a, b_gpu, x_gpu, tolerance, 1);   // компиляция кернелов
+    x_gpu = gpu::shared_device_buffer_typed<T>();
+
+    timer t;
+    gpu::CgResult result = gpu::conjugateGradient(a, b_gpu, x_gpu, tolerance, 10000);
+    double seconds = t.elapsed();
+
+    std::cout << "    " << result.iterations << " iterations, relative residual " << result.relative_residual
+              << (result.converged ? "" : " (not converged)") << std::endl;
+    std::cout << "    " << seconds << " s, " << seconds / std::max(1u, result.iterations) * 1e6 << " us per iteration, SpMV alone "
+              << t_spmv.lapAvg() * 1e6 << " us" << std::endl;
+
+    std::vector<T> x(n);
+    x_gpu.readN(x.data(), n);
+    double max_error = 0.0, error_norm2 = 0.0, solution_norm2 = 0.0;
+    for (unsigned int i = 0; i < n; ++i) {
+        double error = (double) x[i] - (double) solution[i];
+        max_error = std::max(max_error, std::abs(error));
+        error_norm2 += error * error;
+        solution_norm2 += (double) solution[i] * solution[i];
+    }
+    double relative_error = std::sqrt(error_norm2 / solution_norm2);
+    std::cout << "    max error of solution: " << max_error << ", relative error: " << relative_error << std::endl;
+    if (!result.converged) {
+        throw std::runtime_error(name + ": conjugate gradient didn't converge!");
+    }
+    // относительная ошибка не больше числа обусловленности, умноженного на относительную невязку: собственные числа матрицы
+    // лежат в [0.01, 9] из-за добавки на диагонали (не меньше 0.01) и кругов Гершгорина, то есть обусловленность не больше 900
+    double max_relative_error = 1000.0 * tolerance;
+    if (relative_error > max_relative_error) {
+        throw std::runtime_error(name + ": relative error of solution " + to_string(relative_error) + " exceeds " + to_string(max_relative_error) + "!");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    // маленькая задача показывает накладные расходы на запуски кернелов и чтение невязки, большая - пропускную способность
+    benchmarkCg<float>("float", 64, 1e-5);
+    benchmarkCg<float>("float", 1024, 1e-5);
+    if (context.cl()->deviceInfo().extensions.count("cl_khr_fp64") > 0) {
+        benchmarkCg<double>("double", 64, 1e-10);
+        benchmarkCg<double>("double", 1024, 1e-10);
+    } else {
+        std::cout << "Device doesn't support double precision, double solver skipped" << std::endl;
+    }
+
+    return 0;
+}
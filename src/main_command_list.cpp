@@ -0,0 +1,111 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libgpu/context.h>
+#include <libgpu/command_list.h>
+#include <libgpu/shared_device_buffer.h>
+
+// Этот файл будет сгенерирован автоматически в момент сборки - см. convertIntoHeader в CMakeLists.txt
+#include "cl/launch_overhead_cl.h"
+
+#include <vector>
+#include <thread>
+#include <iostream>
+#include <stdexcept>
+
+
+// Проверяет что первые m элементов равны expected, а остальные - нулю
+void checkIncremented(const gpu::gpu_mem_32u &data_gpu, unsigned int n, unsigned int m, unsigned int expected, const std::string &name)
+{
+    std::vector<unsigned int> data(n);
+    data_gpu.readN(data.data(), n);
+    for (unsigned int i = 0; i < n; ++i) {
+        unsigned int value = (i < m) ? expected : 0;
+        if (data[i] != value) {
+            throw std::runtime_error(name + ": element " + to_string(i) + " is " + to_string(data[i]) + " instead of " + to_string(value) + "!");
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    unsigned int n = 1024;
+    std::vector<unsigned int> zeros(n, 0);
+
+    gpu::gpu_mem_32u as_gpu, bs_gpu;
+    as_gpu.resizeN(n);
+    bs_gpu.resizeN(n);
+    as_gpu.writeN(zeros.data(), n);
+    bs_gpu.writeN(zeros.data(), n);
+
+    ocl::Kernel increment(launch_overhead_kernel, launch_overhead_kernel_length, "increment");
+    increment.compile();
+
+    unsigned int workGroupSize = 128;
+    gpu::WorkSize ws(workGroupSize, n);
+
+    // Цепочка коротких кернелов - как итерации итеративного метода: записываем один раз, затем только переигрываем
+    unsigned int launches = 100;
+    gpu::CommandList list;
+    std::vector<size_t> commands;
+    for (unsigned int k = 0; k < launches; ++k) {
+        commands.push_back(increment.record(list, ws, as_gpu, n));
+    }
+    std::vector<unsigned int> as(n);
+    list.read(as_gpu, as.data(), n * sizeof(unsigned int));
+
+    list.replay();
+    for (unsigned int i = 0; i < n; ++i) {
+        if (as[i] != launches) {
+            throw std::runtime_error("Replay: element " + to_string(i) + " is " + to_string(as[i]) + " instead of " + to_string(launches) + "!");
+        }
+    }
+
+    // Сравниваем с обычными запусками тех же кернелов
+    int iters = 100;
+    timer t;
+    for (int iter = 0; iter < iters; ++iter) {
+        for (unsigned int k = 0; k < launches; ++k) {
+            increment.exec(ws, as_gpu, n);
+        }
+        as_gpu.readN(as.data(), n);
+    }
+    t.stop();
+    double execTime = t.elapsed() / iters;
+
+    t.restart();
+    for (int iter = 0; iter < iters; ++iter) {
+        list.replay();
+    }
+    t.stop();
+    double replayTime = t.elapsed() / iters;
+    std::cout << launches << " launches + read: exec " << execTime * 1e6 << " us, replay " << replayTime * 1e6 << " us" << std::endl;
+    checkIncremented(as_gpu, n, n, launches * (1 + 2 * iters), "exec and replay");
+
+    // Подменяем аргументы записанных запусков: другой буфер и только первые m элементов
+    unsigned int m = n / 3;
+    for (size_t k = 0; k < commands.size(); ++k) {
+        list.setArg(commands[k], 0, bs_gpu);
+        list.setArg(commands[k], 1, m);
+    }
+    list.replay();
+    checkIncremented(bs_gpu, n, m, launches, "patched arguments");
+
+    // Переигрываем из другого потока с тем же контекстом - кернелы берутся этого потока, а не записавшего список
+    std::thread worker([&]() {
+        gpu::Context workerContext = context;
+        workerContext.activate();
+        list.replay();
+    });
+    worker.join();
+    checkIncremented(bs_gpu, n, m, 2 * launches, "replay from another thread");
+
+    std::cout << "Command list results are correct" << std::endl;
+
+    return 0;
+}
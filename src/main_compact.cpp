@@ -0,0 +1,169 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/compact.h>
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+
+template <typename T>
+void checkEqual(const std::vector<T> &result, const std::vector<T> &reference, const std::string &name)
+{
+    for (size_t i = 0; i < reference.size(); ++i) {
+        if (result[i] != reference[i]) {
+            throw std::runtime_error(name + " differs from CPU at " + to_string(i) + "!");
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    int benchmarkingIters = 10;
+
+    unsigned int n = 32*1024*1024;
+    FastRandom r(n);
+    std::vector<float> values(n);
+    for (unsigned int i = 0; i < n; ++i) {
+        values[i] = r.nextf();
+    }
+
+    gpu::gpu_mem_32f values_gpu, result_gpu;
+    values_gpu.resizeN(n);
+    values_gpu.writeN(values.data(), n);
+
+    // Фильтрация: как было - данные едут на хост, фильтруются и возвращаются обратно
+    const float threshold = 0.9f;
+    std::vector<float> reference;
+    for (unsigned int i = 0; i < n; ++i) {
+        if (values[i] > threshold) {
+            reference.push_back(values[i]);
+        }
+    }
+    std::cout << n << " floats, selected " << reference.size() << " (x > " << threshold << "):" << std::endl;
+    {
+        std::vector<float> host(n);
+        std::vector<float> selected;
+        timer t;
+        for (int iter = 0; iter < benchmarkingIters; ++iter) {
+            values_gpu.readN(host.data(), n);
+            selected.clear();
+            for (unsigned int i = 0; i < n; ++i) {
+                if (host[i] > threshold) {
+                    selected.push_back(host[i]);
+                }
+            }
+            result_gpu.growN(selected.size());
+            result_gpu.writeN(selected.data(), selected.size());
+            t.nextLap();
+        }
+        std::cout << "    through host: " << t.lapAvg() << "+-" << t.lapStd() << " s" << std::endl;
+    }
+    {
+        // первый вызов компилирует кернелы - не учитываем его во времени
+        gpu::copyIf(values_gpu, result_gpu, "x > 0.9f");
+
+        size_t count = 0;
+        timer t;
+        for (int iter = 0; iter < benchmarkingIters; ++iter) {
+            count = gpu::copyIf(values_gpu, result_gpu, "x > 0.9f");
+            t.nextLap();
+        }
+        std::cout << "    GPU copyIf: " << t.lapAvg() << "+-" << t.lapStd() << " s, " << (n/1000.0/1000.0) / t.lapAvg() << " millions/s" << std::endl;
+
+        if (count != reference.size()) {
+            throw std::runtime_error("copyIf selected " + to_string(count) + " instead of " + to_string(reference.size()) + "!");
+        }
+        std::vector<float> result(count);
+        result_gpu.readN(result.data(), count);
+        checkEqual(result, reference, "copyIf");
+    }
+
+    // Устойчивое разбиение: сначала подходящие элементы, потом остальные, порядок внутри частей сохраняется
+    {
+        std::vector<float> expected = values;
+        std::stable_partition(expected.begin(), expected.end(), [](float x) { return x < 0.5f; });
+
+        gpu::partition(values_gpu, result_gpu, "x < 0.5f");
+        timer t;
+        size_t count = 0;
+        for (int iter = 0; iter < benchmarkingIters; ++iter) {
+            count = gpu::partition(values_gpu, result_gpu, "x < 0.5f");
+            t.nextLap();
+        }
+        std::cout << "    GPU partition: " << (n/1000.0/1000.0) / t.lapAvg() << " millions/s, " << count << " elements go first" << std::endl;
+
+        std::vector<float> result(n);
+        result_gpu.readN(result.data(), n);
+        checkEqual(result, expected, "partition");
+    }
+
+    // Уникальные значения и сжатие серий: отсортированные ключи с повторами
+    {
+        std::vector<unsigned int> keys(n);
+        for (unsigned int i = 0; i < n; ++i) {
+            keys[i] = (unsigned int) r.next(0, 1000*1000);
+        }
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<unsigned int> expected_values;
+        std::vector<unsigned int> expected_lengths;
+        for (unsigned int i = 0; i < n; ++i) {
+            if (i == 0 || keys[i] != keys[i - 1]) {
+                expected_values.push_back(keys[i]);
+                expected_lengths.push_back(0);
+            }
+            ++expected_lengths.back();
+        }
+
+        gpu::gpu_mem_32u keys_gpu, unique_gpu, lengths_gpu;
+        keys_gpu.resizeN(n);
+        keys_gpu.writeN(keys.data(), n);
+
+        gpu::unique(keys_gpu, unique_gpu);
+        timer t;
+        size_t nunique = 0;
+        for (int iter = 0; iter < benchmarkingIters; ++iter) {
+            nunique = gpu::unique(keys_gpu, unique_gpu);
+            t.nextLap();
+        }
+        std::cout << n << " sorted uints, " << expected_values.size() << " unique:" << std::endl;
+        std::cout << "    GPU unique: " << (n/1000.0/1000.0) / t.lapAvg() << " millions/s" << std::endl;
+        if (nunique != expected_values.size()) {
+            throw std::runtime_error("unique found " + to_string(nunique) + " values instead of " + to_string(expected_values.size()) + "!");
+        }
+        std::vector<unsigned int> result(nunique);
+        unique_gpu.readN(result.data(), nunique);
+        checkEqual(result, expected_values, "unique");
+
+        gpu::runLengthEncode(keys_gpu, unique_gpu, lengths_gpu);
+        timer t_rle;
+        size_t nruns = 0;
+        for (int iter = 0; iter < benchmarkingIters; ++iter) {
+            nruns = gpu::runLengthEncode(keys_gpu, unique_gpu, lengths_gpu);
+            t_rle.nextLap();
+        }
+        std::cout << "    GPU runLengthEncode: " << (n/1000.0/1000.0) / t_rle.lapAvg() << " millions/s" << std::endl;
+        if (nruns != expected_values.size()) {
+            throw std::runtime_error("runLengthEncode found " + to_string(nruns) + " runs instead of " + to_string(expected_values.size()) + "!");
+        }
+        std::vector<unsigned int> lengths(nruns);
+        unique_gpu.readN(result.data(), nruns);
+        lengths_gpu.readN(lengths.data(), nruns);
+        checkEqual(result, expected_values, "runLengthEncode values");
+        checkEqual(lengths, expected_lengths, "runLengthEncode lengths");
+    }
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/opencl/sub_devices.h>
+
+// Этот файл будет сгенерирован автоматически в момент сборки - см. convertIntoHeader в CMakeLists.txt
+#include "cl/multi_device_cl.h"
+
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+
+int main(int argc, char **argv)
+{
+    // Разбиение на под-устройства имеет смысл для CPU OpenCL runtime (например pocl или Intel CPU runtime)
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    ocl::DeviceInfo info;
+    info.init(device.device_id_opencl);
+    if (info.device_type != CL_DEVICE_TYPE_CPU || !ocl::SubDevices::isSupported(device.device_id_opencl)) {
+        std::cout << "Device can't be partitioned, CPU OpenCL 1.2 device is required" << std::endl;
+        return 0;
+    }
+
+    // Сначала пытаемся выделить по под-устройству на каждый NUMA-узел (если драйвер умеет так делить - например pocl не умеет),
+    // а если узел один - просто делим ядра пополам, чтобы изолировать два независимых конвейера
+    ocl::SubDevices subdevices;
+    if (ocl::SubDevices::isAffinityDomainSupported(device.device_id_opencl, CL_DEVICE_AFFINITY_DOMAIN_NUMA)) {
+        subdevices.partitionByAffinityDomain(device.device_id_opencl, CL_DEVICE_AFFINITY_DOMAIN_NUMA);
+    }
+    if (subdevices.size() < 2) {
+        if (!ocl::SubDevices::isPartitionSupported(device.device_id_opencl, CL_DEVICE_PARTITION_EQUALLY)) {
+            std::cout << "Device can't be partitioned equally" << std::endl;
+            return 0;
+        }
+        subdevices.partitionEqually(device.device_id_opencl, std::max<unsigned int>(1, info.max_compute_units / 2));
+    }
+    std::cout << "Device partitioned into " << subdevices.size() << " sub-devices" << std::endl;
+
+    unsigned int n = 8*1024*1024;
+    unsigned int iters = 256;
+    unsigned int workGroupSize = 128;
+
+    ocl::Kernel iterate(multi_device_kernel, multi_device_kernel_length, "iterate");
+
+    // Каждый конвейер работает в своем потоке со своим контекстом на своем под-устройстве,
+    // данные инициализируются этим же потоком, т.е. страницы памяти окажутся на ближайшем NUMA-узле
+    std::vector<double> times(subdevices.size(), 0.0);
+    std::vector<std::string> errors(subdevices.size());
+    std::vector<std::thread> threads;
+    for (size_t d = 0; d < subdevices.size(); ++d) {
+        threads.push_back(std::thread([&, d]() {
+            try {
+                gpu::Context context;
+                context.init(subdevices.device(d));
+                context.activate();
+
+                std::vector<float> xs(n, 0);
+                std::vector<float> ys(n, 0);
+                FastRandom r(d);
+                for (unsigned int i = 0; i < n; ++i) {
+                    xs[i] = r.nextf();
+                }
+
+                gpu::gpu_mem_32f xs_gpu, ys_gpu;
+                xs_gpu.resizeN(n);
+                ys_gpu.resizeN(n);
+                xs_gpu.writeN(xs.data(), n);
+
+                iterate.compile();
+
+                timer t;
+                iterate.exec(gpu::WorkSize(workGroupSize, n), xs_gpu, ys_gpu, n, iters);
+                ys_gpu.readN(ys.data(), n);
+                times[d] = t.elapsed();
+            } catch (const std::exception &e) {
+                errors[d] = e.what();
+            }
+        }));
+    }
+    for (size_t d = 0; d < threads.size(); ++d) {
+        threads[d].join();
+    }
+
+    for (size_t d = 0; d < subdevices.size(); ++d) {
+        if (!errors[d].empty()) {
+            throw std::runtime_error("Sub-device #" + to_string(d) + " failed: " + errors[d]);
+        }
+        std::cout << "Sub-device #" << d << ": " << times[d] << " s" << std::endl;
+    }
+
+    return 0;
+}
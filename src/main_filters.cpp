@@ -0,0 +1,110 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libimages/images.h>
+
+#include "filters.h"
+#include "mandelbrot.h"
+
+#include <cmath>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+
+
+int benchmarkingIters = 10;
+
+double benchmark(const std::function<void()> &run)
+{
+    // первый вызов компилирует кернелы - не учитываем его во времени
+    run();
+    timer t;
+    for (int iter = 0; iter < benchmarkingIters; ++iter) {
+        run();
+        t.nextLap();
+    }
+    return t.lapAvg();
+}
+
+void checkClose(const images::Image<float> &a, const images::Image<float> &b, const std::string &name)
+{
+    float maxDiff = 0.0f;
+    for (size_t y = 0; y < a.height; ++y) {
+        const float *rowA = a.rowPtr(y);
+        const float *rowB = b.rowPtr(y);
+        for (size_t e = 0; e < a.width * a.cn; ++e) {
+            maxDiff = std::max(maxDiff, std::abs(rowA[e] - rowB[e]));
+        }
+    }
+    if (maxDiff > 1e-4f) {
+        throw std::runtime_error(name + ": GPU and CPU results differ by " + to_string(maxDiff) + "!");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    // Картинка для фильтров - раскрашенный фрактал: много мелких деталей и резких границ
+    unsigned int width = 3840;
+    unsigned int height = 2160;
+    images::Image<unsigned char> frame(width, height, 3);
+    MandelbrotRenderer renderer;
+    renderer.render(MandelbrotView(-0.745, 0.1, 0.05, 512), frame);
+
+    images::Image<float> image(width, height, 3);
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < width; ++x) {
+            for (unsigned int c = 0; c < 3; ++c) {
+                image(y, x, c) = frame(y, x, c) / 255.0f;
+            }
+        }
+    }
+
+    ImageFilter filter;
+    images::Image<float> resultGPU(width, height, 3);
+    images::Image<float> resultCPU(width, height, 3);
+
+    struct Filter {
+        std::string name;
+        std::function<void(const images::Image<float> &, images::Image<float> &)> gpu;
+        std::function<void(const images::Image<float> &, images::Image<float> &)> cpu;
+    };
+    const Filter filters[] = {
+        {"gaussian blur, sigma 2",  [&](const images::Image<float> &src, images::Image<float> &dst) { filter.gaussianBlur(src, dst, 2.0f); },
+                                    [&](const images::Image<float> &src, images::Image<float> &dst) { gaussianBlurCPU(src, dst, 2.0f); }},
+        {"gaussian blur, sigma 8",  [&](const images::Image<float> &src, images::Image<float> &dst) { filter.gaussianBlur(src, dst, 8.0f); },
+                                    [&](const images::Image<float> &src, images::Image<float> &dst) { gaussianBlurCPU(src, dst, 8.0f); }},
+        {"sharpen",                 [&](const images::Image<float> &src, images::Image<float> &dst) { filter.sharpen(src, dst); },
+                                    [&](const images::Image<float> &src, images::Image<float> &dst) { sharpenCPU(src, dst); }},
+        {"sobel",                   [&](const images::Image<float> &src, images::Image<float> &dst) { filter.sobel(src, dst); },
+                                    [&](const images::Image<float> &src, images::Image<float> &dst) { sobelCPU(src, dst); }},
+    };
+
+    std::cout << "RGB image " << width << "x" << height << ":" << std::endl;
+    double megapixels = width * height / 1000.0 / 1000.0;
+    for (const Filter &f : filters) {
+        double cpuTime = benchmark([&]() { f.cpu(image, resultCPU); });
+        double gpuTime = benchmark([&]() { f.gpu(image, resultGPU); });
+        std::cout << "    " << f.name << ": CPU " << megapixels / cpuTime << " MPix/s, GPU with transfers " << megapixels / gpuTime << " MPix/s" << std::endl;
+        checkClose(resultGPU, resultCPU, f.name);
+    }
+
+    // Без копирования картинки туда и обратно - как если бы фильтры были частью конвейера на видеокарте
+    {
+        gpu::gpu_mem_32f src, dst;
+        src.resizeN(width * height * 3);
+        src.writeN(image.ptr(), width * height * 3);
+        double time = benchmark([&]() { filter.convolve(src, dst, width, height, 3, gaussianKernel(8.0f)); });
+        std::cout << "    gaussian blur, sigma 8, on device only: " << megapixels / time << " MPix/s" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/expression.h>
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <stdexcept>
+#include <functional>
+
+
+int benchmarkingIters = 10;
+
+double benchmark(const std::string &name, unsigned int n, const std::function<void()> &run)
+{
+    // первый вызов компилирует кернелы - не учитываем его во времени
+    run();
+    timer t;
+    for (int iter = 0; iter < benchmarkingIters; ++iter) {
+        run();
+        t.nextLap();
+    }
+    std::cout << "    " << name << ": " << t.lapAvg() * 1000 << "+-" << t.lapStd() * 1000 << " ms, "
+              << n / 1000.0 / 1000.0 / t.lapAvg() << " millions of elements/s" << std::endl;
+    return t.lapAvg();
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    unsigned int n = 32 * 1000 * 1000;
+    std::vector<float> as(n), bs(n), cs(n);
+    FastRandom r(n);
+    for (unsigned int i = 0; i < n; ++i) {
+        as[i] = r.nextf();
+        bs[i] = std::abs(r.nextf());
+    }
+
+    gpu::gpu_mem_32f a, b, c, t1, t2, t3;
+    a.resizeN(n);
+    b.resizeN(n);
+    a.writeN(as.data(), n);
+    b.writeN(bs.data(), n);
+
+    // c = a * 2 + sqrt(b) + 0.5 * (a - b)^2
+    std::cout << "c = a * 2 + sqrt(b) + 0.5 * (a - b)^2 for " << n << " floats:" << std::endl;
+    // Сгенерированный кернел обрабатывает векторами такой ширины (на процессорах - ширина SIMD регистров, на видеокартах обычно 1)
+    std::cout << "    native vector width for float: " << context.cl()->deviceInfo().native_vector_width_float << std::endl;
+
+    // Как если бы на каждую операцию был свой кернел в духе aplusb: каждая операция - отдельный проход по памяти с временными буферами
+    double separateTime = benchmark("separate kernels", n, [&]() {
+        gpu::eval(t1, a * 2.0f);
+        gpu::eval(t2, sqrt(b));
+        gpu::eval(t1, t1 + t2);
+        gpu::eval(t3, a - b);
+        gpu::eval(t3, t3 * t3);
+        gpu::eval(t3, t3 * 0.5f);
+        gpu::eval(c, t1 + t3);
+    });
+
+    // Одно выражение - один сгенерированный кернел, a и b читаются по одному разу, временных буферов нет
+    gpu::Expression<float> d = a - b;
+    double fusedTime = benchmark("fused expression", n, [&]() {
+        gpu::eval(c, a * 2.0f + sqrt(b) + 0.5f * d * d);
+    });
+    std::cout << "    speedup of fusion: " << separateTime / fusedTime << "x" << std::endl;
+
+    c.readN(cs.data(), n);
+    for (unsigned int i = 0; i < n; ++i) {
+        float expected = as[i] * 2.0f + std::sqrt(bs[i]) + 0.5f * (as[i] - bs[i]) * (as[i] - bs[i]);
+        if (std::abs(cs[i] - expected) > 1e-5f * std::max(1.0f, std::abs(expected))) {
+            throw std::runtime_error("Element " + to_string(i) + " is " + to_string(cs[i]) + " instead of " + to_string(expected) + "!");
+        }
+    }
+
+    // 8-битные числа в выражении, как и в C, складываются в int: (200 + 100) / 2 = 150, а не 22, и векторная часть кернела
+    // должна давать то же, что и поэлементный хвост - поэтому число элементов не кратно ширине вектора
+    unsigned int m = 1000 * 1000 + 3;
+    std::vector<uint8_t> xs(m), ys(m), zs(m);
+    for (unsigned int i = 0; i < m; ++i) {
+        xs[i] = (uint8_t) r.next(0, 255);
+        ys[i] = (uint8_t) r.next(0, 255);
+    }
+    xs[0] = 200;
+    ys[0] = 100;
+    xs[m - 1] = 200;
+    ys[m - 1] = 100;
+    gpu::gpu_mem_8u x, y, z;
+    x.resizeN(m);
+    y.resizeN(m);
+    x.writeN(xs.data(), m);
+    y.writeN(ys.data(), m);
+    gpu::eval(z, (x + y) / 2);
+    z.readN(zs.data(), m);
+    for (unsigned int i = 0; i < m; ++i) {
+        uint8_t expected = (uint8_t) ((xs[i] + ys[i]) / 2);
+        if (zs[i] != expected) {
+            throw std::runtime_error("uint8 element " + to_string(i) + " is " + to_string((int) zs[i]) + " instead of " + to_string((int) expected) + "!");
+        }
+    }
+    std::cout << "uint8 (a + b) / 2 for " << m << " elements is correct" << std::endl;
+
+    std::cout << "Generated kernel:" << std::endl;
+    std::cout << gpu::expressionSource(a * 2.0f + sqrt(b) + 0.5f * d * d) << std::endl;
+
+    return 0;
+}
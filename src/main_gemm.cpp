@@ -0,0 +1,184 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/opencl/program_cache.h>
+#include <libgpu/gemm.h>
+
+#include "cl/gemm_naive_cl.h"
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <stdexcept>
+
+
+// Умножение на процессоре: строки C делятся между ядрами, внутренний цикл по столбцам векторизуется
+template <typename T>
+void gemmCPU(unsigned int m, unsigned int n, unsigned int k, const std::vector<T> &a, const std::vector<T> &b, std::vector<T> &c)
+{
+    #pragma omp parallel for
+    for (int i = 0; i < (int) m; ++i) {
+        T *row = &c[(size_t) i * n];
+        for (unsigned int j = 0; j < n; ++j) {
+            row[j] = 0;
+        }
+        for (unsigned int p = 0; p < k; ++p) {
+            const T a_ip = a[(size_t) i * k + p];
+            const T *b_row = &b[(size_t) p * n];
+            #pragma omp simd
+            for (int j = 0; j < (int) n; ++j) {
+                row[j] += a_ip * b_row[j];
+            }
+        }
+    }
+}
+
+double gflops(unsigned int m, unsigned int n, unsigned int k, double seconds)
+{
+    return 2.0 * m * n * k / seconds / 1e9;
+}
+
+template <typename T>
+void checkResult(const std::vector<T> &result, const std::vector<T> &reference, unsigned int k, const std::string &name)
+{
+    // ошибка округления растет с длиной скалярного произведения
+    double tolerance = (sizeof(T) == 4 ? 1e-5 : 1e-12) * k;
+    for (size_t i = 0; i < reference.size(); ++i) {
+        if (std::abs((double) result[i] - (double) reference[i]) > tolerance * (1.0 + std::abs((double) reference[i]))) {
+            throw std::runtime_error(name + " differs from CPU at " + to_string(i) + ": " + to_string(result[i]) + " vs " + to_string(reference[i]) + "!");
+        }
+    }
+}
+
+template <typename T>
+void benchmark(const std::string &name, unsigned int m, unsigned int n, unsigned int k, int benchmarkingIters)
+{
+    std::cout << name << " " << m << "x" << k << " * " << k << "x" << n << ":" << std::endl;
+
+    FastRandom r(m + n + k);
+    std::vector<T> a((size_t) m * k), b((size_t) k * n), c((size_t) m * n), reference((size_t) m * n);
+    for (size_t i = 0; i < a.size(); ++i) {
+        a[i] = (T) r.nextf();
+    }
+    for (size_t i = 0; i < b.size(); ++i) {
+        b[i] = (T) r.nextf();
+    }
+
+    {
+        timer t;
+        gemmCPU(m, n, k, a, b, reference);
+        std::cout << "    CPU OpenMP: " << gflops(m, n, k, t.elapsed()) << " GFLOPS" << std::endl;
+    }
+
+    gpu::shared_device_buffer_typed<T> a_gpu, b_gpu, c_gpu;
+    a_gpu.resizeN(a.size());
+    b_gpu.resizeN(b.size());
+    c_gpu.resizeN(c.size());
+    a_gpu.writeN(a.data(), a.size());
+    b_gpu.writeN(b.data(), b.size());
+
+    // результат наивного кернела - эталон для проверки транспонированных вариантов
+    std::vector<T> naive((size_t) m * n);
+    {
+        ocl::Kernel gemm_naive(gemm_naive_kernel, gemm_naive_kernel_length, "gemm_naive", ocl::typeDefines<T>());
+        gemm_naive.compile();
+        gpu::WorkSize ws(16, 16, n, m);
+        timer t;
+        for (int iter = 0; iter < benchmarkingIters; ++iter) {
+            gemm_naive.exec(ws, a_gpu, b_gpu, c_gpu, m, n, k);
+            t.nextLap();
+        }
+        std::cout << "    GPU naive: " << gflops(m, n, k, t.lapAvg()) << " GFLOPS" << std::endl;
+        c_gpu.readN(naive.data(), naive.size());
+        checkResult(naive, reference, k, "naive GEMM");
+    }
+
+    // Разные размеры блоков: лучший зависит от видеокарты, подбирается по этой таблице
+    std::vector<gpu::GemmTiles> variants;
+    variants.push_back(gpu::gemmDefaultTiles<T>());
+    variants.push_back(gpu::GemmTiles(32, 32, 16, 2, 2));
+    variants.push_back(gpu::GemmTiles(64, 64, 8, 4, 4));
+    variants.push_back(gpu::GemmTiles(128, 64, 8, 8, 4));
+    gpu::Context context;
+    for (size_t v = 0; v < variants.size(); ++v) {
+        const gpu::GemmTiles &tiles = variants[v];
+        unsigned int groupSize = (tiles.tile_m / tiles.item_m) * (tiles.tile_n / tiles.item_n);
+        if (groupSize > context.getMaxWorkgroupSize()) {
+            std::cout << "    GPU tiled " << tiles.tile_m << "x" << tiles.tile_n << "x" << tiles.tile_k
+                      << ", " << tiles.item_m << "x" << tiles.item_n << " per work item: skipped, " << groupSize
+                      << " work items in group but device supports only " << context.getMaxWorkgroupSize() << std::endl;
+            continue;
+        }
+        gpu::gemm(false, false, m, n, k, (T) 1, a_gpu, k, b_gpu, n, (T) 0, c_gpu, n, tiles);
+
+        timer t;
+        for (int iter = 0; iter < benchmarkingIters; ++iter) {
+            gpu::gemm(false, false, m, n, k, (T) 1, a_gpu, k, b_gpu, n, (T) 0, c_gpu, n, tiles);
+            t.nextLap();
+        }
+        std::cout << "    GPU tiled " << tiles.tile_m << "x" << tiles.tile_n << "x" << tiles.tile_k
+                  << ", " << tiles.item_m << "x" << tiles.item_n << " per work item" << (v == 0 ? " (default)" : "") << ": "
+                  << gflops(m, n, k, t.lapAvg()) << " GFLOPS" << std::endl;
+        c_gpu.readN(c.data(), c.size());
+        checkResult(c, reference, k, "tiled GEMM");
+    }
+
+    // Транспонирование и alpha/beta: C = 2 * A * (B^T)^T - C, то есть B хранится транспонированной
+    {
+        std::vector<T> b_transposed(b.size());
+        for (unsigned int p = 0; p < k; ++p) {
+            for (unsigned int j = 0; j < n; ++j) {
+                b_transposed[(size_t) j * k + p] = b[(size_t) p * n + j];
+            }
+        }
+        gpu::shared_device_buffer_typed<T> bt_gpu;
+        bt_gpu.resizeN(b.size());
+        bt_gpu.writeN(b_transposed.data(), b.size());
+        c_gpu.writeN(reference.data(), reference.size());
+        gpu::gemm(false, true, m, n, k, (T) 2, a_gpu, k, bt_gpu, k, (T) -1, c_gpu, n);
+        c_gpu.readN(c.data(), c.size());
+        checkResult(c, reference, k, "GEMM with transposed B");
+    }
+
+    // Транспонированная A: C = (A^T)^T * B, то есть A хранится транспонированной, сравниваем с наивным кернелом
+    {
+        std::vector<T> a_transposed(a.size());
+        for (unsigned int i = 0; i < m; ++i) {
+            for (unsigned int p = 0; p < k; ++p) {
+                a_transposed[(size_t) p * m + i] = a[(size_t) i * k + p];
+            }
+        }
+        gpu::shared_device_buffer_typed<T> at_gpu;
+        at_gpu.resizeN(a.size());
+        at_gpu.writeN(a_transposed.data(), a.size());
+        gpu::gemm(true, false, m, n, k, (T) 1, at_gpu, m, b_gpu, n, (T) 0, c_gpu, n);
+        c_gpu.readN(c.data(), c.size());
+        checkResult(c, naive, k, "GEMM with transposed A");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    int benchmarkingIters = 10;
+
+    benchmark<float>("SGEMM", 2048, 2048, 2048, benchmarkingIters);
+    // размеры не кратны блокам - медленный путь с проверками границ
+    benchmark<float>("SGEMM", 1000, 1500, 700, benchmarkingIters);
+
+    if (context.cl()->deviceInfo().extensions.count("cl_khr_fp64") > 0) {
+        benchmark<double>("DGEMM", 1024, 1024, 1024, benchmarkingIters);
+    } else {
+        std::cout << "Device doesn't support double precision, DGEMM skipped" << std::endl;
+    }
+
+    return 0;
+}
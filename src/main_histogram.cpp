@@ -0,0 +1,117 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/histogram.h>
+#include <libimages/images.h>
+
+#include "mandelbrot.h"
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+
+void checkBins(const gpu::gpu_mem_32u &bins_gpu, const std::vector<unsigned int> &reference, const std::string &name)
+{
+    std::vector<unsigned int> bins(reference.size());
+    bins_gpu.readN(bins.data(), bins.size());
+    for (size_t b = 0; b < reference.size(); ++b) {
+        if (bins[b] != reference[b]) {
+            throw std::runtime_error(name + ": bin " + to_string(b) + " has " + to_string(bins[b]) + " values instead of " + to_string(reference[b]) + "!");
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    int benchmarkingIters = 10;
+
+    // 8-битная картинка: у фрактала большие области одного цвета - худший случай для атомарных счетчиков
+    {
+        unsigned int width = 3840;
+        unsigned int height = 2160;
+        images::Image<unsigned char> image(width, height, 3);
+        MandelbrotRenderer renderer;
+        renderer.render(MandelbrotView(-0.5, 0.0, 3.0, 256), image);
+
+        size_t n = (size_t) width * height * image.cn;
+        std::vector<unsigned int> reference(256 * image.cn, 0);
+        {
+            timer t;
+            const unsigned char *pixels = image.ptr();
+            for (size_t i = 0; i < n; ++i) {
+                ++reference[(i % image.cn) * 256 + pixels[i]];
+            }
+            std::cout << "RGB image " << width << "x" << height << ":" << std::endl;
+            std::cout << "    CPU: " << (n / 1024.0 / 1024.0 / 1024.0) / t.elapsed() << " GB/s" << std::endl;
+        }
+
+        gpu::gpu_mem_8u pixels_gpu;
+        gpu::gpu_mem_32u bins_gpu;
+        pixels_gpu.resizeN(n);
+        pixels_gpu.writeN(image.ptr(), n);
+
+        // первый вызов компилирует кернелы - не учитываем его во времени
+        gpu::histogram(pixels_gpu, bins_gpu, 256, 0, 256, (unsigned int) image.cn);
+        timer t;
+        for (int iter = 0; iter < benchmarkingIters; ++iter) {
+            gpu::histogram(pixels_gpu, bins_gpu, 256, 0, 256, (unsigned int) image.cn);
+            t.nextLap();
+        }
+        std::cout << "    GPU: " << t.lapAvg() * 1000 << " ms, " << (n / 1024.0 / 1024.0 / 1024.0) / t.lapAvg() << " GB/s" << std::endl;
+        checkBins(bins_gpu, reference, "image histogram");
+    }
+
+    // Вещественные значения: маленькая гистограмма в локальной памяти и огромная - на глобальных атомиках
+    {
+        unsigned int n = 32*1024*1024;
+        FastRandom r(n);
+        std::vector<float> values(n);
+        for (unsigned int i = 0; i < n; ++i) {
+            // нормальное распределение (сумма равномерных), часть значений вне диапазона
+            values[i] = (r.nextf() + r.nextf() + r.nextf() + r.nextf()) / 4.0f * 1.2f - 0.1f;
+        }
+
+        gpu::gpu_mem_32f values_gpu;
+        gpu::gpu_mem_32u bins_gpu;
+        values_gpu.resizeN(n);
+        values_gpu.writeN(values.data(), n);
+
+        const unsigned int nbins_variants[] = {1000, 1000*1000};
+        for (int k = 0; k < 2; ++k) {
+            unsigned int nbins = nbins_variants[k];
+            const float scale = (float) nbins;
+            std::vector<unsigned int> reference(nbins, 0);
+            for (unsigned int i = 0; i < n; ++i) {
+                // так же, как считает кернел: в float
+                float position = values[i] * scale;
+                if (position >= 0 && position < nbins) {
+                    ++reference[std::min((unsigned int) position, nbins - 1)];
+                }
+            }
+
+            gpu::histogram(values_gpu, bins_gpu, nbins, 0.0, 1.0);
+            timer t;
+            for (int iter = 0; iter < benchmarkingIters; ++iter) {
+                gpu::histogram(values_gpu, bins_gpu, nbins, 0.0, 1.0);
+                t.nextLap();
+            }
+            std::cout << n << " floats, " << nbins << " bins:" << std::endl;
+            std::cout << "    GPU: " << t.lapAvg() * 1000 << " ms, " << (n / 1000.0 / 1000.0) / t.lapAvg() << " millions/s" << std::endl;
+            checkBins(bins_gpu, reference, to_string(nbins) + " bins histogram");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+
+// Этот файл будет сгенерирован автоматически в момент сборки - см. convertIntoHeader в CMakeLists.txt
+#include "cl/launch_overhead_cl.h"
+
+#include <new>
+#include <cstdlib>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+
+// Подсчитываем все выделения памяти в куче, сделанные текущим потоком
+// (потоки драйвера OpenCL нас не интересуют - нас интересует только путь запуска кернела на стороне libgpu)
+static THREAD_LOCAL size_t allocations_count = 0;
+
+void *operator new(size_t size)
+{
+    ++allocations_count;
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    unsigned int n = 1024;
+    std::vector<unsigned int> as(n, 0);
+
+    gpu::gpu_mem_32u as_gpu;
+    as_gpu.resizeN(n);
+    as_gpu.writeN(as.data(), n);
+
+    ocl::Kernel increment(launch_overhead_kernel, launch_overhead_kernel_length, "increment");
+    increment.compile();
+
+    unsigned int workGroupSize = 128;
+    unsigned int global_work_size = (n + workGroupSize - 1) / workGroupSize * workGroupSize;
+    gpu::WorkSize ws(workGroupSize, global_work_size);
+
+    // Первый запуск создает cl_kernel и заполняет кеши - это не установившийся режим
+    increment.exec(ws, as_gpu, n);
+
+    int iters = 10000;
+
+    allocations_count = 0;
+    timer t;
+    for (int iter = 0; iter < iters; ++iter) {
+        increment.exec(ws, as_gpu, n);
+    }
+    t.stop();
+    size_t launch_allocations = allocations_count;
+    std::cout << "Kernel launch: " << t.elapsed() * 1e6 / iters << " us per launch, "
+              << launch_allocations << " heap allocations in " << iters << " launches" << std::endl;
+
+    allocations_count = 0;
+    t.restart();
+    for (int iter = 0; iter < iters; ++iter) {
+        as_gpu.writeN(as.data(), n);
+        as_gpu.readN(as.data(), n);
+    }
+    t.stop();
+    size_t transfer_allocations = allocations_count;
+    std::cout << "Write+read of " << n << " uints: " << t.elapsed() * 1e6 / iters << " us per pair, "
+              << transfer_allocations << " heap allocations in " << iters << " pairs" << std::endl;
+
+    if (launch_allocations != 0 || transfer_allocations != 0) {
+        throw std::runtime_error("Steady-state launches and transfers should not allocate memory!");
+    }
+
+    return 0;
+}
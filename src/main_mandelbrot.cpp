@@ -0,0 +1,105 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libgpu/context.h>
+#include <libimages/images.h>
+
+#include "mandelbrot.h"
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <stdexcept>
+
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    unsigned int width = 2048;
+    unsigned int height = 2048;
+    int benchmarkingIters = 10;
+
+    // Разные виды - от почти целиком внутреннего (дорогие плитки) до почти целиком внешнего (дешевые)
+    std::vector<MandelbrotView> views;
+    std::vector<std::string> names;
+    views.push_back(MandelbrotView(-0.5, 0.0, 3.0, 256));                   names.push_back("whole");
+    views.push_back(MandelbrotView(-0.2, 0.0, 0.8, 1024));                  names.push_back("interior");
+    views.push_back(MandelbrotView(-0.743643, 0.131825, 0.0002, 2048));     names.push_back("seahorse");
+
+    MandelbrotRenderer renderer;
+
+    for (size_t v = 0; v < views.size(); ++v) {
+        const MandelbrotView &view = views[v];
+        std::cout << "View " << names[v] << " (center " << view.centerX << ", " << view.centerY
+                  << ", size " << view.sizeX << ", " << view.iterations << " iterations):" << std::endl;
+
+        images::Image<float> cpu_values(width, height, 1);
+        double cpu_time;
+        {
+            timer t;
+            for (int iter = 0; iter < benchmarkingIters; ++iter) {
+                renderMandelbrotCPU(view, cpu_values);
+                t.nextLap();
+            }
+            cpu_time = t.lapAvg();
+            std::cout << "    CPU OMP+SIMD: " << t.lapAvg() << "+-" << t.lapStd() << " s" << std::endl;
+        }
+
+        // Каждое ускорение добавляется к предыдущим, картинка обязана совпадать с полным перебором до пикселя - кроме трассировки границ:
+        // она смотрит только на пиксели границы прямоугольника и может залить нити множества тоньше пикселя, поэтому для нее
+        // допускаем малую долю отличающихся пикселей
+        unsigned int accelerations[] = {MandelbrotBruteForce,
+                                        MandelbrotInteriorTests,
+                                        MandelbrotInteriorTests | MandelbrotPeriodicity,
+                                        MandelbrotAllAccelerations};
+        const char *accelerationNames[] = {"brute force", "+cardioid/bulb", "+periodicity", "+boundary tracing"};
+
+        images::Image<float> brute_values(width, height, 1);
+        double brute_time = 0.0;
+        for (int a = 0; a < 4; ++a) {
+            renderer.setAcceleration(accelerations[a]);
+
+            images::Image<float> gpu_values(width, height, 1);
+            // первый вызов компилирует кернелы - не учитываем его во времени
+            renderer.render(view, gpu_values);
+            timer t;
+            for (int iter = 0; iter < benchmarkingIters; ++iter) {
+                renderer.render(view, gpu_values);
+                t.nextLap();
+            }
+            std::cout << "    GPU " << accelerationNames[a] << ": " << t.lapAvg() << "+-" << t.lapStd() << " s";
+
+            if (accelerations[a] == MandelbrotBruteForce) {
+                brute_values = gpu_values;
+                brute_time = t.lapAvg();
+                std::cout << ", speedup over CPU: " << cpu_time / t.lapAvg() << "x" << std::endl;
+
+                double mismatch = mandelbrotMismatch(cpu_values, gpu_values);
+                std::cout << "    GPU vs CPU mismatch: " << mismatch * 100.0 << "% pixels" << std::endl;
+                if (mismatch > 0.01) {
+                    throw std::runtime_error("Too many pixels differ between GPU and CPU!");
+                }
+            } else {
+                std::cout << ", speedup over brute force: " << brute_time / t.lapAvg() << "x" << std::endl;
+                double mismatch = mandelbrotMismatch(brute_values, gpu_values, 0.0f);
+                double maxMismatch = (accelerations[a] & MandelbrotBoundaryTracing) ? 0.001 : 0.0;
+                if (mismatch > 0.0) {
+                    std::cout << "    mismatch with brute force: " << mismatch * 100.0 << "% pixels" << std::endl;
+                }
+                if (mismatch > maxMismatch) {
+                    throw std::runtime_error(std::string("GPU with ") + accelerationNames[a] + " differs from brute force!");
+                }
+            }
+        }
+
+        images::Image<unsigned char> image(width, height, 3);
+        renderer.render(view, image, MandelbrotPalette);
+        image.savePNG("mandelbrot_" + names[v] + ".png");
+    }
+
+    return 0;
+}
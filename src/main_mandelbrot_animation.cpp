@@ -0,0 +1,70 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libgpu/context.h>
+#include <libimages/images.h>
+
+#include "mandelbrot_animation.h"
+
+#include <vector>
+#include <string>
+#include <iostream>
+
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    unsigned int width = 1280;
+    unsigned int height = 720;
+    unsigned int nframes = 120;
+
+    // Пролет от всего множества к долине морских коньков
+    std::vector<MandelbrotView> frames = mandelbrotFlyThrough(MandelbrotView(-0.5, 0.0, 3.0, 256),
+                                                              MandelbrotView(-0.743643887037151, 0.131825904205330, 1e-5, 2048),
+                                                              nframes);
+
+    MandelbrotAnimationRenderer animation;
+    std::cout << "Encoder threads: " << animation.encoderThreads() << ", frames in flight: " << animation.framesInFlight() << std::endl;
+
+    // первый вызов компилирует кернелы - не учитываем его во времени
+    images::Image<unsigned char> image(width, height, 3);
+    animation.renderer().render(frames[0], image);
+
+    const std::string formats[] = {"png", "jpg"};
+    for (int f = 0; f < 2; ++f) {
+        const std::string pattern = "mandelbrot_animation_%04d." + formats[f];
+        std::cout << "Fly-through " << width << "x" << height << ", " << nframes << " frames, " << formats[f] << ":" << std::endl;
+
+        // Для сравнения - как было: кадр рисуется и сохраняется в том же потоке, видеокарта ждет кодирования.
+        // Берем каждый четвертый кадр, чтобы сложность кадров была как у всего пролета
+        {
+            unsigned int syncFrames = nframes / 4;
+            double renderSeconds = 0.0;
+            timer t;
+            for (unsigned int frame = 0; frame < syncFrames; ++frame) {
+                timer render;
+                animation.renderer().render(frames[frame * 4], image);
+                renderSeconds += render.elapsed();
+                // все кадры в один файл - важно только время кодирования
+                if (f == 0) {
+                    image.savePNG("mandelbrot_animation_sync.png");
+                } else {
+                    image.saveJPEG("mandelbrot_animation_sync.jpg", 95);
+                }
+            }
+            std::cout << "    synchronous: " << syncFrames / t.elapsed() << " fps, GPU busy "
+                      << renderSeconds / t.elapsed() * 100.0 << "% of time" << std::endl;
+        }
+
+        MandelbrotAnimationStats stats = animation.render(frames, width, height, pattern);
+        std::cout << "    pipelined: " << stats.fps() << " fps (" << stats.frames << " frames in " << stats.seconds << " s), GPU busy "
+                  << stats.renderSeconds / stats.seconds * 100.0 << "% of time, waited for encoders "
+                  << stats.stallSeconds << " s" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libgpu/context.h>
+#include <libimages/images.h>
+
+#include "mandelbrot.h"
+
+#include <cmath>
+#include <string>
+#include <iostream>
+#include <stdexcept>
+
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    bool fp64 = context.cl()->deviceInfo().extensions.count("cl_khr_fp64") > 0;
+    std::cout << "Perturbation deltas are computed in " << (fp64 ? "double" : "double-float") << std::endl;
+
+    // Точка в долине морских коньков, центр задан двумя double - иначе глубже ~1e-13 не зазумить
+    const double centerX = -0.7436438870371587, centerXLo = -3.628952515063387e-17;
+    const double centerY = 0.13182590420531198, centerYLo = -1.2892807754956675e-17;
+
+    unsigned int width = 1024;
+    unsigned int height = 768;
+    // эталон на CPU считает каждый пиксель в double-double, поэтому сверяемся на картинке поменьше
+    unsigned int checkWidth = 192;
+    unsigned int checkHeight = 144;
+
+    MandelbrotRenderer renderer;
+
+    for (int zoom = 2; zoom <= 26; zoom += 4) {
+        double size = std::pow(10.0, -zoom);
+        // чем глубже, тем больше итераций нужно, чтобы различить детали
+        unsigned int iterations = 500 + 250 * zoom;
+        MandelbrotView view(centerX, centerY, size, iterations, centerXLo, centerYLo);
+        std::cout << "Size 1e-" << zoom << ", " << iterations << " iterations:" << std::endl;
+
+        renderer.setPrecision(MandelbrotPrecisionPerturbation);
+        images::Image<float> deep_values(checkWidth, checkHeight, 1);
+        renderer.render(view, deep_values);
+
+        images::Image<float> cpu_values(checkWidth, checkHeight, 1);
+        timer t;
+        renderMandelbrotDeepCPU(view, cpu_values);
+        std::cout << "    CPU double-double: " << t.elapsed() << " s for " << checkWidth << "x" << checkHeight << std::endl;
+
+        double mismatch = mandelbrotMismatch(cpu_values, deep_values);
+        std::cout << "    perturbation vs CPU double-double mismatch: " << mismatch * 100.0 << "% pixels" << std::endl;
+        if (mismatch > 0.01) {
+            throw std::runtime_error("Too many pixels differ between perturbation and CPU double-double!");
+        }
+
+        // для сравнения - что получается, если считать во float
+        renderer.setPrecision(MandelbrotPrecisionFloat);
+        images::Image<float> float_values(checkWidth, checkHeight, 1);
+        renderer.render(view, float_values);
+        std::cout << "    float vs CPU double-double mismatch: " << mandelbrotMismatch(cpu_values, float_values) * 100.0 << "% pixels" << std::endl;
+
+        renderer.setPrecision(MandelbrotPrecisionAuto);
+        std::cout << "    auto precision uses " << (renderer.usesPerturbation(view, width) ? "perturbation" : "float") << std::endl;
+
+        images::Image<unsigned char> image(width, height, 3);
+        renderer.render(view, image, MandelbrotPalette);
+        t.restart();
+        renderer.render(view, image, MandelbrotPalette);
+        std::cout << "    GPU " << width << "x" << height << ": " << t.elapsed() << " s" << std::endl;
+        image.savePNG("mandelbrot_deep_1e-" + to_string(zoom) + ".png");
+    }
+
+    return 0;
+}
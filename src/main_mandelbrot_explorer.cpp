@@ -0,0 +1,191 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libgpu/context.h>
+#include <libimages/images.h>
+
+#include "mandelbrot.h"
+
+#include <string>
+#include <iostream>
+#include <stdexcept>
+
+
+// Кадр интерактивного просмотра: один проход уточнения и показ того, что уже есть
+static void drawFrame(MandelbrotProgressiveRenderer &explorer, images::Image<unsigned char> &image)
+{
+    explorer.refine();
+    explorer.read(image);
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    unsigned int width = 1920;
+    unsigned int height = 1080;
+    const MandelbrotView start(-0.75, 0.0, 3.5, 1024);
+
+    MandelbrotProgressiveRenderer explorer;
+    MandelbrotRenderer renderer;
+    images::Image<unsigned char> image(width, height, 3);
+
+    // первый вызов компилирует кернелы - не учитываем его во времени
+    explorer.setView(start, width, height);
+    drawFrame(explorer, image);
+    renderer.render(start, image);
+
+    {
+        timer t;
+        explorer.setView(start, width, height);
+        drawFrame(explorer, image);
+        double firstFrame = t.elapsed();
+        while (!explorer.isComplete()) {
+            drawFrame(explorer, image);
+        }
+        std::cout << "Start view " << width << "x" << height << ": first frame " << firstFrame << " s, "
+                  << explorer.passesCount() << " passes " << t.elapsed() << " s" << std::endl;
+    }
+
+    // Перетаскивание мышью: каждый кадр сдвиг на несколько пикселей, на кадр один проход
+    {
+        int frames = 60;
+        double reused = 0.0;
+        timer t;
+        for (int frame = 0; frame < frames; ++frame) {
+            explorer.setView(explorer.panned(7, 3), width, height);
+            reused += explorer.reusedFraction();
+            drawFrame(explorer, image);
+            t.nextLap();
+        }
+        std::cout << "Panning: " << t.lapAvg() << "+-" << t.lapStd() << " s per frame, " << 1.0 / t.lapAvg() << " fps, "
+                  << reused / frames * 100.0 << "% pixels reused" << std::endl;
+    }
+
+    // Зум кликами: каждый клик приближает вдвое, между кликами картинка успевает досчитаться
+    {
+        int clicks = 8;
+        double reused = 0.0;
+        timer t;
+        for (int click = 0; click < clicks; ++click) {
+            explorer.setView(explorer.zoomed(width * 2 / 5, height / 3, 1), width, height);
+            reused += explorer.reusedFraction();
+            while (!explorer.isComplete()) {
+                drawFrame(explorer, image);
+                t.nextLap();
+            }
+        }
+        std::cout << "Zooming: " << t.lapAvg() << "+-" << t.lapStd() << " s per frame, " << 1.0 / t.lapAvg() << " fps, "
+                  << reused / clicks * 100.0 << "% pixels reused, " << t.elapsed() / clicks << " s per complete picture" << std::endl;
+    }
+
+    // Для сравнения - тот же вид с нуля обычным рендером
+    {
+        timer t;
+        for (int iter = 0; iter < 10; ++iter) {
+            renderer.render(explorer.view(), image);
+            t.nextLap();
+        }
+        std::cout << "Full render from scratch: " << t.lapAvg() << "+-" << t.lapStd() << " s, " << 1.0 / t.lapAvg() << " fps" << std::endl;
+    }
+
+    // После сдвигов и зумов досчитанная картинка должна совпадать с нарисованной с нуля (до округлений float на границе множества)
+    {
+        images::Image<float> explorer_values(width, height, 1);
+        explorer.read(explorer_values);
+        images::Image<float> values(width, height, 1);
+        renderer.render(explorer.view(), values);
+        double mismatch = mandelbrotMismatch(values, explorer_values);
+        std::cout << "Progressive vs full render mismatch: " << mismatch * 100.0 << "% pixels" << std::endl;
+        if (mismatch > 0.01) {
+            throw std::runtime_error("Too many pixels differ between progressive and full render!");
+        }
+    }
+
+    // Интерактивный просмотр: перетаскивание левой кнопкой двигает картинку, клик левой приближает вдвое, правой - отдаляет
+    std::cout << "Drag with the left mouse button to pan, click to zoom in, right click to zoom out" << std::endl;
+    images::ImageWindow window("Mandelbrot explorer");
+    explorer.setView(start, width, height);
+    drawFrame(explorer, image);
+    window.display(image);
+
+    bool leftPressed = false;
+    bool rightPressed = false;
+    bool dragged = false;
+    int lastX = 0;
+    int lastY = 0;
+    std::string title = "Mandelbrot explorer";
+    timer fps;
+    int frames = 0;
+    while (!window.isClosed()) {
+        if (window.isResized()) {
+            window.resize();
+            unsigned int newWidth = (unsigned int) window.width();
+            unsigned int newHeight = (unsigned int) window.height();
+            if (newWidth > 0 && newHeight > 0 && (newWidth != width || newHeight != height)) {
+                // шаг пикселя сохраняется, меняется только видимая область
+                MandelbrotView view = explorer.view();
+                view.sizeX = view.step(width) * newWidth;
+                width = newWidth;
+                height = newHeight;
+                image = images::Image<unsigned char>(width, height, 3);
+                explorer.setView(view, width, height);
+            }
+        }
+
+        mouse_click_t click = window.getMouseClick();
+        int x = window.getMouseX();
+        int y = window.getMouseY();
+        bool inside = x >= 0 && y >= 0 && x < (int) width && y < (int) height;
+
+        if (click & MOUSE_LEFT) {
+            if (!leftPressed) {
+                leftPressed = true;
+                dragged = false;
+                lastX = x;
+                lastY = y;
+            } else if (inside && (x != lastX || y != lastY)) {
+                explorer.setView(explorer.panned(lastX - x, lastY - y), width, height);
+                dragged = true;
+                lastX = x;
+                lastY = y;
+            }
+        } else if (leftPressed) {
+            leftPressed = false;
+            if (!dragged && inside) {
+                explorer.setView(explorer.zoomed(x, y, 1), width, height);
+            }
+        }
+
+        if (click & MOUSE_RIGHT) {
+            rightPressed = true;
+        } else if (rightPressed) {
+            rightPressed = false;
+            if (inside) {
+                explorer.setView(explorer.zoomed(x, y, -1), width, height);
+            }
+        }
+
+        if (explorer.isComplete()) {
+            // досчитанную картинку перерисовывать незачем - ждем событий окна
+            window.wait(10);
+            continue;
+        }
+        drawFrame(explorer, image);
+        // display возвращает окну исходный заголовок, поэтому счетчик кадров выставляется заново после каждого кадра
+        window.display(image);
+        window.setTitle(title);
+
+        ++frames;
+        if (fps.elapsed() > 1.0) {
+            title = "Mandelbrot explorer: " + to_string((int) (frames / fps.elapsed())) + " fps, size " + to_string(explorer.view().sizeX);
+            frames = 0;
+            fps.restart();
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/max_prefix_sum.h>
+
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+
+template<typename T>
+void raiseFail(const T &a, const T &b, std::string message, std::string filename, int line)
+{
+    if (a != b) {
+        std::cerr << message << " But " << a << " != " << b << ", " << filename << ":" << line << std::endl;
+        throw std::runtime_error(message);
+    }
+}
+
+#define EXPECT_THE_SAME(a, b, message) raiseFail(a, b, message, __FILE__, __LINE__)
+
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    int benchmarkingIters = 10;
+
+    unsigned int n = 100*1000*1000;
+    // значения небольшие, чтобы все префиксные суммы поместились в int
+    int values_range = 100;
+    std::vector<int> as(n, 0);
+    FastRandom r(n);
+    for (unsigned int i = 0; i < n; ++i) {
+        as[i] = r.next(-values_range, values_range);
+    }
+    std::cout << "Data generated for n=" << n << "!" << std::endl;
+
+    int reference_max_sum = 0;
+    unsigned int reference_length = 0;
+    {
+        timer t;
+        int sum = 0;
+        for (unsigned int i = 0; i < n; ++i) {
+            sum += as[i];
+            if (sum > reference_max_sum) {
+                reference_max_sum = sum;
+                reference_length = i + 1;
+            }
+        }
+        std::cout << "CPU: " << (n/1000.0/1000.0) / t.elapsed() << " millions/s" << std::endl;
+    }
+
+    gpu::gpu_mem_32i as_gpu;
+    as_gpu.resizeN(n);
+    as_gpu.writeN(as.data(), n);
+
+    gpu::MaxPrefixSumAlgorithm algorithms[] = {gpu::MaxPrefixSumSinglePass, gpu::MaxPrefixSumTwoPass};
+    const char *names[] = {"single pass", "two passes"};
+    for (int k = 0; k < 2; ++k) {
+        unsigned int length = 0;
+        // первый вызов компилирует кернелы - не учитываем его во времени
+        int max_sum = gpu::maxPrefixSum(as_gpu, &length, algorithms[k]);
+        EXPECT_THE_SAME(reference_max_sum, max_sum, std::string("GPU ") + names[k] + " max sum should be consistent with CPU!");
+        EXPECT_THE_SAME(reference_length, length, std::string("GPU ") + names[k] + " prefix length should be consistent with CPU!");
+
+        timer t;
+        for (int iter = 0; iter < benchmarkingIters; ++iter) {
+            max_sum = gpu::maxPrefixSum(as_gpu, &length, algorithms[k]);
+            EXPECT_THE_SAME(reference_max_sum, max_sum, std::string("GPU ") + names[k] + " max sum should be consistent with CPU!");
+            t.nextLap();
+        }
+        std::cout << "GPU " << names[k] << ": " << t.lapAvg() << "+-" << t.lapStd() << " s" << std::endl;
+        std::cout << "GPU " << names[k] << ": " << (n/1000.0/1000.0) / t.lapAvg() << " millions/s" << std::endl;
+        // вход читается ровно один раз
+        std::cout << "GPU " << names[k] << ": " << 1.0 * n * sizeof(int) / t.lapAvg() / 1024 / 1024 / 1024 << " GB/s" << std::endl;
+    }
+
+    std::cout << "Max prefix sum: " << reference_max_sum << ", prefix length: " << reference_length << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/multi_device_executor.h>
+
+// Этот файл будет сгенерирован автоматически в момент сборки - см. convertIntoHeader в CMakeLists.txt
+#include "cl/multi_device_cl.h"
+
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+
+int main()
+{
+    // Используем сразу все OpenCL устройства - например CPU OpenCL runtime и видеокарту
+    gpu::MultiDeviceExecutor executor;
+    for (size_t d = 0; d < executor.devicesCount(); ++d) {
+        gpu::Device device = executor.device(d);
+        std::cout << "  Device #" << d << ": ";
+        gpu::printDeviceInfo(device);
+    }
+
+    unsigned int n = 32*1024*1024;
+    unsigned int iters = 256;
+    std::vector<float> xs(n, 0);
+    std::vector<float> ys(n, 0);
+    FastRandom r(n);
+    for (unsigned int i = 0; i < n; ++i) {
+        xs[i] = r.nextf();
+    }
+
+    // Кернел один на всех, но скомпилирован он будет для каждого устройства в его собственном контексте
+    ocl::Kernel iterate(multi_device_kernel, multi_device_kernel_length, "iterate");
+
+    // Буферы у каждого устройства свои - их размер меняется вместе с долей работы устройства
+    std::vector<gpu::gpu_mem_32f> xs_gpu(executor.devicesCount());
+    std::vector<gpu::gpu_mem_32f> ys_gpu(executor.devicesCount());
+    executor.runOnEach([&](size_t) {
+        iterate.compile();
+    });
+
+    unsigned int workGroupSize = 128;
+    int benchmarkingIters = 10;
+    for (int iter = 0; iter < benchmarkingIters; ++iter) {
+        timer t;
+        executor.run(n, workGroupSize, [&](size_t device, size_t offset, size_t count) {
+            xs_gpu[device].growN(count);
+            ys_gpu[device].growN(count);
+            xs_gpu[device].writeN(xs.data() + offset, count);
+            iterate.exec(gpu::WorkSize(workGroupSize, count), xs_gpu[device], ys_gpu[device], (unsigned int) count, iters);
+            // Каждое устройство само кладет свою часть результата на место - так результаты и объединяются
+            ys_gpu[device].readN(ys.data() + offset, count);
+        });
+        t.stop();
+
+        std::cout << "Iteration #" << iter << ": " << t.elapsed() << " s, shares:";
+        for (size_t d = 0; d < executor.devicesCount(); ++d) {
+            std::cout << " " << executor.share(d);
+        }
+        std::cout << std::endl;
+    }
+
+    // Проверяем корректность результатов
+    for (unsigned int i = 0; i < n; i += 997) {
+        float y = 0.0f;
+        for (unsigned int k = 0; k < iters; ++k) {
+            y = y * 0.5f + xs[i];
+        }
+        if (std::fabs(y - ys[i]) > 1e-3f * std::fabs(y) + 1e-6f) {
+            throw std::runtime_error("Multi-device results should be equal to CPU results!");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/radix_sort.h>
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+
+// Сортирует ключи на CPU (std::sort) и на видеокарте, сверяет результат и печатает скорость
+template <typename K>
+void benchmarkKeys(const std::string &name, const std::vector<K> &keys, unsigned int bitsPerPass, int benchmarkingIters)
+{
+    const size_t n = keys.size();
+    std::cout << name << ", " << bitsPerPass << " bits per pass:" << std::endl;
+
+    std::vector<K> reference = keys;
+    {
+        timer t;
+        std::sort(reference.begin(), reference.end());
+        std::cout << "    CPU std::sort: " << (n/1000.0/1000.0) / t.elapsed() << " millions/s" << std::endl;
+    }
+
+    gpu::gpu_mem<K> keys_gpu;
+    keys_gpu.resizeN(n);
+
+    // первый вызов компилирует кернелы - не учитываем его во времени
+    keys_gpu.writeN(keys.data(), n);
+    gpu::radixSort(keys_gpu, n, bitsPerPass);
+
+    timer t;
+    for (int iter = 0; iter < benchmarkingIters; ++iter) {
+        // сортировка на месте, поэтому перед каждым запуском возвращаем неотсортированные ключи
+        keys_gpu.writeN(keys.data(), n);
+        t.restart();
+        gpu::radixSort(keys_gpu, n, bitsPerPass);
+        t.nextLap();
+    }
+    std::cout << "    GPU: " << t.lapAvg() << "+-" << t.lapStd() << " s, " << (n/1000.0/1000.0) / t.lapAvg() << " millions/s" << std::endl;
+
+    std::vector<K> result(n);
+    keys_gpu.readN(result.data(), n);
+    for (size_t i = 0; i < n; ++i) {
+        if (result[i] != reference[i]) {
+            throw std::runtime_error(name + ": GPU radix sort differs from std::sort at " + to_string(i) + "!");
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    int benchmarkingIters = 10;
+
+    unsigned int n = 32*1024*1024 + 123;
+    FastRandom r(n);
+
+    std::vector<unsigned int> uints(n);
+    std::vector<int> ints(n);
+    std::vector<float> floats(n);
+    for (unsigned int i = 0; i < n; ++i) {
+        // FastRandom дает 31 случайный бит, для полного диапазона склеиваем два числа
+        uints[i] = ((unsigned int) r.next() << 16) ^ (unsigned int) r.next();
+        ints[i] = (int) (((unsigned int) r.next() << 16) ^ (unsigned int) r.next());
+        floats[i] = r.nextf();
+    }
+
+    // Подбор числа бит на проход: больше бит - меньше проходов, но больше гистограммы и дольше локальная сортировка блока
+    for (unsigned int bits = 2; bits <= 8; bits += 2) {
+        benchmarkKeys("uint32", uints, bits, benchmarkingIters);
+    }
+    benchmarkKeys("int32", ints, 4, benchmarkingIters);
+    benchmarkKeys("float", floats, 4, benchmarkingIters);
+
+    std::vector<uint64_t> ulongs(n / 2);
+    std::vector<double> doubles(n / 2);
+    for (unsigned int i = 0; i < n / 2; ++i) {
+        ulongs[i] = ((uint64_t) r.next() << 40) ^ ((uint64_t) r.next() << 20) ^ (uint64_t) r.next();
+        doubles[i] = (double) r.nextf() * r.nextf();
+    }
+    benchmarkKeys("uint64", ulongs, 4, benchmarkingIters);
+    benchmarkKeys("double", doubles, 4, benchmarkingIters);
+
+    // Ключ-значение: много одинаковых ключей, значения - исходные индексы. Сортировка устойчивая,
+    // поэтому результат обязан совпасть с std::stable_sort до значений
+    {
+        std::vector<unsigned int> keys(n);
+        std::vector<unsigned int> values(n);
+        std::vector<std::pair<unsigned int, unsigned int> > reference(n);
+        for (unsigned int i = 0; i < n; ++i) {
+            keys[i] = (unsigned int) r.next(0, 1000);
+            values[i] = i;
+            reference[i] = std::make_pair(keys[i], i);
+        }
+        std::stable_sort(reference.begin(), reference.end(),
+                         [](const std::pair<unsigned int, unsigned int> &a, const std::pair<unsigned int, unsigned int> &b) { return a.first < b.first; });
+
+        gpu::gpu_mem_32u keys_gpu, values_gpu;
+        keys_gpu.resizeN(n);
+        values_gpu.resizeN(n);
+        keys_gpu.writeN(keys.data(), n);
+        values_gpu.writeN(values.data(), n);
+        gpu::radixSort(keys_gpu, values_gpu);
+
+        timer t;
+        for (int iter = 0; iter < benchmarkingIters; ++iter) {
+            keys_gpu.writeN(keys.data(), n);
+            values_gpu.writeN(values.data(), n);
+            t.restart();
+            gpu::radixSort(keys_gpu, values_gpu);
+            t.nextLap();
+        }
+        std::cout << "uint32 -> uint32 key-value:" << std::endl;
+        std::cout << "    GPU: " << t.lapAvg() << "+-" << t.lapStd() << " s, " << (n/1000.0/1000.0) / t.lapAvg() << " millions/s" << std::endl;
+
+        keys_gpu.readN(keys.data(), n);
+        values_gpu.readN(values.data(), n);
+        for (unsigned int i = 0; i < n; ++i) {
+            if (keys[i] != reference[i].first || values[i] != reference[i].second) {
+                throw std::runtime_error("GPU key-value radix sort differs from std::stable_sort at " + to_string(i) + "!");
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/reduce.h>
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+
+template<typename T>
+void raiseFail(const T &a, const T &b, std::string message, std::string filename, int line)
+{
+    if (a != b) {
+        std::cerr << message << " But " << a << " != " << b << ", " << filename << ":" << line << std::endl;
+        throw std::runtime_error(message);
+    }
+}
+
+#define EXPECT_THE_SAME(a, b, message) raiseFail(a, b, message, __FILE__, __LINE__)
+
+
+int main(int argc, char **argv)
+{
+    int benchmarkingIters = 10;
+
+    unsigned int n = 100*1000*1000;
+    std::vector<unsigned int> as(n, 0);
+    std::vector<float> fs(n, 0);
+    FastRandom r(42);
+    for (unsigned int i = 0; i < n; ++i) {
+        as[i] = (unsigned int) r.next(0, std::numeric_limits<int>::max() / n);
+        fs[i] = r.nextf();
+    }
+    std::cout << "Data generated for n=" << n << "!" << std::endl;
+
+    unsigned int reference_sum = 0;
+    size_t reference_argmin = 0;
+    size_t reference_argmax = 0;
+    for (unsigned int i = 0; i < n; ++i) {
+        reference_sum += as[i];
+        if (fs[i] < fs[reference_argmin])
+            reference_argmin = i;
+        if (fs[i] > fs[reference_argmax])
+            reference_argmax = i;
+    }
+
+    // 64-битные значения не помещаются в 32 бита - проверяем что сумма и минимум считаются в полной разрядности
+    unsigned int n64 = n / 10;
+    std::vector<uint64_t> ls(n64);
+    std::vector<int64_t> ss(n64);
+    uint64_t reference_sum64 = 0;
+    int64_t reference_min64 = 0;
+    for (unsigned int i = 0; i < n64; ++i) {
+        ls[i] = ((uint64_t) as[i] << 32) + i;
+        ss[i] = -((int64_t) as[i] << 32) + i;
+        reference_sum64 += ls[i];
+        reference_min64 = (i == 0) ? ss[i] : std::min(reference_min64, ss[i]);
+    }
+
+    {
+        timer t;
+        for (int iter = 0; iter < benchmarkingIters; ++iter) {
+            unsigned int sum = 0;
+            // OpenMP раскидывает цикл по всем ядрам процессора, каждое ядро суммирует свою часть
+            #pragma omp parallel for reduction(+:sum)
+            for (int i = 0; i < (int) n; ++i) {
+                sum += as[i];
+            }
+            EXPECT_THE_SAME(reference_sum, sum, "CPU OpenMP result should be consistent!");
+            t.nextLap();
+        }
+        std::cout << "CPU OMP: " << t.lapAvg() << "+-" << t.lapStd() << " s" << std::endl;
+        std::cout << "CPU OMP: " << (n/1000.0/1000.0) / t.lapAvg() << " millions/s" << std::endl;
+    }
+
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    gpu::gpu_mem_32u as_gpu;
+    gpu::gpu_mem_32f fs_gpu;
+    as_gpu.resizeN(n);
+    fs_gpu.resizeN(n);
+    as_gpu.writeN(as.data(), n);
+    fs_gpu.writeN(fs.data(), n);
+
+    {
+        // первый вызов компилирует кернелы - не учитываем его во времени
+        gpu::reduce(as_gpu, gpu::ReduceSum);
+
+        timer t;
+        for (int iter = 0; iter < benchmarkingIters; ++iter) {
+            unsigned int sum = gpu::reduce(as_gpu, gpu::ReduceSum);
+            EXPECT_THE_SAME(reference_sum, sum, "GPU result should be consistent!");
+            t.nextLap();
+        }
+        std::cout << "GPU sum: " << t.lapAvg() << "+-" << t.lapStd() << " s" << std::endl;
+        std::cout << "GPU sum: " << (n/1000.0/1000.0) / t.lapAvg() << " millions/s" << std::endl;
+    }
+
+    {
+        size_t argmax = 0;
+        float max = gpu::reduce(fs_gpu, gpu::ReduceArgMax, &argmax);
+        EXPECT_THE_SAME(reference_argmax, argmax, "GPU argmax should be consistent!");
+        EXPECT_THE_SAME(fs[reference_argmax], max, "GPU max should be consistent!");
+        EXPECT_THE_SAME(fs[reference_argmax], gpu::reduce(fs_gpu, gpu::ReduceMax), "GPU max should be consistent!");
+
+        size_t argmin = 0;
+        float min = gpu::reduce(fs_gpu, gpu::ReduceArgMin, &argmin);
+        EXPECT_THE_SAME(reference_argmin, argmin, "GPU argmin should be consistent!");
+        EXPECT_THE_SAME(fs[reference_argmin], min, "GPU min should be consistent!");
+        EXPECT_THE_SAME(fs[reference_argmin], gpu::reduce(fs_gpu, gpu::ReduceMin), "GPU min should be consistent!");
+    }
+
+    {
+        gpu::gpu_mem_64u ls_gpu;
+        gpu::gpu_mem_64i ss_gpu;
+        ls_gpu.resizeN(n64);
+        ss_gpu.resizeN(n64);
+        ls_gpu.writeN(ls.data(), n64);
+        ss_gpu.writeN(ss.data(), n64);
+        EXPECT_THE_SAME(reference_sum64, gpu::reduce(ls_gpu, gpu::ReduceSum), "GPU 64-bit sum should be consistent!");
+        EXPECT_THE_SAME(reference_min64, gpu::reduce(ss_gpu, gpu::ReduceMin), "GPU 64-bit min should be consistent!");
+    }
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/scan.h>
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+
+// Проверяет обе версии скана на первых n из n + 1 значений (последнее не должно попасть в суммы),
+// inPlace - результат записывается в тот же буфер что и значения
+template <typename T>
+void checkScan(unsigned int n, bool inPlace, const std::string &name)
+{
+    std::vector<T> values(n + 1);
+    FastRandom r(n);
+    for (unsigned int i = 0; i <= n; ++i) {
+        values[i] = (T) r.next(0, 16);
+    }
+
+    gpu::shared_device_buffer_typed<T> values_gpu, result_gpu;
+    values_gpu.resizeN(n + 1);
+    std::vector<T> result(n + 1);
+    for (int exclusive = 0; exclusive < 2; ++exclusive) {
+        values_gpu.writeN(values.data(), n + 1);
+        gpu::shared_device_buffer_typed<T> &dst = inPlace ? values_gpu : result_gpu;
+        if (exclusive) {
+            gpu::exclusiveScan(values_gpu, dst, n);
+        } else {
+            gpu::inclusiveScan(values_gpu, dst, n);
+        }
+        if (n == 0) {
+            // ничего не считается и результат не трогается
+            if (!inPlace && result_gpu.number() != 0) {
+                throw std::runtime_error(name + ": result of empty scan was resized!");
+            }
+            continue;
+        }
+        dst.readN(result.data(), inPlace ? n + 1 : n);
+        if (inPlace && result[n] != values[n]) {
+            throw std::runtime_error(name + ": scan of " + to_string(n) + " values changed the value after them!");
+        }
+
+        T sum = 0;
+        for (unsigned int i = 0; i < n; ++i) {
+            T expected = exclusive ? sum : (T) (sum + values[i]);
+            if (result[i] != expected) {
+                throw std::runtime_error(name + (exclusive ? ": exclusive" : ": inclusive") + " scan of " + to_string(n)
+                                         + " values differs from CPU at " + to_string(i) + "!");
+            }
+            sum += values[i];
+        }
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    int benchmarkingIters = 10;
+
+    unsigned int n = 64*1024*1024 + 123;
+    std::vector<unsigned int> as(n, 0);
+    FastRandom r(n);
+    for (unsigned int i = 0; i < n; ++i) {
+        as[i] = (unsigned int) r.next(0, 16);
+    }
+
+    std::vector<unsigned int> reference(n, 0);
+    {
+        timer t;
+        unsigned int sum = 0;
+        for (unsigned int i = 0; i < n; ++i) {
+            sum += as[i];
+            reference[i] = sum;
+        }
+        std::cout << "CPU: " << (n/1000.0/1000.0) / t.elapsed() << " millions/s" << std::endl;
+    }
+
+    gpu::gpu_mem_32u as_gpu, result_gpu;
+    as_gpu.resizeN(n);
+    as_gpu.writeN(as.data(), n);
+
+    // первый вызов компилирует кернелы - не учитываем его во времени
+    gpu::inclusiveScan(as_gpu, result_gpu);
+
+    timer t;
+    for (int iter = 0; iter < benchmarkingIters; ++iter) {
+        gpu::inclusiveScan(as_gpu, result_gpu);
+        t.nextLap();
+    }
+    std::cout << "GPU: " << t.lapAvg() << "+-" << t.lapStd() << " s" << std::endl;
+    std::cout << "GPU: " << (n/1000.0/1000.0) / t.lapAvg() << " millions/s" << std::endl;
+    // минимально необходимый трафик - прочитать вход и записать результат
+    std::cout << "GPU: " << 2.0 * n * sizeof(unsigned int) / t.lapAvg() / 1024 / 1024 / 1024 << " GB/s" << std::endl;
+
+    std::vector<unsigned int> result(n, 0);
+    result_gpu.readN(result.data(), n);
+    for (unsigned int i = 0; i < n; ++i) {
+        if (result[i] != reference[i]) {
+            throw std::runtime_error("GPU inclusive scan differs from CPU at " + to_string(i) + "!");
+        }
+    }
+
+    gpu::exclusiveScan(as_gpu, result_gpu);
+    result_gpu.readN(result.data(), n);
+    for (unsigned int i = 0; i < n; ++i) {
+        if (result[i] != reference[i] - as[i]) {
+            throw std::runtime_error("GPU exclusive scan differs from CPU at " + to_string(i) + "!");
+        }
+    }
+
+    // Граничные размеры, размеры не кратные блокам и скан на месте
+    unsigned int sizes[] = {0, 1, 2, 255, 1000, 1025, 1024 * 1024 + 1, 3000017};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        checkScan<unsigned int>(sizes[i], false, "uint32");
+        checkScan<unsigned int>(sizes[i], true, "uint32 in place");
+        checkScan<int64_t>(sizes[i], true, "int64 in place");
+    }
+    checkScan<float>(1000, true, "float in place");
+
+    std::cout << "Scan results are correct" << std::endl;
+
+    return 0;
+}
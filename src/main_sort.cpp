@@ -0,0 +1,221 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/radix_sort.h>
+#include <libgpu/sort.h>
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+
+// Частица с составным ключом: сортируем по ячейке, внутри ячейки - по номеру.
+// Объявление для кернелов должно совпадать с раскладкой структуры на хосте
+struct Particle {
+    unsigned int cell;
+    unsigned int id;
+    float mass;
+};
+
+static const char *particle_declaration = "typedef struct { unsigned int cell; unsigned int id; float mass; } Particle;";
+
+bool particleLess(const Particle &a, const Particle &b)
+{
+    return a.cell < b.cell || (a.cell == b.cell && a.id < b.id);
+}
+
+template <typename T>
+void checkEqual(const std::vector<T> &result, const std::vector<T> &reference, const std::string &name)
+{
+    for (size_t i = 0; i < reference.size(); ++i) {
+        if (result[i] != reference[i]) {
+            throw std::runtime_error(name + " differs from std::sort at " + to_string(i) + "!");
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    int benchmarkingIters = 10;
+    FastRandom r(239);
+
+    // Маленький массив: bitonicSort - один запуск кернела, radixSort - по три запуска на каждый проход
+    {
+        unsigned int n = (unsigned int) gpu::bitonicSortMaxSize(gpu::ascendingOrder<float>());
+        std::vector<float> values(n);
+        for (unsigned int i = 0; i < n; ++i) {
+            values[i] = r.nextf();
+        }
+        std::vector<float> reference = values;
+        std::sort(reference.begin(), reference.end());
+
+        gpu::gpu_mem_32f values_gpu;
+        values_gpu.resizeN(n);
+        std::cout << n << " floats:" << std::endl;
+
+        for (int algorithm = 0; algorithm < 2; ++algorithm) {
+            timer t;
+            // первая итерация компилирует кернелы - не учитываем ее во времени
+            for (int iter = 0; iter <= benchmarkingIters * 10; ++iter) {
+                values_gpu.writeN(values.data(), n);
+                t.restart();
+                if (algorithm == 0) {
+                    gpu::bitonicSort(values_gpu);
+                } else {
+                    gpu::radixSort(values_gpu);
+                }
+                if (iter > 0) {
+                    t.nextLap();
+                }
+            }
+            std::vector<float> result(n);
+            values_gpu.readN(result.data(), n);
+            checkEqual(result, reference, algorithm == 0 ? "bitonicSort" : "radixSort");
+            std::cout << "    " << (algorithm == 0 ? "bitonicSort: " : "radixSort:   ") << t.lapAvg() * 1000 * 1000 << " us" << std::endl;
+        }
+    }
+
+    // Большой массив: сортировка слиянием против поразрядной
+    {
+        unsigned int n = 4*1024*1024 + 17;
+        std::vector<float> values(n);
+        for (unsigned int i = 0; i < n; ++i) {
+            values[i] = r.nextf();
+        }
+        std::vector<float> reference = values;
+        {
+            timer t;
+            std::sort(reference.begin(), reference.end());
+            std::cout << n << " floats:" << std::endl;
+            std::cout << "    CPU std::sort: " << (n/1000.0/1000.0) / t.elapsed() << " millions/s" << std::endl;
+        }
+
+        gpu::gpu_mem_32f values_gpu;
+        values_gpu.resizeN(n);
+        for (int algorithm = 0; algorithm < 2; ++algorithm) {
+            timer t;
+            for (int iter = 0; iter <= benchmarkingIters; ++iter) {
+                values_gpu.writeN(values.data(), n);
+                t.restart();
+                if (algorithm == 0) {
+                    gpu::mergeSort(values_gpu);
+                } else {
+                    gpu::radixSort(values_gpu);
+                }
+                if (iter > 0) {
+                    t.nextLap();
+                }
+            }
+            std::vector<float> result(n);
+            values_gpu.readN(result.data(), n);
+            checkEqual(result, reference, algorithm == 0 ? "mergeSort" : "radixSort");
+            std::cout << "    GPU " << (algorithm == 0 ? "mergeSort: " : "radixSort: ") << (n/1000.0/1000.0) / t.lapAvg() << " millions/s" << std::endl;
+        }
+    }
+
+    // Почти отсортированный массив: к отсортированному массиву добавилась отсортированная пачка.
+    // Слияние за один проход вместо полной пересортировки
+    {
+        unsigned int n = 16*1024*1024;
+        unsigned int batch = 1024*1024;
+        std::vector<float> values(n);
+        std::vector<float> batch_values(batch);
+        for (unsigned int i = 0; i < n; ++i) {
+            values[i] = r.nextf();
+        }
+        for (unsigned int i = 0; i < batch; ++i) {
+            batch_values[i] = r.nextf();
+        }
+        std::sort(values.begin(), values.end());
+        std::sort(batch_values.begin(), batch_values.end());
+        std::vector<float> reference(n + batch);
+        std::merge(values.begin(), values.end(), batch_values.begin(), batch_values.end(), reference.begin());
+
+        gpu::gpu_mem_32f values_gpu, batch_gpu, merged_gpu;
+        values_gpu.resizeN(n);
+        batch_gpu.resizeN(batch);
+        merged_gpu.resizeN(n + batch);
+        values_gpu.writeN(values.data(), n);
+        batch_gpu.writeN(batch_values.data(), batch);
+
+        std::cout << n << " sorted floats + " << batch << " sorted floats:" << std::endl;
+        timer t;
+        for (int iter = 0; iter <= benchmarkingIters; ++iter) {
+            t.restart();
+            gpu::merge(values_gpu, batch_gpu, merged_gpu);
+            if (iter > 0) {
+                t.nextLap();
+            }
+        }
+        std::vector<float> result(n + batch);
+        merged_gpu.readN(result.data(), n + batch);
+        checkEqual(result, reference, "merge");
+        std::cout << "    GPU merge: " << ((n + batch)/1000.0/1000.0) / t.lapAvg() << " millions/s" << std::endl;
+
+        std::vector<float> concatenation = values;
+        concatenation.insert(concatenation.end(), batch_values.begin(), batch_values.end());
+        timer t_radix;
+        for (int iter = 0; iter <= benchmarkingIters; ++iter) {
+            merged_gpu.writeN(concatenation.data(), n + batch);
+            t_radix.restart();
+            gpu::radixSort(merged_gpu);
+            if (iter > 0) {
+                t_radix.nextLap();
+            }
+        }
+        merged_gpu.readN(result.data(), n + batch);
+        checkEqual(result, reference, "radixSort");
+        std::cout << "    GPU radixSort of concatenation: " << ((n + batch)/1000.0/1000.0) / t_radix.lapAvg() << " millions/s" << std::endl;
+    }
+
+    // Структуры с составным ключом и пользовательским компаратором
+    {
+        unsigned int n = 4*1024*1024;
+        std::vector<Particle> particles(n);
+        for (unsigned int i = 0; i < n; ++i) {
+            particles[i].cell = (unsigned int) r.next(0, 4095);
+            particles[i].id = (unsigned int) r.next();
+            particles[i].mass = r.nextf();
+        }
+        std::vector<Particle> reference = particles;
+        {
+            timer t;
+            std::sort(reference.begin(), reference.end(), particleLess);
+            std::cout << n << " particles by (cell, id):" << std::endl;
+            std::cout << "    CPU std::sort: " << (n/1000.0/1000.0) / t.elapsed() << " millions/s" << std::endl;
+        }
+
+        gpu::SortComparator byCellAndId("Particle", sizeof(Particle), "a.cell < b.cell || (a.cell == b.cell && a.id < b.id)", particle_declaration);
+        gpu::gpu_mem_any particles_gpu = gpu::gpu_mem_any::create(n * sizeof(Particle));
+        timer t;
+        for (int iter = 0; iter <= benchmarkingIters; ++iter) {
+            particles_gpu.write(particles.data(), n * sizeof(Particle));
+            t.restart();
+            gpu::mergeSort(particles_gpu, n, byCellAndId);
+            if (iter > 0) {
+                t.nextLap();
+            }
+        }
+        std::cout << "    GPU mergeSort: " << (n/1000.0/1000.0) / t.lapAvg() << " millions/s" << std::endl;
+
+        std::vector<Particle> result(n);
+        particles_gpu.read(result.data(), n * sizeof(Particle));
+        for (unsigned int i = 0; i < n; ++i) {
+            if (result[i].cell != reference[i].cell || result[i].id != reference[i].id) {
+                throw std::runtime_error("mergeSort of particles differs from std::sort at " + to_string(i) + "!");
+            }
+        }
+    }
+
+    return 0;
+}
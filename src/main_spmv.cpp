@@ -0,0 +1,169 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/csr_matrix.h>
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+
+// Разреженная матрица в формате CSR на хосте
+struct HostCsrMatrix {
+    unsigned int nrows;
+    unsigned int ncolumns;
+    std::vector<unsigned int> row_offsets;
+    std::vector<unsigned int> column_indices;
+    std::vector<float> values;
+
+    HostCsrMatrix(unsigned int nrows, unsigned int ncolumns) : nrows(nrows), ncolumns(ncolumns), row_offsets(1, 0) {}
+
+    void add(unsigned int column, float value)
+    {
+        column_indices.push_back(column);
+        values.push_back(value);
+    }
+
+    void endRow()
+    {
+        row_offsets.push_back((unsigned int) values.size());
+    }
+};
+
+// Оператор Лапласа на сетке size x size (пятиточечный шаблон) - типичная матрица солвера: все строки почти одинаковой длины
+HostCsrMatrix laplacian2D(unsigned int size)
+{
+    HostCsrMatrix a(size * size, size * size);
+    for (unsigned int y = 0; y < size; ++y) {
+        for (unsigned int x = 0; x < size; ++x) {
+            unsigned int i = y * size + x;
+            if (y > 0)          a.add(i - size, -1.0f);
+            if (x > 0)          a.add(i - 1, -1.0f);
+            a.add(i, 4.0f);
+            if (x + 1 < size)   a.add(i + 1, -1.0f);
+            if (y + 1 < size)   a.add(i + size, -1.0f);
+            a.endRow();
+        }
+    }
+    return a;
+}
+
+// Граф со степенным распределением степеней вершин: большинство строк короткие, но есть строки в сотни тысяч элементов
+HostCsrMatrix powerLawGraph(unsigned int nvertices, FastRandom &r)
+{
+    HostCsrMatrix a(nvertices, nvertices);
+    for (unsigned int i = 0; i < nvertices; ++i) {
+        double u = (r.next(1, 1000*1000) / 1000000.0);
+        unsigned int degree = (unsigned int) std::min(1.0 / std::pow(u, 1.2), 100000.0);
+        for (unsigned int k = 0; k < degree; ++k) {
+            a.add((unsigned int) r.next(0, nvertices - 1), r.nextf() / 1000.0f);
+        }
+        a.endRow();
+    }
+    return a;
+}
+
+// Строки случайной длины от minLength до maxLength
+HostCsrMatrix randomRows(unsigned int nrows, unsigned int ncolumns, unsigned int minLength, unsigned int maxLength, FastRandom &r)
+{
+    HostCsrMatrix a(nrows, ncolumns);
+    for (unsigned int i = 0; i < nrows; ++i) {
+        unsigned int length = (unsigned int) r.next(minLength, maxLength);
+        for (unsigned int k = 0; k < length; ++k) {
+            a.add((unsigned int) r.next(0, ncolumns - 1), r.nextf() / 1000.0f);
+        }
+        a.endRow();
+    }
+    return a;
+}
+
+void benchmarkSpmv(const std::string &name, const HostCsrMatrix &a, int benchmarkingIters)
+{
+    size_t nnz = a.values.size();
+    FastRandom r(a.nrows);
+    std::vector<float> x(a.ncolumns);
+    for (unsigned int j = 0; j < a.ncolumns; ++j) {
+        x[j] = r.nextf() / 1000.0f;
+    }
+
+    // эталон на CPU, заодно сумма модулей слагаемых строки - масштаб допустимой ошибки округления
+    std::vector<float> reference(a.nrows);
+    std::vector<double> magnitudes(a.nrows);
+    timer t_cpu;
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (ptrdiff_t i = 0; i < (ptrdiff_t) a.nrows; ++i) {
+        double sum = 0.0;
+        double magnitude = 0.0;
+        for (unsigned int j = a.row_offsets[i]; j < a.row_offsets[i + 1]; ++j) {
+            double product = (double) a.values[j] * x[a.column_indices[j]];
+            sum += product;
+            magnitude += std::abs(product);
+        }
+        reference[i] = (float) sum;
+        magnitudes[i] = magnitude;
+    }
+    double cpu_time = t_cpu.elapsed();
+
+    gpu::gpu_mem_32u row_offsets_gpu, column_indices_gpu;
+    gpu::gpu_mem_32f values_gpu, x_gpu, y_gpu;
+    row_offsets_gpu.resizeN(a.nrows + 1);
+    row_offsets_gpu.writeN(a.row_offsets.data(), a.nrows + 1);
+    column_indices_gpu.resizeN(nnz);
+    column_indices_gpu.writeN(a.column_indices.data(), nnz);
+    values_gpu.resizeN(nnz);
+    values_gpu.writeN(a.values.data(), nnz);
+    x_gpu.resizeN(a.ncolumns);
+    x_gpu.writeN(x.data(), a.ncolumns);
+
+    gpu::CsrMatrix<float> matrix(a.nrows, a.ncolumns, row_offsets_gpu, column_indices_gpu, values_gpu);
+    double gigabytes = matrix.effectiveBytes() / 1024.0 / 1024.0 / 1024.0;
+
+    std::cout << name << ": " << a.nrows << " rows, " << nnz << " values, auto algorithm is " << gpu::spmvAlgorithmName(matrix.autoAlgorithm()) << std::endl;
+    std::cout << "    CPU: " << cpu_time * 1000 << " ms, " << gigabytes / cpu_time << " GB/s" << std::endl;
+
+    const gpu::SpmvAlgorithm algorithms[] = {gpu::SpmvAlgorithm::Scalar, gpu::SpmvAlgorithm::Vector, gpu::SpmvAlgorithm::Binned,
+                                             gpu::SpmvAlgorithm::Merge, gpu::SpmvAlgorithm::Auto};
+    for (gpu::SpmvAlgorithm algorithm : algorithms) {
+        // первый вызов компилирует кернелы - не учитываем его во времени
+        matrix.multiply(x_gpu, y_gpu, algorithm);
+        timer t;
+        for (int iter = 0; iter < benchmarkingIters; ++iter) {
+            matrix.multiply(x_gpu, y_gpu, algorithm);
+            t.nextLap();
+        }
+        std::cout << "    GPU " << gpu::spmvAlgorithmName(algorithm) << ": " << t.lapAvg() * 1000 << "+-" << t.lapStd() * 1000 << " ms, "
+                  << gigabytes / t.lapAvg() << " GB/s" << std::endl;
+
+        std::vector<float> y(a.nrows);
+        y_gpu.readN(y.data(), a.nrows);
+        for (unsigned int i = 0; i < a.nrows; ++i) {
+            if (std::abs(y[i] - reference[i]) > 1e-3 * magnitudes[i] + 1e-30) {
+                throw std::runtime_error(name + ", " + gpu::spmvAlgorithmName(algorithm) + ": row " + to_string(i) + " is " + to_string(y[i])
+                                         + " instead of " + to_string(reference[i]) + "!");
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    int benchmarkingIters = 10;
+    FastRandom r;
+
+    benchmarkSpmv("Laplacian 2048x2048", laplacian2D(2048), benchmarkingIters);
+    benchmarkSpmv("Random rows of 20-80 values", randomRows(1000*1000, 1000*1000, 20, 80, r), benchmarkingIters);
+    benchmarkSpmv("Power-law graph", powerLawGraph(1000*1000, r), benchmarkingIters);
+
+    return 0;
+}
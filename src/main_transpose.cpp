@@ -0,0 +1,124 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/transpose.h>
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <stdexcept>
+#include <functional>
+
+
+int benchmarkingIters = 10;
+
+// Пропускная способность: каждый байт один раз читается и один раз пишется
+double benchmarkBandwidth(const std::string &name, size_t bytes, const std::function<void()> &run)
+{
+    // первый вызов компилирует кернелы - не учитываем его во времени
+    run();
+    timer t;
+    for (int iter = 0; iter < benchmarkingIters; ++iter) {
+        run();
+        t.nextLap();
+    }
+    double bandwidth = (2.0 * bytes / 1024.0 / 1024.0 / 1024.0) / t.lapAvg();
+    std::cout << "    " << name << ": " << t.lapAvg() * 1000 << "+-" << t.lapStd() * 1000 << " ms, " << bandwidth << " GB/s" << std::endl;
+    return bandwidth;
+}
+
+template <typename T>
+void checkTransposed(const std::vector<T> &src, const gpu::shared_device_buffer_typed<T> &dst_gpu,
+                     size_t rows, size_t columns, size_t batch, const std::string &name)
+{
+    std::vector<T> dst(src.size());
+    dst_gpu.readN(dst.data(), dst.size());
+    for (size_t b = 0; b < batch; ++b) {
+        const T *a = src.data() + b * rows * columns;
+        const T *at = dst.data() + b * rows * columns;
+        for (size_t i = 0; i < rows; ++i) {
+            for (size_t j = 0; j < columns; ++j) {
+                if (at[j * rows + i] != a[i * columns + j]) {
+                    throw std::runtime_error(name + ": element (" + to_string(i) + ", " + to_string(j) + ") of matrix " + to_string(b) + " is wrong!");
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+void benchmarkTranspose(const std::string &name, size_t rows, size_t columns, size_t batch = 1)
+{
+    size_t n = rows * columns * batch;
+    FastRandom r(n);
+    std::vector<T> values(n);
+    for (size_t i = 0; i < n; ++i) {
+        values[i] = (T) r.next();
+    }
+
+    gpu::shared_device_buffer_typed<T> src_gpu, dst_gpu;
+    src_gpu.resizeN(n);
+    src_gpu.writeN(values.data(), n);
+
+    std::cout << name << ":" << std::endl;
+    benchmarkBandwidth("transpose", n * sizeof(T), [&]() { gpu::transpose(src_gpu, dst_gpu, rows, columns, batch); });
+    checkTransposed(values, dst_gpu, rows, columns, batch, name);
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    // Ориентир: простое копирование буфера на девайсе - транспонирование должно быть близко к нему
+    {
+        size_t n = 8192 * 8192;
+        gpu::gpu_mem_32f a_gpu, b_gpu;
+        a_gpu.resizeN(n);
+        b_gpu.resizeN(n);
+        std::cout << "Device copy of " << n << " floats:" << std::endl;
+        benchmarkBandwidth("copy", n * sizeof(float), [&]() { a_gpu.copyToN(b_gpu, n); });
+    }
+
+    benchmarkTranspose<float>("float matrix 8192x8192", 8192, 8192);
+    benchmarkTranspose<float>("float matrix 3000x7001", 3000, 7001);
+    benchmarkTranspose<double>("double matrix 4096x4096", 4096, 4096);
+    benchmarkTranspose<float>("batch of 1024 float matrices 64x96", 64, 96, 1024);
+
+    // Массив структур из 4 float-ов (частицы x, y, z, масса) в структуру массивов
+    benchmarkTranspose<float>("AoS -> SoA of 16M structures of 4 floats", 16*1024*1024, 4);
+    benchmarkTranspose<float>("SoA -> AoS of 16M structures of 4 floats", 4, 16*1024*1024);
+
+    // Картинка RGB: перемежающиеся каналы (как в images::Image) в отдельные плоскости и обратно
+    {
+        size_t width = 3840, height = 2160, cn = 3;
+        size_t npixels = width * height;
+        FastRandom r(npixels);
+        std::vector<unsigned char> interleaved(npixels * cn);
+        for (size_t i = 0; i < interleaved.size(); ++i) {
+            interleaved[i] = (unsigned char) r.next(0, 255);
+        }
+
+        gpu::gpu_mem_8u interleaved_gpu, planar_gpu, back_gpu;
+        interleaved_gpu.resizeN(interleaved.size());
+        interleaved_gpu.writeN(interleaved.data(), interleaved.size());
+
+        std::cout << "RGB image " << width << "x" << height << ":" << std::endl;
+        benchmarkBandwidth("interleaved -> planar", interleaved.size(), [&]() { gpu::aosToSoa(interleaved_gpu, planar_gpu, npixels, cn); });
+        benchmarkBandwidth("planar -> interleaved", interleaved.size(), [&]() { gpu::soaToAos(planar_gpu, back_gpu, npixels, cn); });
+        checkTransposed(interleaved, planar_gpu, npixels, cn, 1, "interleaved -> planar");
+
+        std::vector<unsigned char> back(interleaved.size());
+        back_gpu.readN(back.data(), back.size());
+        if (back != interleaved) {
+            throw std::runtime_error("planar -> interleaved doesn't restore the image!");
+        }
+    }
+
+    return 0;
+}
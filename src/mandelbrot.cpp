@@ -0,0 +1,639 @@
+#include "mandelbrot.h"
+
+#include <libgpu/context.h>
+#include <libgpu/opencl/program_cache.h>
+#include <libutils/string_utils.h>
+
+// Эти файлы будут сгенерированы автоматически в момент сборки - см. convertIntoHeader в CMakeLists.txt
+#include "cl/mandelbrot_cl.h"
+#include <libgpu/opencl/cl/common_cl.h>
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+
+// Плитка 16x16 - одна рабочая группа, на каждый вычислительный блок запускаем несколько групп,
+// чтобы пока одни ждут памяти, другие считали
+static const unsigned int tileSize = 16;
+static const unsigned int groupsPerComputeUnit = 8;
+
+// Регион трассировки границ 64x64 - одна группа из 256 потоков. Заливка экономит до 64*64 пикселей на 252 пикселя границы,
+// а его значения, список пикселей для подсчета и флаги прямоугольников занимают ~24 Кб локальной памяти
+static const unsigned int regionSize = 64;
+
+// Должен совпадать с BAILOUT2 в cl/mandelbrot.cl, иначе гладкая раскраска CPU и GPU разойдется
+static const float bailout2 = 256.0f * 256.0f;
+
+// Float различает соседние пиксели, пока шаг больше нескольких десятков ulp координат
+static const double floatPixelUlps = 64.0;
+
+// Кернелам нужны double-float функции из common.cl, поэтому он вставляется перед исходником кернелов как заголовок.
+// Программа одна на набор defines - все кернелы обоих рендереров берутся из нее, а не компилируют исходник каждый заново
+static ocl::ProgramCache mandelbrotPrograms(mandelbrot_kernel, mandelbrot_kernel_length, "mandelbrot");
+
+static ocl::KernelSource *mandelbrotKernel(const std::string &name, const std::string &extraDefines = std::string())
+{
+    static const std::string common(common_kernel, common_kernel_length);
+    std::string defines = "-D TILE_SIZE=" + to_string(tileSize) + " -D REGION_SIZE=" + to_string(regionSize) + extraDefines;
+    return &mandelbrotPrograms.kernel(name, defines, common);
+}
+
+MandelbrotRenderer::MandelbrotRenderer() : acceleration_(MandelbrotAllAccelerations), precision_(MandelbrotPrecisionAuto)
+{
+    mandelbrot_ = mandelbrotKernel("mandelbrot");
+    mandelbrot_traced_ = mandelbrotKernel("mandelbrot_traced");
+    mandelbrot_deep_double_ = mandelbrotKernel("mandelbrot_deep", " -D DEEP_DOUBLE");
+    mandelbrot_deep_df_ = mandelbrotKernel("mandelbrot_deep");
+    colorize_ = mandelbrotKernel("mandelbrot_colorize");
+}
+
+bool MandelbrotRenderer::usesPerturbation(const MandelbrotView &view, unsigned int width) const
+{
+    if (precision_ != MandelbrotPrecisionAuto) {
+        return precision_ == MandelbrotPrecisionPerturbation;
+    }
+    double coordinate = std::max(1.0, std::max(std::fabs(view.centerX), std::fabs(view.centerY)));
+    double ulp = coordinate * std::numeric_limits<float>::epsilon();
+    return view.step(width) < floatPixelUlps * ulp;
+}
+
+// Арифметика double-double на хосте для опорной орбиты: значение hi + lo, |lo| <= ulp(hi) / 2
+struct DoubleDouble {
+    double hi;
+    double lo;
+
+    DoubleDouble(double hi = 0.0, double lo = 0.0) : hi(hi), lo(lo) {}
+};
+
+static DoubleDouble quickTwoSum(double a, double b)
+{
+    double s = a + b;
+    return DoubleDouble(s, b - (s - a));
+}
+
+static DoubleDouble twoSum(double a, double b)
+{
+    double s = a + b;
+    double bb = s - a;
+    return DoubleDouble(s, (a - (s - bb)) + (b - bb));
+}
+
+static DoubleDouble operator+(const DoubleDouble &a, const DoubleDouble &b)
+{
+    DoubleDouble s = twoSum(a.hi, b.hi);
+    DoubleDouble t = twoSum(a.lo, b.lo);
+    s.lo += t.hi;
+    s = quickTwoSum(s.hi, s.lo);
+    s.lo += t.lo;
+    return quickTwoSum(s.hi, s.lo);
+}
+
+static DoubleDouble operator-(const DoubleDouble &a)
+{
+    return DoubleDouble(-a.hi, -a.lo);
+}
+
+static DoubleDouble operator-(const DoubleDouble &a, const DoubleDouble &b)
+{
+    return a + (-b);
+}
+
+static DoubleDouble operator*(const DoubleDouble &a, const DoubleDouble &b)
+{
+    // fma вычисляет ошибку округления произведения точно
+    double p = a.hi * b.hi;
+    double e = std::fma(a.hi, b.hi, -p);
+    e += a.hi * b.lo + a.lo * b.hi;
+    return quickTwoSum(p, e);
+}
+
+static double toDouble(const DoubleDouble &a)
+{
+    return a.hi + a.lo;
+}
+
+// Старшая и младшая float части числа для double-float на устройстве
+static void splitIntoFloats(const DoubleDouble &a, float &hi, float &lo)
+{
+    hi = (float) a.hi;
+    lo = (float) ((a.hi - hi) + a.lo);
+}
+
+// Опорная орбита Z_0 = 0, Z_1 = c, ... до убегания или iterations + 1 итераций, но не короче 3 точек,
+// чтобы кернелу всегда было куда сделать шаг
+static void computeReferenceOrbit(const MandelbrotView &view, std::vector<float> &orbit)
+{
+    const DoubleDouble cx = DoubleDouble(view.centerX) + DoubleDouble(view.centerXLo);
+    const DoubleDouble cy = DoubleDouble(view.centerY) + DoubleDouble(view.centerYLo);
+
+    orbit.clear();
+    DoubleDouble x, y;
+    for (unsigned int n = 0; n <= view.iterations + 1; ++n) {
+        float values[4];
+        splitIntoFloats(x, values[0], values[1]);
+        splitIntoFloats(y, values[2], values[3]);
+        orbit.insert(orbit.end(), values, values + 4);
+
+        double r2 = toDouble(x) * toDouble(x) + toDouble(y) * toDouble(y);
+        if (r2 > bailout2 && n >= 2) {
+            break;
+        }
+
+        DoubleDouble xPrev = x;
+        x = x * x - y * y + cx;
+        y = DoubleDouble(2.0) * xPrev * y + cy;
+    }
+}
+
+void MandelbrotRenderer::renderValues(const MandelbrotView &view, unsigned int width, unsigned int height, gpu::gpu_mem_32f &values)
+{
+    if (width == 0 || height == 0) {
+        throw std::runtime_error("Empty image can't be rendered!");
+    }
+    values.growN(width * height);
+
+    if (usesPerturbation(view, width)) {
+        renderDeep(view, width, height, values);
+        return;
+    }
+
+    bool traced = (acceleration_ & MandelbrotBoundaryTracing) != 0;
+    // ускорения внутри одного пикселя кернел проверяет сам
+    unsigned int flags = acceleration_ & (MandelbrotInteriorTests | MandelbrotPeriodicity);
+
+    unsigned int blockSize = traced ? regionSize : tileSize;
+    unsigned int nblocks = gpu::divup(width, blockSize) * gpu::divup(height, blockSize);
+    gpu::Context context;
+    unsigned int ngroups = std::min(nblocks, (unsigned int) context.cl()->maxComputeUnits() * groupsPerComputeUnit);
+
+    // плитки раздаются атомарным счетчиком, перед каждым запуском его нужно обнулить
+    unsigned int zero = 0;
+    next_tile_.growN(1);
+    next_tile_.writeN(&zero, 1);
+
+    float fromX = (float) view.fromX();
+    float fromY = (float) view.fromY(width, height);
+    float step = (float) view.step(width);
+    if (traced) {
+        mandelbrot_traced_->exec(gpu::WorkSize(tileSize * tileSize, ngroups * tileSize * tileSize),
+                                values, width, height, fromX, fromY, step, view.iterations, flags, next_tile_);
+    } else {
+        mandelbrot_->exec(gpu::WorkSize(tileSize, tileSize, ngroups * tileSize, tileSize),
+                         values, width, height, fromX, fromY, step, view.iterations, flags, next_tile_);
+    }
+}
+
+void MandelbrotRenderer::renderDeep(const MandelbrotView &view, unsigned int width, unsigned int height, gpu::gpu_mem_32f &values)
+{
+    std::vector<float> orbit;
+    computeReferenceOrbit(view, orbit);
+    unsigned int orbitLength = (unsigned int) (orbit.size() / 4);
+    orbit_.growN(orbit.size());
+    orbit_.writeN(orbit.data(), orbit.size());
+
+    DoubleDouble step = DoubleDouble(view.sizeX) * DoubleDouble(1.0 / width);
+    float stepHi, stepLo;
+    splitIntoFloats(step, stepHi, stepLo);
+
+    unsigned int ntiles = gpu::divup(width, tileSize) * gpu::divup(height, tileSize);
+    gpu::Context context;
+    unsigned int ngroups = std::min(ntiles, (unsigned int) context.cl()->maxComputeUnits() * groupsPerComputeUnit);
+
+    unsigned int zero = 0;
+    next_tile_.growN(1);
+    next_tile_.writeN(&zero, 1);
+
+    bool fp64 = context.cl()->deviceInfo().extensions.count("cl_khr_fp64") > 0;
+    ocl::KernelSource *kernel = fp64 ? mandelbrot_deep_double_ : mandelbrot_deep_df_;
+    kernel->exec(gpu::WorkSize(tileSize, tileSize, ngroups * tileSize, tileSize),
+                values, width, height, stepHi, stepLo, orbit_, orbitLength, view.iterations, next_tile_);
+}
+
+void MandelbrotRenderer::render(const MandelbrotView &view, images::Image<float> &image)
+{
+    if (image.cn != 1) {
+        throw std::runtime_error("Values can be rendered only into single-channel image, but " + to_string(image.cn) + " channels found!");
+    }
+    unsigned int width = (unsigned int) image.width;
+    unsigned int height = (unsigned int) image.height;
+    renderValues(view, width, height, values_);
+
+    // строки картинки могут идти с шагом (например, если это вырезанный кусок другой картинки), поэтому копируем построчно
+    std::vector<float> values(width * height);
+    values_.readN(values.data(), width * height);
+    for (unsigned int j = 0; j < height; ++j) {
+        memcpy(&image(j, 0), values.data() + j * width, width * sizeof(float));
+    }
+}
+
+void MandelbrotRenderer::render(const MandelbrotView &view, images::Image<unsigned char> &image, MandelbrotColoring coloring)
+{
+    if (image.cn != 1 && image.cn != 3 && image.cn != 4) {
+        throw std::runtime_error("Only 1, 3 or 4 channels are supported, but " + to_string(image.cn) + " channels found!");
+    }
+    unsigned int width = (unsigned int) image.width;
+    unsigned int height = (unsigned int) image.height;
+    unsigned int cn = (unsigned int) image.cn;
+    renderValues(view, width, height, values_);
+
+    pixels_.growN(width * height * cn);
+    colorize_->exec(gpu::WorkSize(tileSize, tileSize, width, height),
+                   values_, width, height, pixels_, cn, (unsigned int) (cn == 1 ? MandelbrotGrayscale : coloring));
+
+    std::vector<unsigned char> pixels(width * height * cn);
+    pixels_.readN(pixels.data(), width * height * cn);
+    for (unsigned int j = 0; j < height; ++j) {
+        memcpy(&image(j, 0), pixels.data() + j * width * cn, width * cn);
+    }
+}
+
+// Проходы прогрессивного рендера - подрешетки пикселей (шаг, первый пиксель по x и y). Первые проходы дешевые, чтобы
+// после сдвига или зума сразу было что показать, последние три - по четверти картинки, чтобы каждый кадр был коротким
+struct ProgressiveSubgrid {
+    unsigned int pass;
+    unsigned int stride;
+    unsigned int firstX;
+    unsigned int firstY;
+};
+
+static const ProgressiveSubgrid progressiveSubgrids[] = {
+    {0, 8, 0, 0},
+    {1, 8, 4, 0}, {1, 8, 0, 4}, {1, 8, 4, 4},
+    {2, 4, 2, 0}, {2, 4, 0, 2}, {2, 4, 2, 2},
+    {3, 2, 1, 0},
+    {4, 2, 0, 1},
+    {5, 2, 1, 1}
+};
+static const unsigned int progressivePasses = 6;
+
+// Номер пикселя на сетке должен точно помещаться во float (2^24) и не переполнять int при отдалении в 2^4 раз
+static const double maxGridOffset = (double) (1 << 22);
+static const int maxReuseZoomLog2 = 4;
+// Насколько вид может не попадать на сетку прошлого (в пикселях и относительно шага), чтобы его пиксели переиспользовались
+static const double gridTolerance = 1e-3;
+
+// Сколько пикселей строки (или столбца) из size пикселей есть в прошлом кадре - так же, как в mandelbrot_progressive_reuse
+static unsigned int countReusedPixels(int offset, unsigned int size, int oldOffset, unsigned int oldSize, int zoomLog2)
+{
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < size; ++i) {
+        long long g = offset + (long long) i;
+        if (zoomLog2 > 0) {
+            long long d = 1LL << zoomLog2;
+            if (g % d != 0) {
+                continue;
+            }
+            g /= d;
+        } else if (zoomLog2 < 0) {
+            g *= 1LL << (-zoomLog2);
+        }
+        long long io = g - oldOffset;
+        if (io >= 0 && io < (long long) oldSize) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// Вид со сдвинутым центром - сдвиг прибавляется в double-double, чтобы не потерять младшие части центра глубокого зума
+static MandelbrotView shiftedView(const MandelbrotView &view, double dx, double dy, double sizeX)
+{
+    DoubleDouble cx = DoubleDouble(view.centerX) + DoubleDouble(view.centerXLo) + DoubleDouble(dx);
+    DoubleDouble cy = DoubleDouble(view.centerY) + DoubleDouble(view.centerYLo) + DoubleDouble(dy);
+    return MandelbrotView(cx.hi, cy.hi, sizeX, view.iterations, cx.lo, cy.lo);
+}
+
+MandelbrotProgressiveRenderer::MandelbrotProgressiveRenderer()
+        : width_(0), height_(0), pass_(0), reused_(0.0), deep_(false), hasGrid_(false),
+          originX_(0.0f), originY_(0.0f), step_(0.0f), offsetX_(0), offsetY_(0)
+{
+    reuse_ = mandelbrotKernel("mandelbrot_progressive_reuse");
+    progressive_ = mandelbrotKernel("mandelbrot_progressive");
+    preview_ = mandelbrotKernel("mandelbrot_progressive_preview");
+    colorize_ = mandelbrotKernel("mandelbrot_colorize");
+}
+
+unsigned int MandelbrotProgressiveRenderer::passesCount()
+{
+    return progressivePasses;
+}
+
+void MandelbrotProgressiveRenderer::setView(const MandelbrotView &view, unsigned int width, unsigned int height)
+{
+    if (width == 0 || height == 0) {
+        throw std::runtime_error("Empty image can't be rendered!");
+    }
+
+    const unsigned int oldWidth = width_;
+    const unsigned int oldHeight = height_;
+    const int oldOffsetX = offsetX_;
+    const int oldOffsetY = offsetY_;
+    // с другим пределом итераций значения всех пикселей другие
+    const bool hadGrid = hasGrid_ && view.iterations == view_.iterations;
+
+    view_ = view;
+    width_ = width;
+    height_ = height;
+    pass_ = 0;
+    reused_ = 0.0;
+
+    deep_ = renderer_.usesPerturbation(view, width);
+    if (deep_) {
+        hasGrid_ = false;
+        return;
+    }
+
+    // центр левого верхнего пикселя
+    const double step = view.step(width);
+    const double x0 = view.fromX() + 0.5 * step;
+    const double y0 = view.fromY(width, height) - 0.5 * step;
+
+    int zoomLog2 = 0;
+    bool aligned = false;
+    if (hadGrid) {
+        zoomLog2 = (int) std::lround(std::log2(step_ / step));
+        double gridStep = std::ldexp((double) step_, -zoomLog2);
+        double gx = (x0 - originX_) / gridStep;
+        double gy = (originY_ - y0) / gridStep;
+        aligned = std::abs(zoomLog2) <= maxReuseZoomLog2
+                  && std::fabs(step / gridStep - 1.0) < gridTolerance
+                  && std::fabs(gx - std::round(gx)) < gridTolerance && std::fabs(gy - std::round(gy)) < gridTolerance
+                  && std::fabs(gx) + width < maxGridOffset && std::fabs(gy) + height < maxGridOffset;
+        if (aligned) {
+            step_ = (float) gridStep;
+            offsetX_ = (int) std::lround(gx);
+            offsetY_ = (int) std::lround(gy);
+        }
+    }
+    if (!aligned) {
+        // новая сетка с началом в левом верхнем пикселе
+        originX_ = (float) x0;
+        originY_ = (float) y0;
+        step_ = (float) step;
+        offsetX_ = 0;
+        offsetY_ = 0;
+        zoomLog2 = 0;
+    }
+    hasGrid_ = true;
+
+    // прошлый кадр становится источником, новый заполняется его пикселями или пометками "не посчитан"
+    values_.swap(previous_values_);
+    values_.growN(width * height);
+    // пустой буфер нельзя передать аргументом кернела, даже если из него ничего не читается
+    previous_values_.growN(1);
+    reuse_->exec(gpu::WorkSize(tileSize, tileSize, width, height),
+                previous_values_, aligned ? oldWidth : 0u, oldHeight, oldOffsetX, oldOffsetY,
+                values_, width, height, offsetX_, offsetY_, zoomLog2);
+
+    if (aligned) {
+        reused_ = (double) countReusedPixels(offsetX_, width, oldOffsetX, oldWidth, zoomLog2)
+                  * countReusedPixels(offsetY_, height, oldOffsetY, oldHeight, zoomLog2) / ((double) width * height);
+    }
+}
+
+MandelbrotView MandelbrotProgressiveRenderer::gridView(double offsetX, double offsetY, double step) const
+{
+    // центр картинки - на полкартинки минус полпикселя правее и ниже центра левого верхнего пикселя
+    double centerX = originX_ + offsetX * step + (0.5 * width_ - 0.5) * step;
+    double centerY = originY_ - offsetY * step - (0.5 * height_ - 0.5) * step;
+    return MandelbrotView(centerX, centerY, step * width_, view_.iterations);
+}
+
+MandelbrotView MandelbrotProgressiveRenderer::panned(int dx, int dy) const
+{
+    if (hasGrid_) {
+        return gridView((double) offsetX_ + dx, (double) offsetY_ + dy, step_);
+    }
+    double step = view_.step(width_);
+    return shiftedView(view_, dx * step, -dy * step, view_.sizeX);
+}
+
+MandelbrotView MandelbrotProgressiveRenderer::zoomed(int x, int y, int zoomLog2) const
+{
+    if (hasGrid_) {
+        // номер точки под курсором на сетке; при отдалении он должен делиться на 2^-zoomLog2, чтобы точка была и на новой сетке
+        double px = (double) offsetX_ + x;
+        double py = (double) offsetY_ + y;
+        if (zoomLog2 < 0) {
+            double d = std::ldexp(1.0, -zoomLog2);
+            px = std::round(px / d) * d;
+            py = std::round(py / d) * d;
+            x = (int) (px - offsetX_);
+            y = (int) (py - offsetY_);
+        }
+        return gridView(std::ldexp(px, zoomLog2) - x, std::ldexp(py, zoomLog2) - y, std::ldexp((double) step_, -zoomLog2));
+    }
+    double step = view_.step(width_);
+    double shrink = 1.0 - std::ldexp(1.0, -zoomLog2);
+    double ux = (x + 0.5 - 0.5 * width_) * step;
+    double uy = (0.5 * height_ - y - 0.5) * step;
+    return shiftedView(view_, ux * shrink, uy * shrink, std::ldexp(view_.sizeX, -zoomLog2));
+}
+
+bool MandelbrotProgressiveRenderer::refine()
+{
+    if (width_ == 0 || height_ == 0) {
+        throw std::runtime_error("View should be set before rendering!");
+    }
+    if (isComplete()) {
+        return false;
+    }
+
+    if (deep_) {
+        renderer_.renderValues(view_, width_, height_, values_);
+        pass_ = progressivePasses;
+        return true;
+    }
+
+    // трассировка границ плохо сочетается с редкими подрешетками, а ускорения внутри пикселя результат не меняют
+    const unsigned int flags = MandelbrotInteriorTests | MandelbrotPeriodicity;
+    for (size_t k = 0; k < sizeof(progressiveSubgrids) / sizeof(progressiveSubgrids[0]); ++k) {
+        const ProgressiveSubgrid &subgrid = progressiveSubgrids[k];
+        if (subgrid.pass != pass_ || subgrid.firstX >= width_ || subgrid.firstY >= height_) {
+            continue;
+        }
+        unsigned int nx = gpu::divup(width_ - subgrid.firstX, subgrid.stride);
+        unsigned int ny = gpu::divup(height_ - subgrid.firstY, subgrid.stride);
+        progressive_->exec(gpu::WorkSize(tileSize, tileSize, nx, ny),
+                          values_, width_, height_, originX_, originY_, step_, offsetX_, offsetY_,
+                          subgrid.stride, subgrid.firstX, subgrid.firstY, view_.iterations, flags);
+    }
+    ++pass_;
+    return true;
+}
+
+const gpu::gpu_mem_32f &MandelbrotProgressiveRenderer::previewValues()
+{
+    if (pass_ == 0) {
+        refine();
+    }
+    if (isComplete()) {
+        return values_;
+    }
+    preview_values_.growN(width_ * height_);
+    preview_->exec(gpu::WorkSize(tileSize, tileSize, width_, height_), values_, width_, height_, preview_values_);
+    return preview_values_;
+}
+
+void MandelbrotProgressiveRenderer::read(images::Image<float> &image)
+{
+    if (image.cn != 1 || image.width != width_ || image.height != height_) {
+        throw std::runtime_error("Values can be read only into single-channel image of the view size!");
+    }
+    const gpu::gpu_mem_32f &values = previewValues();
+
+    std::vector<float> data(width_ * height_);
+    values.readN(data.data(), width_ * height_);
+    for (unsigned int j = 0; j < height_; ++j) {
+        memcpy(&image(j, 0), data.data() + j * width_, width_ * sizeof(float));
+    }
+}
+
+void MandelbrotProgressiveRenderer::read(images::Image<unsigned char> &image, MandelbrotColoring coloring)
+{
+    if (image.cn != 1 && image.cn != 3 && image.cn != 4) {
+        throw std::runtime_error("Only 1, 3 or 4 channels are supported, but " + to_string(image.cn) + " channels found!");
+    }
+    if (image.width != width_ || image.height != height_) {
+        throw std::runtime_error("Image size differs from the view size!");
+    }
+    const unsigned int cn = (unsigned int) image.cn;
+    const gpu::gpu_mem_32f &values = previewValues();
+
+    pixels_.growN(width_ * height_ * cn);
+    colorize_->exec(gpu::WorkSize(tileSize, tileSize, width_, height_),
+                   values, width_, height_, pixels_, cn, (unsigned int) (cn == 1 ? MandelbrotGrayscale : coloring));
+
+    std::vector<unsigned char> pixels(width_ * height_ * cn);
+    pixels_.readN(pixels.data(), width_ * height_ * cn);
+    for (unsigned int j = 0; j < height_; ++j) {
+        memcpy(&image(j, 0), pixels.data() + j * width_ * cn, width_ * cn);
+    }
+}
+
+// Сколько пикселей строки считаются одновременно - под AVX2 (8 float) и с запасом под AVX-512 на две итерации цикла
+static const int cpuLanes = 16;
+
+void renderMandelbrotCPU(const MandelbrotView &view, images::Image<float> &image)
+{
+    const int width = (int) image.width;
+    const int height = (int) image.height;
+    const unsigned int iterations = view.iterations;
+    const float fromX = (float) view.fromX();
+    const float fromY = (float) view.fromY(width, height);
+    const float step = (float) view.step(width);
+
+    // Строки внутри множества в десятки раз дороже строк снаружи, поэтому раздаем их динамически
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int j = 0; j < height; ++j) {
+        const float y0 = fromY - (j + 0.5f) * step;
+        for (int i0 = 0; i0 < width; i0 += cpuLanes) {
+            float x0[cpuLanes], xs[cpuLanes], ys[cpuLanes], r2s[cpuLanes];
+            unsigned int iters[cpuLanes];
+            int active[cpuLanes];
+            for (int k = 0; k < cpuLanes; ++k) {
+                x0[k] = fromX + (i0 + k + 0.5f) * step;
+                xs[k] = x0[k];
+                ys[k] = y0;
+                r2s[k] = 0.0f;
+                iters[k] = iterations;
+                active[k] = 1;
+            }
+
+            // Все пиксели пачки итерируются вместе, убежавшие просто перестают обновляться -
+            // так цикл по пикселям векторизуется, а пачка заканчивается, когда убежали все
+            for (unsigned int iter = 0; iter < iterations; ++iter) {
+                int nactive = 0;
+                #pragma omp simd reduction(+:nactive)
+                for (int k = 0; k < cpuLanes; ++k) {
+                    float x = xs[k] * xs[k] - ys[k] * ys[k] + x0[k];
+                    float y = 2.0f * xs[k] * ys[k] + y0;
+                    float r2 = x * x + y * y;
+                    if (active[k]) {
+                        xs[k] = x;
+                        ys[k] = y;
+                        if (r2 > bailout2) {
+                            active[k] = 0;
+                            iters[k] = iter;
+                            r2s[k] = r2;
+                        }
+                    }
+                    nactive += active[k];
+                }
+                if (nactive == 0) {
+                    break;
+                }
+            }
+
+            for (int k = 0; k < cpuLanes && i0 + k < width; ++k) {
+                float value = 1.0f;
+                if (iters[k] < iterations) {
+                    float smooth = iters[k] + 1.0f - std::log2(std::log2(r2s[k]) * 0.5f);
+                    value = std::min(std::max(smooth / iterations, 0.0f), 0.99999f);
+                }
+                image(j, i0 + k) = value;
+            }
+        }
+    }
+}
+
+void renderMandelbrotDeepCPU(const MandelbrotView &view, images::Image<float> &image)
+{
+    const int width = (int) image.width;
+    const int height = (int) image.height;
+    const unsigned int iterations = view.iterations;
+    const DoubleDouble cx = DoubleDouble(view.centerX) + DoubleDouble(view.centerXLo);
+    const DoubleDouble cy = DoubleDouble(view.centerY) + DoubleDouble(view.centerYLo);
+    const DoubleDouble step = DoubleDouble(view.sizeX) * DoubleDouble(1.0 / width);
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int j = 0; j < height; ++j) {
+        for (int i = 0; i < width; ++i) {
+            DoubleDouble x0 = cx + DoubleDouble(i + 0.5 - 0.5 * width) * step;
+            DoubleDouble y0 = cy + DoubleDouble(0.5 * height - (j + 0.5)) * step;
+
+            DoubleDouble x = x0;
+            DoubleDouble y = y0;
+            double r2 = 0.0;
+            unsigned int iter = 0;
+            for (; iter < iterations; ++iter) {
+                DoubleDouble xPrev = x;
+                x = x * x - y * y + x0;
+                y = DoubleDouble(2.0) * xPrev * y + y0;
+                r2 = toDouble(x) * toDouble(x) + toDouble(y) * toDouble(y);
+                if (r2 > bailout2) {
+                    break;
+                }
+            }
+
+            float value = 1.0f;
+            if (iter < iterations) {
+                float smooth = iter + 1.0f - std::log2(std::log2((float) r2) * 0.5f);
+                value = std::min(std::max(smooth / iterations, 0.0f), 0.99999f);
+            }
+            image(j, i) = value;
+        }
+    }
+}
+
+double mandelbrotMismatch(const images::Image<float> &a, const images::Image<float> &b, float tolerance)
+{
+    if (a.width != b.width || a.height != b.height) {
+        throw std::runtime_error("Images of different sizes can't be compared!");
+    }
+
+    size_t mismatches = 0;
+    for (size_t j = 0; j < a.height; ++j) {
+        for (size_t i = 0; i < a.width; ++i) {
+            if (std::fabs(a(j, i) - b(j, i)) > tolerance) {
+                ++mismatches;
+            }
+        }
+    }
+    return (double) mismatches / (a.width * a.height);
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <libgpu/shared_device_buffer.h>
+#include <libimages/images.h>
+#include <libutils/misc.h>
+
+
+// Какую часть комплексной плоскости рисовать: центр, ширина видимой области и предел числа итераций.
+// Высота области определяется пропорциями картинки - пиксели квадратные.
+// Для глубокого зума точности double в координатах центра не хватает (ширина области ~1e-13 и меньше),
+// тогда центр задается суммой двух double: centerX + centerXLo, младшая часть учитывается только в режиме возмущений.
+struct MandelbrotView {
+    double centerX;
+    double centerY;
+    double sizeX;
+    unsigned int iterations;
+    double centerXLo;
+    double centerYLo;
+
+    MandelbrotView(double centerX = -0.5, double centerY = 0.0, double sizeX = 3.0, unsigned int iterations = 256,
+                   double centerXLo = 0.0, double centerYLo = 0.0)
+            : centerX(centerX), centerY(centerY), sizeX(sizeX), iterations(iterations), centerXLo(centerXLo), centerYLo(centerYLo) {}
+
+    // Шаг между соседними пикселями и координаты левого верхнего угла картинки
+    double step(size_t width) const                     { return sizeX / width;                         }
+    double fromX() const                                { return centerX - 0.5 * sizeX;                 }
+    double fromY(size_t width, size_t height) const     { return centerY + 0.5 * step(width) * height;  }
+};
+
+// Ускорения рендера, их можно комбинировать. Результат от них не меняется - картинка совпадает с полным перебором до пикселя
+enum MandelbrotAcceleration {
+    MandelbrotBruteForce        = 0,
+    MandelbrotInteriorTests     = 1,    // главная кардиоида и круг периода 2 сразу считаются множеством
+    MandelbrotPeriodicity       = 2,    // орбита, вернувшаяся в уже пройденную точку, не убежит никогда
+    MandelbrotBoundaryTracing   = 4,    // Мариани-Силвер: прямоугольник, вся граница которого в множестве, заливается (приближенно)
+    MandelbrotAllAccelerations  = 7
+};
+
+enum MandelbrotPrecision {
+    MandelbrotPrecisionAuto,            // возмущения, только если float не различает соседние пиксели
+    MandelbrotPrecisionFloat,           // каждый пиксель итерируется во float, работают все ускорения
+    MandelbrotPrecisionPerturbation     // опорная орбита на хосте + отклонения в double или double-float на устройстве
+};
+
+enum MandelbrotColoring {
+    MandelbrotGrayscale,
+    MandelbrotPalette
+};
+
+// Рисует фрактал на видеокарте активного контекста. В Image<float> (один канал) попадает доля итераций до убегания
+// с гладкой дробной частью - от 0 до 1, для точек множества ровно 1. Image<unsigned char> раскрашивается прямо
+// на видеокарте, у нее может быть 1 канал (всегда оттенки серого), 3 или 4 канала.
+class MandelbrotRenderer {
+public:
+    MandelbrotRenderer();
+
+    // По умолчанию включены все ускорения
+    void setAcceleration(unsigned int acceleration)     { acceleration_ = acceleration; }
+    unsigned int acceleration() const                   { return acceleration_;         }
+
+    // По умолчанию MandelbrotPrecisionAuto. Ускорения в режиме возмущений не применяются
+    void setPrecision(MandelbrotPrecision precision)    { precision_ = precision;       }
+    MandelbrotPrecision precision() const               { return precision_;            }
+    bool usesPerturbation(const MandelbrotView &view, unsigned int width) const;
+
+    void render(const MandelbrotView &view, images::Image<float> &image);
+    void render(const MandelbrotView &view, images::Image<unsigned char> &image, MandelbrotColoring coloring = MandelbrotPalette);
+
+    // Значения остаются на видеокарте - например, чтобы дальше обрабатывать их другими кернелами
+    void renderValues(const MandelbrotView &view, unsigned int width, unsigned int height, gpu::gpu_mem_32f &values);
+
+protected:
+    void renderDeep(const MandelbrotView &view, unsigned int width, unsigned int height, gpu::gpu_mem_32f &values);
+
+    unsigned int acceleration_;
+    MandelbrotPrecision precision_;
+
+    ocl::KernelSource *mandelbrot_;
+    ocl::KernelSource *mandelbrot_traced_;
+    ocl::KernelSource *mandelbrot_deep_double_;
+    ocl::KernelSource *mandelbrot_deep_df_;
+    ocl::KernelSource *colorize_;
+
+    gpu::gpu_mem_32f orbit_;    // по 4 float на итерацию опорной орбиты
+
+    gpu::gpu_mem_32f values_;
+    gpu::gpu_mem_8u pixels_;
+    gpu::gpu_mem_32u next_tile_;
+};
+
+// Прогрессивный рендер для интерактивного просмотра: картинка досчитывается за несколько проходов, и после каждого ее уже
+// можно показать. Первый проход считает каждый 8-й пиксель по обеим осям, следующие - каждый 4-й и 2-й, последние три -
+// оставшиеся пиксели в полном разрешении вперемешку; недосчитанные пиксели показываются значением угла своего блока.
+// Пиксели, совпадающие с пикселями прошлого вида (сдвиг на целое число пикселей, зум в 2^k раз), не пересчитываются,
+// а копируются из прошлого кадра прямо на видеокарте. Виды, выровненные так по сетке, дают panned и zoomed.
+// Глубокий зум (когда нужны возмущения) рисуется сразу целиком, без проходов и переиспользования.
+class MandelbrotProgressiveRenderer {
+public:
+    MandelbrotProgressiveRenderer();
+
+    void setView(const MandelbrotView &view, unsigned int width, unsigned int height);
+    const MandelbrotView &view() const                  { return view_;     }
+    unsigned int width() const                          { return width_;    }
+    unsigned int height() const                         { return height_;   }
+
+    // Вид, сдвинутый так, что новый пиксель (i, j) - это прошлый пиксель (i + dx, j + dy)
+    MandelbrotView panned(int dx, int dy) const;
+    // Вид, приближенный в 2^zoomLog2 раз (отдаленный при zoomLog2 < 0) так, что точка под пикселем (x, y) остается на месте.
+    // При отдалении точка сдвигается не больше чем на 2^-zoomLog2 пикселей, чтобы попасть на сетку
+    MandelbrotView zoomed(int x, int y, int zoomLog2) const;
+
+    // Считает следующий проход, возвращает false, если картинка уже была досчитана
+    bool refine();
+    bool isComplete() const                             { return pass_ == passesCount(); }
+    unsigned int pass() const                           { return pass_;     }
+    static unsigned int passesCount();
+    // Доля пикселей текущего вида, взятых из прошлого кадра
+    double reusedFraction() const                       { return reused_;   }
+
+    // Если еще не было ни одного прохода, сначала делается первый
+    void read(images::Image<float> &image);
+    void read(images::Image<unsigned char> &image, MandelbrotColoring coloring = MandelbrotPalette);
+
+protected:
+    MandelbrotView gridView(double offsetX, double offsetY, double step) const;
+    // Значения для показа: досчитанная картинка как есть, иначе с заполненными пропусками
+    const gpu::gpu_mem_32f &previewValues();
+
+    MandelbrotView view_;
+    unsigned int width_;
+    unsigned int height_;
+    unsigned int pass_;
+    double reused_;
+
+    // Сетка пикселей: пиксель (i, j) - точка (originX + (offsetX + i) * step, originY - (offsetY + j) * step) во float
+    bool deep_;
+    bool hasGrid_;
+    float originX_;
+    float originY_;
+    float step_;
+    int offsetX_;
+    int offsetY_;
+
+    MandelbrotRenderer renderer_;
+
+    ocl::KernelSource *reuse_;
+    ocl::KernelSource *progressive_;
+    ocl::KernelSource *preview_;
+    ocl::KernelSource *colorize_;
+
+    gpu::gpu_mem_32f values_;
+    gpu::gpu_mem_32f previous_values_;
+    gpu::gpu_mem_32f preview_values_;
+    gpu::gpu_mem_8u pixels_;
+};
+
+// Эталонная реализация на процессоре: OpenMP по строкам и SIMD по пикселям строки, вычисления в той же float точности
+void renderMandelbrotCPU(const MandelbrotView &view, images::Image<float> &image);
+
+// Эталон для глубокого зума: каждый пиксель итерируется целиком в double-double (~106 бит мантиссы), без возмущений.
+// Очень медленно - годится для проверки на небольших картинках
+void renderMandelbrotDeepCPU(const MandelbrotView &view, images::Image<float> &image);
+
+// Доля пикселей, значения в которых отличаются больше чем на tolerance - на границе множества float вычисления
+// на разных устройствах расходятся (FMA, другой порядок округлений), поэтому точного совпадения ждать нельзя
+double mandelbrotMismatch(const images::Image<float> &a, const images::Image<float> &b, float tolerance = 0.01f);
@@ -0,0 +1,177 @@
+#include "mandelbrot_animation.h"
+
+#include <libutils/timer.h>
+
+#include <cmath>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <condition_variable>
+
+
+std::vector<MandelbrotView> mandelbrotFlyThrough(const MandelbrotView &from, const MandelbrotView &to, unsigned int frames)
+{
+    std::vector<MandelbrotView> views;
+    for (unsigned int k = 0; k < frames; ++k) {
+        double t = frames > 1 ? (double) k / (frames - 1) : 1.0;
+        double sizeX = from.sizeX * std::pow(to.sizeX / from.sizeX, t);
+        // доля пути, которую центру осталось пройти - столько же, сколько осталось пройти ширине
+        double f = (from.sizeX != to.sizeX) ? (sizeX - to.sizeX) / (from.sizeX - to.sizeX) : 1.0 - t;
+        unsigned int iterations = (unsigned int) std::lround(from.iterations + (double(to.iterations) - from.iterations) * t);
+        // старшие и младшие части центра интерполируются отдельно, чтобы у цели не потерять точность глубокого зума
+        views.push_back(MandelbrotView(to.centerX + (from.centerX - to.centerX) * f,
+                                       to.centerY + (from.centerY - to.centerY) * f,
+                                       sizeX, iterations,
+                                       to.centerXLo + (from.centerXLo - to.centerXLo) * f,
+                                       to.centerYLo + (from.centerYLo - to.centerYLo) * f));
+    }
+    return views;
+}
+
+MandelbrotAnimationRenderer::MandelbrotAnimationRenderer(unsigned int encoderThreads, unsigned int framesInFlight)
+        : encoderThreads_(encoderThreads), framesInFlight_(framesInFlight), coloring_(MandelbrotPalette), jpegQuality_(95)
+{
+    if (encoderThreads_ == 0) {
+        // hardware_concurrency может вернуть 0, если число ядер неизвестно
+        unsigned int cores = std::thread::hardware_concurrency();
+        encoderThreads_ = cores > 1 ? cores - 1 : 1;
+    }
+    if (framesInFlight_ == 0) {
+        framesInFlight_ = encoderThreads_ + 2;
+    }
+}
+
+static bool endsWith(const std::string &s, const std::string &suffix)
+{
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+void MandelbrotAnimationRenderer::save(images::Image<unsigned char> &image, const std::string &filename) const
+{
+    if (endsWith(filename, ".png")) {
+        image.savePNG(filename);
+    } else if (endsWith(filename, ".jpg") || endsWith(filename, ".jpeg")) {
+        image.saveJPEG(filename, jpegQuality_);
+    } else {
+        throw std::runtime_error("Unsupported image format: " + filename);
+    }
+}
+
+static std::string frameFilename(const std::string &pattern, unsigned int frame)
+{
+    std::vector<char> filename(pattern.size() + 32);
+    snprintf(filename.data(), filename.size(), pattern.c_str(), frame);
+    return std::string(filename.data());
+}
+
+MandelbrotAnimationStats MandelbrotAnimationRenderer::render(const std::vector<MandelbrotView> &frames, unsigned int width, unsigned int height,
+                                                             const std::string &filenamePattern)
+{
+    struct EncodeJob {
+        images::Image<unsigned char> *image;
+        unsigned int frame;
+    };
+
+    // Буферы кадров выделяются один раз и ходят по кругу: свободные -> рендер -> очередь кодирования -> свободные
+    std::vector<images::Image<unsigned char> > buffers;
+    for (unsigned int k = 0; k < framesInFlight_; ++k) {
+        buffers.push_back(images::Image<unsigned char>(width, height, 3));
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<images::Image<unsigned char> *> free_buffers;
+    for (size_t k = 0; k < buffers.size(); ++k) {
+        free_buffers.push_back(&buffers[k]);
+    }
+    std::deque<EncodeJob> jobs;
+    bool finished = false;
+    std::exception_ptr error;
+
+    std::vector<std::thread> encoders;
+    for (unsigned int t = 0; t < encoderThreads_; ++t) {
+        encoders.push_back(std::thread([&]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                cv.wait(lock, [&] { return !jobs.empty() || finished; });
+                if (jobs.empty()) {
+                    break;
+                }
+                EncodeJob job = jobs.front();
+                jobs.pop_front();
+                lock.unlock();
+
+                std::exception_ptr job_error;
+                try {
+                    save(*job.image, frameFilename(filenamePattern, job.frame));
+                } catch (...) {
+                    job_error = std::current_exception();
+                }
+
+                lock.lock();
+                if (job_error && !error) {
+                    error = job_error;
+                }
+                free_buffers.push_back(job.image);
+                cv.notify_all();
+            }
+        }));
+    }
+
+    MandelbrotAnimationStats stats;
+    timer total;
+    try {
+        for (unsigned int frame = 0; frame < frames.size(); ++frame) {
+            images::Image<unsigned char> *image;
+            {
+                timer stall;
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return !free_buffers.empty() || error; });
+                stats.stallSeconds += stall.elapsed();
+                if (error) {
+                    break;
+                }
+                image = free_buffers.back();
+                free_buffers.pop_back();
+            }
+
+            timer t;
+            renderer_.render(frames[frame], *image, coloring_);
+            stats.renderSeconds += t.elapsed();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                EncodeJob job = {image, frame};
+                jobs.push_back(job);
+            }
+            cv.notify_all();
+            ++stats.frames;
+        }
+    } catch (...) {
+        // потоки кодирования нужно остановить до выхода, иначе они переживут буферы
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error) {
+            error = std::current_exception();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+    }
+    cv.notify_all();
+    for (size_t t = 0; t < encoders.size(); ++t) {
+        encoders[t].join();
+    }
+    stats.seconds = total.elapsed();
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return stats;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "mandelbrot.h"
+
+#include <string>
+#include <vector>
+
+
+// Пролет от вида from к виду to за frames кадров: ширина области меняется экспоненциально (зум с постоянной скоростью),
+// а центр сдвигается пропорционально изменению ширины - так точка to остается на месте экрана и к ней как бы подлетаешь
+std::vector<MandelbrotView> mandelbrotFlyThrough(const MandelbrotView &from, const MandelbrotView &to, unsigned int frames);
+
+struct MandelbrotAnimationStats {
+    unsigned int frames;
+    double seconds;             // от начала рендера первого кадра до сохранения последнего
+    double renderSeconds;       // рендер кадров и чтение их с видеокарты
+    double stallSeconds;        // ожидание свободного буфера кадра - кодирование не успевает за видеокартой
+
+    MandelbrotAnimationStats() : frames(0), seconds(0.0), renderSeconds(0.0), stallSeconds(0.0) {}
+
+    double fps() const          { return seconds > 0.0 ? frames / seconds : 0.0; }
+};
+
+// Рисует последовательность кадров в файлы. Кодирование PNG/JPEG через CImg идет долго и целиком на процессоре,
+// поэтому кадры сохраняются пулом потоков, а вызывающий поток (в нем должен быть активирован контекст) тем временем
+// рисует на видеокарте следующий кадр. Кадров в памяти одновременно не больше framesInFlight - когда все буферы
+// ждут кодирования, рендер ждет освобождения буфера.
+class MandelbrotAnimationRenderer {
+public:
+    // encoderThreads = 0 - по числу ядер процессора без одного, занятого рендером;
+    // framesInFlight = 0 - по одному кадру на поток кодирования и еще два: рисуемый и ждущий в очереди
+    explicit MandelbrotAnimationRenderer(unsigned int encoderThreads = 0, unsigned int framesInFlight = 0);
+
+    unsigned int encoderThreads() const                 { return encoderThreads_;   }
+    unsigned int framesInFlight() const                 { return framesInFlight_;   }
+
+    void setColoring(MandelbrotColoring coloring)       { coloring_ = coloring;     }
+    void setJpegQuality(int quality)                    { jpegQuality_ = quality;   }
+    MandelbrotRenderer &renderer()                      { return renderer_;         }
+
+    // filenamePattern - printf-шаблон с номером кадра, например "frame_%05d.png"; формат по расширению: .png, .jpg или .jpeg.
+    // Ошибка кодирования в любом потоке останавливает рендер и пробрасывается отсюда
+    MandelbrotAnimationStats render(const std::vector<MandelbrotView> &frames, unsigned int width, unsigned int height,
+                                    const std::string &filenamePattern);
+
+protected:
+    void save(images::Image<unsigned char> &image, const std::string &filename) const;
+
+    unsigned int encoderThreads_;
+    unsigned int framesInFlight_;
+    MandelbrotColoring coloring_;
+    int jpegQuality_;
+
+    MandelbrotRenderer renderer_;
+};